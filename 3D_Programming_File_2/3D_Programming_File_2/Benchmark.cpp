@@ -0,0 +1,1733 @@
+#include "Benchmark.h"
+#include "World.h"
+#include "Frustum.h"
+#include "MeshGenerator.h"
+#include "Lod.h"
+#include "MeshOptimizer.h"
+#include "VertexQuantization.h"
+#include "Bounds.h"
+#include "SceneFile.h"
+#include "RenderQueue.h"
+#include "TransformBatch.h"
+#include "TransformGraph.h"
+#include "SimulationThread.h"
+#include "FixedTimestep.h"
+#include "JobSystem.h"
+#include "PointTable.h"
+#include "CurveFit.h"
+#include "SimdMath.h"
+#include "MappedFile.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <gtc/matrix_transform.hpp>
+#include <gtc/constants.hpp>
+
+// Fills a store with NPCs patrolling random routes and pickups scattered over the same area
+static void spawnRandomEntities(EntityStore& npcs, CrowdRoutes& routes, EntityStore& pickups, SpatialHash& pickupIndex, size_t count, std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> coordinate(-100.0f, 100.0f);
+
+    npcs.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        glm::vec3 from(coordinate(rng), -0.2f, coordinate(rng));
+        glm::vec3 to(coordinate(rng), -0.2f, coordinate(rng));
+        npcs.create(from, 0.1f, NPC_COLOR, MESH_NPC);
+        setNpcRoute(npcs, routes, i, from, to, 1.0f);
+    }
+
+    scatterPickups(pickups, pickupIndex, count, glm::vec3(-100.0f, -0.4f, -100.0f), glm::vec3(100.0f, -0.4f, 100.0f), rng());
+}
+
+// Entity Benchmark
+// Ticks NPC movement and runs pickup collection queries for growing entity counts
+static void benchmarkEntities()
+{
+    const size_t counts[] = { 10000, 100000, 1000000 };
+    std::mt19937 rng(1234);
+
+    std::cout << std::setw(10) << "entities"
+              << std::setw(12) << "ticks"
+              << std::setw(16) << "npc ms/tick"
+              << std::setw(16) << "ns/npc"
+              << std::setw(18) << "collect ms/query"
+              << std::setw(12) << "collected" << std::endl;
+
+    for (size_t count : counts)
+    {
+        EntityStore npcs;
+        CrowdRoutes routes;
+        EntityStore pickups;
+        SpatialHash pickupIndex(COLLECT_RADIUS);
+        spawnRandomEntities(npcs, routes, pickups, pickupIndex, count, rng);
+
+        // Roughly the same amount of work for every size
+        size_t ticks = count >= 1000000 ? 20 : 20000000 / count;
+
+        BenchmarkTimer npcTimer;
+        for (size_t tick = 0; tick < ticks; ++tick)
+        {
+            updateNpcs(npcs, routes, {}, 1.0f / 60.0f);
+        }
+        double npcMs = npcTimer.elapsedMs();
+
+        const size_t queries = 20;
+        size_t collected = 0;
+        BenchmarkTimer collectTimer;
+        for (size_t query = 0; query < queries; ++query)
+        {
+            glm::vec3 center(-90.0f + 9.0f * query, -0.4f, 0.0f);
+            collected += collectPickups(pickups, pickupIndex, center, COLLECT_RADIUS);
+        }
+        double collectMs = collectTimer.elapsedMs();
+
+        std::cout << std::setw(10) << count
+                  << std::setw(12) << ticks
+                  << std::setw(16) << std::fixed << std::setprecision(4) << npcMs / ticks
+                  << std::setw(16) << std::setprecision(3) << npcMs * 1.0e6 / (double(ticks) * count)
+                  << std::setw(18) << std::setprecision(4) << collectMs / queries
+                  << std::setw(12) << collected << std::endl;
+    }
+}
+
+// Crowd Benchmark
+// NPCs walking their own looping routes of short legs, so a few of them switch
+// waypoints every tick. Compares the SIMD crowd kernel with the scalar one and
+// checks that both end up in exactly the same state.
+static void benchmarkCrowd()
+{
+    const size_t counts[] = { 10000, 100000, 1000000 };
+    const size_t waypointsPerRoute = 4;
+    std::mt19937 rng(99);
+    std::uniform_real_distribution<float> coordinate(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> leg(-3.0f, 3.0f);
+    std::uniform_real_distribution<float> speed(1.0f, 3.0f);
+
+    std::cout << SIMD_LANES_NAME << std::endl;
+    std::cout << std::setw(10) << "npcs"
+              << std::setw(12) << "ticks"
+              << std::setw(16) << "scalar ms"
+              << std::setw(16) << "simd ms"
+              << std::setw(12) << "speedup"
+              << std::setw(16) << "switches/tick" << std::endl;
+
+    for (size_t count : counts)
+    {
+        EntityStore npcs;
+        CrowdRoutes routes;
+        npcs.reserve(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            glm::vec3 waypoints[waypointsPerRoute];
+            waypoints[0] = glm::vec3(coordinate(rng), -0.2f, coordinate(rng));
+            for (size_t w = 1; w < waypointsPerRoute; ++w)
+            {
+                waypoints[w] = waypoints[w - 1] + glm::vec3(leg(rng), 0.0f, leg(rng));
+            }
+            npcs.create(waypoints[0], 0.1f, NPC_COLOR, MESH_NPC);
+            assignRoute(npcs, i, routes, routes.add(waypoints, waypointsPerRoute, speed(rng)));
+        }
+
+        size_t ticks = count >= 1000000 ? 20 : 20000000 / count;
+        EntityStore scalar = npcs;
+        EntityStore simd = npcs;
+
+        BenchmarkTimer scalarTimer;
+        for (size_t tick = 0; tick < ticks; ++tick)
+        {
+            updateCrowdScalar(scalar, routes, 0, count, 1.0f / 60.0f);
+        }
+        double scalarMs = scalarTimer.elapsedMs() / ticks;
+
+        BenchmarkTimer simdTimer;
+        for (size_t tick = 0; tick < ticks; ++tick)
+        {
+            updateCrowd(simd, routes, 0, count, 1.0f / 60.0f);
+        }
+        double simdMs = simdTimer.elapsedMs() / ticks;
+
+        if (simd.position != scalar.position || simd.velocity != scalar.velocity || simd.waypointTo != scalar.waypointTo
+            || simd.waypointIndex != scalar.waypointIndex)
+        {
+            std::cerr << "SIMD crowd update disagrees with the scalar reference" << std::endl;
+        }
+
+        // Switches in one more tick
+        EntityStore probe = simd;
+        updateCrowdScalar(probe, routes, 0, count, 1.0f / 60.0f);
+        size_t switches = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            switches += probe.waypointIndex[i] != simd.waypointIndex[i] ? 1 : 0;
+        }
+
+        std::cout << std::setw(10) << count
+                  << std::setw(12) << ticks
+                  << std::setw(16) << std::fixed << std::setprecision(4) << scalarMs
+                  << std::setw(16) << simdMs
+                  << std::setw(12) << std::setprecision(2) << scalarMs / simdMs
+                  << std::setw(16) << switches << std::endl;
+    }
+}
+
+// Linear scan the way collection worked before the spatial hash, kept as the baseline
+static size_t collectPickupsLinear(EntityStore& pickups, const glm::vec3& center, float radius)
+{
+    size_t collected = 0;
+    for (size_t i = pickups.size(); i-- > 0; )
+    {
+        if (isNear(center, pickups.position[i], radius))
+        {
+            pickups.destroyAt(i);
+            ++collected;
+        }
+    }
+    return collected;
+}
+
+// Pickup Benchmark
+// Collects pickups from fields of up to 1M spheres, once with a linear scan and
+// once through the spatial hash, walking the same path through the field
+static void benchmarkPickups()
+{
+    const size_t counts[] = { 10000, 100000, 1000000 };
+    const glm::vec3 fieldMin(-100.0f, -0.4f, -100.0f);
+    const glm::vec3 fieldMax(100.0f, -0.4f, 100.0f);
+
+    std::cout << std::setw(10) << "pickups"
+              << std::setw(12) << "queries"
+              << std::setw(16) << "build ms"
+              << std::setw(18) << "linear ms/query"
+              << std::setw(18) << "hash us/query"
+              << std::setw(12) << "collected" << std::endl;
+
+    for (size_t count : counts)
+    {
+        EntityStore linearPickups;
+        EntityStore hashedPickups;
+        SpatialHash unusedIndex(COLLECT_RADIUS);
+        SpatialHash pickupIndex(COLLECT_RADIUS);
+        scatterPickups(linearPickups, unusedIndex, count, fieldMin, fieldMax, 99);
+
+        BenchmarkTimer buildTimer;
+        scatterPickups(hashedPickups, pickupIndex, count, fieldMin, fieldMax, 99);
+        double buildMs = buildTimer.elapsedMs();
+
+        // A player sweeping diagonally across the field, collecting every step
+        const size_t linearQueries = 50;
+        const size_t hashQueries = 100000;
+        std::vector<glm::vec3> path(hashQueries);
+        for (size_t query = 0; query < hashQueries; ++query)
+        {
+            float t = static_cast<float>(query) / hashQueries;
+            path[query] = glm::mix(fieldMin, fieldMax, t);
+        }
+
+        BenchmarkTimer linearTimer;
+        for (size_t query = 0; query < linearQueries; ++query)
+        {
+            collectPickupsLinear(linearPickups, path[query * (hashQueries / linearQueries)], COLLECT_RADIUS);
+        }
+        double linearMs = linearTimer.elapsedMs();
+
+        size_t hashCollected = 0;
+        BenchmarkTimer hashTimer;
+        for (size_t query = 0; query < hashQueries; ++query)
+        {
+            hashCollected += collectPickups(hashedPickups, pickupIndex, path[query], COLLECT_RADIUS);
+        }
+        double hashMs = hashTimer.elapsedMs();
+
+        if (hashedPickups.size() != pickupIndex.size())
+        {
+            std::cerr << "Pickup index out of sync: " << pickupIndex.size() << " indexed, " << hashedPickups.size() << " alive" << std::endl;
+        }
+
+        std::cout << std::setw(10) << count
+                  << std::setw(12) << hashQueries
+                  << std::setw(16) << std::fixed << std::setprecision(2) << buildMs
+                  << std::setw(18) << std::setprecision(4) << linearMs / linearQueries
+                  << std::setw(18) << std::setprecision(4) << hashMs * 1000.0 / hashQueries
+                  << std::setw(12) << hashCollected << std::endl;
+    }
+}
+
+// Culling Benchmark
+// Frustum tests for pickups scattered around the game's outdoor camera, scalar
+// against the SIMD batch test, which must produce the same visibility list
+static void benchmarkCulling()
+{
+    const size_t counts[] = { 10000, 100000, 1000000 };
+    glm::mat4 view = glm::lookAt(glm::vec3(1.0f, 0.0f, 3.5f), glm::vec3(0.5f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
+    Frustum frustum;
+    frustum.extract(projection * view);
+
+    BoundingSphere sphereBounds;
+    sphereBounds.radius = 0.05f;
+
+    std::cout << std::setw(10) << "pickups"
+              << std::setw(12) << "visible"
+              << std::setw(16) << "scalar ms"
+              << std::setw(16) << "simd ms"
+              << std::setw(16) << "ns/sphere" << std::endl;
+
+    for (size_t count : counts)
+    {
+        EntityStore pickups;
+        SpatialHash pickupIndex(COLLECT_RADIUS);
+        scatterPickups(pickups, pickupIndex, count, glm::vec3(-50.0f, -0.4f, -50.0f), glm::vec3(50.0f, -0.4f, 50.0f), 7);
+
+        const size_t repeats = 50;
+        std::vector<uint32_t> scalarVisible;
+        std::vector<uint32_t> simdVisible;
+
+        BenchmarkTimer scalarTimer;
+        for (size_t repeat = 0; repeat < repeats; ++repeat)
+        {
+            cullSpheresScalar(frustum, pickups.position.data(), pickups.scale.data(), count, sphereBounds, scalarVisible);
+        }
+        double scalarMs = scalarTimer.elapsedMs() / repeats;
+
+        BenchmarkTimer simdTimer;
+        for (size_t repeat = 0; repeat < repeats; ++repeat)
+        {
+            cullSpheres(frustum, pickups.position.data(), pickups.scale.data(), count, sphereBounds, simdVisible);
+        }
+        double simdMs = simdTimer.elapsedMs() / repeats;
+
+        if (scalarVisible != simdVisible)
+        {
+            std::cerr << "SIMD culling disagrees with the scalar reference" << std::endl;
+        }
+
+        std::cout << std::setw(10) << count
+                  << std::setw(12) << simdVisible.size()
+                  << std::setw(16) << std::fixed << std::setprecision(4) << scalarMs
+                  << std::setw(16) << simdMs
+                  << std::setw(16) << std::setprecision(3) << simdMs * 1.0e6 / count << std::endl;
+    }
+}
+
+// Sphere generation the way createSphere used to do it, one push_back per value
+static void generateSpherePushBack(float radius, int sectors, int stacks, std::vector<float>& vertices, std::vector<uint32_t>& indices)
+{
+    for (int i = 0; i <= stacks; ++i)
+    {
+        float stackAngle = glm::pi<float>() * static_cast<float>(i) / stacks;
+        float stackRadius = radius * sin(stackAngle);
+        float stackHeight = radius * cos(stackAngle);
+        for (int j = 0; j <= sectors; ++j)
+        {
+            float sectorAngle = 2 * glm::pi<float>() * static_cast<float>(j) / sectors;
+            vertices.push_back(stackRadius * sin(sectorAngle));
+            vertices.push_back(stackHeight);
+            vertices.push_back(stackRadius * cos(sectorAngle));
+        }
+    }
+    for (int i = 0; i < stacks; ++i)
+    {
+        for (int j = 0; j < sectors; ++j)
+        {
+            int k0 = i * (sectors + 1) + j;
+            int k1 = k0 + 1;
+            int k2 = (i + 1) * (sectors + 1) + j + 1;
+            int k3 = (i + 1) * (sectors + 1) + j;
+            indices.push_back(k0);
+            indices.push_back(k1);
+            indices.push_back(k2);
+            indices.push_back(k0);
+            indices.push_back(k2);
+            indices.push_back(k3);
+        }
+    }
+}
+
+// Mesh Benchmark
+// Generation cost and size of the old sphere path against the mesh generator,
+// plus what a cached request costs
+static void benchmarkMeshes()
+{
+    const size_t repeats = 2000;
+
+    BenchmarkTimer pushBackTimer;
+    size_t oldIndexBytes = 0;
+    for (size_t repeat = 0; repeat < repeats; ++repeat)
+    {
+        std::vector<float> vertices;
+        std::vector<uint32_t> indices;
+        generateSpherePushBack(0.05f, 36, 18, vertices, indices);
+        oldIndexBytes = indices.size() * sizeof(uint32_t);
+    }
+    double pushBackUs = pushBackTimer.elapsedMs() * 1000.0 / repeats;
+
+    BenchmarkTimer generateTimer;
+    size_t newIndexBytes = 0;
+    for (size_t repeat = 0; repeat < repeats; ++repeat)
+    {
+        MeshData sphere = generateUvSphere(0.05f, 36, 18);
+        newIndexBytes = sphere.shortIndices.size() * sizeof(uint16_t) + sphere.intIndices.size() * sizeof(uint32_t);
+    }
+    double generateUs = generateTimer.elapsedMs() * 1000.0 / repeats;
+
+    BenchmarkTimer lodTimer;
+    for (size_t repeat = 0; repeat < repeats; ++repeat)
+    {
+        generateUvSphereLods(0.05f, 36, 18, 4);
+    }
+    double lodUs = lodTimer.elapsedMs() * 1000.0 / repeats;
+
+    MeshGenerator generator;
+    generator.uvSphere(0.05f, 36, 18, 4);
+    BenchmarkTimer cacheTimer;
+    size_t triangles = 0;
+    for (size_t repeat = 0; repeat < repeats; ++repeat)
+    {
+        triangles += generator.uvSphere(0.05f, 36, 18, 4)[0].triangleCount();
+    }
+    double cacheUs = cacheTimer.elapsedMs() * 1000.0 / repeats;
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "push_back sphere     " << pushBackUs << " us, " << oldIndexBytes << " index bytes" << std::endl;
+    std::cout << "generated sphere     " << generateUs << " us, " << newIndexBytes << " index bytes" << std::endl;
+    std::cout << "4-level LOD chain    " << lodUs << " us" << std::endl;
+    std::cout << "cached LOD chain     " << cacheUs << " us (" << generator.cacheHits() << " hits, "
+              << generator.cacheMisses() << " miss, " << triangles / repeats << " triangles at LOD 0)" << std::endl;
+
+    const MeshLods& icosphere = generator.icosphere(1.0f, 6, 7);
+    for (size_t level = 0; level < icosphere.size(); ++level)
+    {
+        std::cout << "icosphere LOD " << level << "      " << icosphere[level].vertexCount() << " vertices, "
+                  << icosphere[level].triangleCount() << " triangles, "
+                  << (icosphere[level].usesShortIndices() ? 16 : 32) << "-bit indices" << std::endl;
+    }
+}
+
+// LOD Benchmark
+// Selects sphere LODs for pickups in front of a camera that sways back and forth
+// a little every frame, reporting the triangle savings and how often instances
+// switch level with and without hysteresis
+static void benchmarkLod()
+{
+    const size_t count = 100000;
+    const size_t frames = 100;
+    const float minPixels[3] = { 48.0f, 20.0f, 8.0f };
+    const MeshLods sphereChain = generateUvSphereLods(0.05f, 36, 18, 4);
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1920.0f / 1080.0f, 0.1f, 100.0f);
+
+    EntityStore pickups;
+    SpatialHash pickupIndex(COLLECT_RADIUS);
+    scatterPickups(pickups, pickupIndex, count, glm::vec3(-20.0f, -0.4f, -40.0f), glm::vec3(20.0f, -0.4f, 3.0f), 11);
+    std::vector<uint32_t> visible(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        visible[i] = static_cast<uint32_t>(i);
+    }
+
+    const float hysteresisValues[] = { 0.0f, 0.15f };
+    for (float hysteresis : hysteresisValues)
+    {
+        LodSelector selector;
+        selector.setLevels(static_cast<int>(sphereChain.size()), minPixels);
+        selector.hysteresis = hysteresis;
+        LodBuckets buckets;
+        std::vector<uint8_t> lastLevel(count, 0);
+
+        size_t switches = 0;
+        size_t triangles = 0;
+        double selectMs = 0.0;
+        for (size_t frame = 0; frame < frames; ++frame)
+        {
+            float sway = (frame % 2 == 0) ? 0.0f : 0.05f;
+            glm::mat4 view = glm::lookAt(glm::vec3(1.0f, 0.0f, 3.5f + sway), glm::vec3(0.5f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+            BenchmarkTimer selectTimer;
+            selector.beginFrame(view, projection, 1080.0f);
+            selector.bucket(pickups, visible, 0.05f, buckets);
+            selectMs += selectTimer.elapsedMs();
+
+            for (int level = 0; level < selector.levelCount(); ++level)
+            {
+                triangles += buckets.count(level) * sphereChain[level].triangleCount();
+                for (size_t slot = buckets.offsets[level]; slot < buckets.offsets[level + 1]; ++slot)
+                {
+                    uint32_t index = buckets.order[slot];
+                    switches += frame > 0 && lastLevel[index] != level ? 1 : 0;
+                    lastLevel[index] = static_cast<uint8_t>(level);
+                }
+            }
+        }
+
+        std::cout << "hysteresis " << std::fixed << std::setprecision(2) << hysteresis
+                  << ": " << std::setprecision(3) << selectMs / frames << " ms/frame for " << count << " instances, "
+                  << triangles / frames << " triangles/frame vs " << count * sphereChain[0].triangleCount()
+                  << " at LOD 0, " << switches << " LOD switches" << std::endl;
+    }
+}
+
+// Mesh Optimizer Benchmark
+// Vertex cache efficiency of generated meshes before and after optimization,
+// with the original index order shuffled as a stand-in for badly authored meshes
+static void benchmarkOptimizer()
+{
+    struct NamedMesh
+    {
+        const char* name;
+        MeshData mesh;
+        bool shuffle;
+    };
+    std::vector<NamedMesh> meshes;
+    meshes.push_back({ "uv sphere 36x18", generateUvSphere(1.0f, 36, 18), false });
+    meshes.push_back({ "icosphere 4", generateIcosphere(1.0f, 4), false });
+    meshes.push_back({ "plane 64x64", generatePlane(1.0f, 1.0f, 64, 64), false });
+    meshes.push_back({ "shuffled icosphere 4", generateIcosphere(1.0f, 4), true });
+
+    std::mt19937 rng(3);
+    std::cout << std::setw(22) << "mesh"
+              << std::setw(12) << "triangles"
+              << std::setw(14) << "ACMR before"
+              << std::setw(14) << "ACMR after"
+              << std::setw(14) << "ATVR before"
+              << std::setw(14) << "ATVR after"
+              << std::setw(12) << "ms" << std::endl;
+
+    for (NamedMesh& named : meshes)
+    {
+        std::vector<float> vertices = named.mesh.vertices;
+        std::vector<uint32_t> indices(named.mesh.shortIndices.begin(), named.mesh.shortIndices.end());
+        indices.insert(indices.end(), named.mesh.intIndices.begin(), named.mesh.intIndices.end());
+        if (named.shuffle)
+        {
+            std::vector<size_t> triangles(indices.size() / 3);
+            for (size_t i = 0; i < triangles.size(); ++i)
+            {
+                triangles[i] = i;
+            }
+            std::shuffle(triangles.begin(), triangles.end(), rng);
+            std::vector<uint32_t> shuffled;
+            shuffled.reserve(indices.size());
+            for (size_t triangle : triangles)
+            {
+                shuffled.insert(shuffled.end(), indices.begin() + triangle * 3, indices.begin() + triangle * 3 + 3);
+            }
+            indices.swap(shuffled);
+        }
+
+        BenchmarkTimer timer;
+        MeshOptimizeReport report = optimizeMesh(vertices, indices);
+        double ms = timer.elapsedMs();
+
+        std::cout << std::setw(24) << named.name
+                  << std::setw(12) << indices.size() / 3
+                  << std::fixed << std::setprecision(3)
+                  << std::setw(14) << report.before.acmr
+                  << std::setw(14) << report.after.acmr
+                  << std::setw(14) << report.before.atvr
+                  << std::setw(14) << report.after.atvr
+                  << std::setw(12) << ms << std::endl;
+    }
+}
+
+static void benchmarkQuantization()
+{
+    struct NamedMesh
+    {
+        const char* name;
+        MeshData mesh;
+    };
+    std::vector<NamedMesh> meshes;
+    meshes.push_back({ "uv sphere 36x18", generateUvSphere(0.1f, 36, 18) });
+    meshes.push_back({ "icosphere 4", generateIcosphere(1.0f, 4) });
+    meshes.push_back({ "box 0.5", generateBox(glm::vec3(0.5f)) });
+    meshes.push_back({ "plane 64x64", generatePlane(4.0f, 4.0f, 64, 64) });
+
+    std::cout << std::setw(18) << "mesh"
+              << std::setw(10) << "format"
+              << std::setw(12) << "bytes"
+              << std::setw(10) << "ratio"
+              << std::setw(14) << "max error"
+              << std::setw(14) << "% of radius"
+              << std::setw(12) << "ms" << std::endl;
+
+    for (const NamedMesh& named : meshes)
+    {
+        size_t vertexCount = named.mesh.vertexCount();
+        float radius = computeBoundingSphere(named.mesh.vertices.data(), vertexCount).radius;
+        size_t floatBytes = vertexCount * vertexFormatSize(VERTEX_FLOAT3);
+        for (uint32_t format = 0; format < VERTEX_FORMAT_COUNT; ++format)
+        {
+            BenchmarkTimer timer;
+            QuantizedVertices quantized = quantizeVertices(named.mesh.vertices.data(), vertexCount, static_cast<VertexFormat>(format));
+            double ms = timer.elapsedMs();
+
+            std::cout << std::setw(18) << named.name
+                      << std::setw(10) << vertexFormatName(static_cast<VertexFormat>(format))
+                      << std::setw(12) << quantized.data.size()
+                      << std::fixed << std::setprecision(2)
+                      << std::setw(10) << static_cast<double>(floatBytes) / quantized.data.size()
+                      << std::scientific << std::setprecision(2)
+                      << std::setw(14) << quantized.bounds.maxError
+                      << std::fixed << std::setprecision(4)
+                      << std::setw(14) << 100.0 * quantized.bounds.maxError / radius
+                      << std::setprecision(3)
+                      << std::setw(12) << ms << std::endl;
+        }
+    }
+}
+
+// Scene Loading
+// Writes a ~100 MB scene, then compares mapping it and reading every byte (what
+// the GL upload does) with reading it through a stream and with parsing the same
+// placements from text. The file was just written, so this measures the load path
+// with a warm page cache; a cold load is bounded by the disk instead.
+static void benchmarkScene()
+{
+    const char* scenePath = "benchmark_scene.scn";
+    const char* textPath = "benchmark_scene.txt";
+    const size_t planeCount = 32;
+    const size_t pickupCount = 1000000;
+    const size_t textPickupCount = 100000;
+
+    SceneBuilder builder;
+    builder.optimizeMeshes = false;
+    MeshData plane = generatePlane(4.0f, 4.0f, 255, 255);
+    std::vector<uint32_t> planeIndices(plane.shortIndices.begin(), plane.shortIndices.end());
+    for (size_t i = 0; i < planeCount; ++i)
+    {
+        builder.addMesh("plane" + std::to_string(i), plane.vertices, planeIndices, VERTEX_FLOAT3);
+    }
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> coordinate(-100.0f, 100.0f);
+    std::ofstream text(textPath);
+    for (size_t i = 0; i < pickupCount; ++i)
+    {
+        SceneEntity entity = {};
+        entity.kind = SCENE_PICKUP;
+        entity.position[0] = coordinate(rng);
+        entity.position[1] = -0.4f;
+        entity.position[2] = coordinate(rng);
+        entity.scale = 1.0f;
+        builder.addEntity(entity);
+        if (i < textPickupCount)
+        {
+            text << "pickup " << entity.position[0] << ' ' << entity.position[1] << ' ' << entity.position[2] << " 1\n";
+        }
+    }
+    text.close();
+
+    BenchmarkTimer writeTimer;
+    if (!builder.write(scenePath))
+    {
+        return;
+    }
+    double writeMs = writeTimer.elapsedMs();
+
+    // Mapped: open, then touch every byte the way glBufferSubData reads it
+    BenchmarkTimer mapTimer;
+    SceneFile scene;
+    if (!scene.open(scenePath))
+    {
+        return;
+    }
+    double openMs = mapTimer.elapsedMs();
+    uint64_t checksum = 0;
+    const uint64_t* words = static_cast<const uint64_t*>(scene.vertexData());
+    for (size_t i = 0; i < scene.vertexDataSize() / sizeof(uint64_t); ++i)
+    {
+        checksum += words[i];
+    }
+    words = static_cast<const uint64_t*>(scene.indexData());
+    for (size_t i = 0; i < scene.indexDataSize() / sizeof(uint64_t); ++i)
+    {
+        checksum += words[i];
+    }
+    for (size_t i = 0; i < scene.entityCount(); ++i)
+    {
+        checksum += static_cast<uint64_t>(scene.entityData()[i].position[0]);
+    }
+    double mappedMs = mapTimer.elapsedMs();
+    double megabytes = scene.fileSize() / (1024.0 * 1024.0);
+    scene.close();
+
+    // Stream: read the whole file into memory
+    BenchmarkTimer streamTimer;
+    std::ifstream file(scenePath, std::ios::binary);
+    std::vector<char> bytes(static_cast<size_t>(megabytes * 1024.0 * 1024.0 + 0.5));
+    file.read(bytes.data(), bytes.size());
+    double streamMs = streamTimer.elapsedMs();
+
+    // Text: parse a tenth of the placements
+    BenchmarkTimer textTimer;
+    compileSceneText(textPath, scenePath);
+    double textMs = textTimer.elapsedMs();
+
+    std::remove(scenePath);
+    std::remove(textPath);
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "scene file   " << megabytes << " MB, " << planeCount << " meshes, " << pickupCount << " entities, written in " << writeMs << " ms\n"
+              << "mapped       open " << openMs << " ms, read all " << mappedMs << " ms (" << megabytes / (mappedMs / 1000.0) << " MB/s)\n"
+              << "stream read  " << streamMs << " ms (" << megabytes / (streamMs / 1000.0) << " MB/s)\n"
+              << "text parse   " << textPickupCount << " placements in " << textMs << " ms, "
+              << textMs * pickupCount / textPickupCount << " ms projected for " << pickupCount << std::endl;
+    std::cout << "checksum " << checksum << std::endl;
+}
+
+// Render Queue
+// Draws recorded in a random order, as a scene with many objects would record
+// them, then sorted by key with the radix sort and with std::sort
+static void benchmarkRenderQueue()
+{
+    const size_t drawCounts[] = { 1000, 10000, 100000 };
+    const int repeats = 20;
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<uint32_t> program(0, 1);
+    std::uniform_int_distribution<uint32_t> format(0, 3);
+    std::uniform_int_distribution<uint32_t> mesh(0, 63);
+    std::uniform_int_distribution<uint32_t> material(0, 15);
+    std::uniform_real_distribution<float> depth(0.0f, 1.0f);
+
+    std::cout << std::setw(10) << "draws"
+              << std::setw(14) << "radix ms"
+              << std::setw(14) << "std::sort ms"
+              << std::setw(18) << "changes before"
+              << std::setw(16) << "changes after" << std::endl;
+
+    for (size_t count : drawCounts)
+    {
+        std::vector<uint64_t> recorded(count);
+        for (uint64_t& key : recorded)
+        {
+            key = makeSortKey(RENDER_PASS_OPAQUE, program(rng), format(rng), mesh(rng), static_cast<uint16_t>(material(rng)), depth(rng));
+        }
+
+        std::vector<uint64_t> keys, scratchKeys;
+        std::vector<uint32_t> values, scratchValues;
+        BenchmarkTimer radixTimer;
+        for (int repeat = 0; repeat < repeats; ++repeat)
+        {
+            keys = recorded;
+            values.resize(count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                values[i] = static_cast<uint32_t>(i);
+            }
+            radixSortKeys(keys, values, scratchKeys, scratchValues);
+        }
+        double radixMs = radixTimer.elapsedMs() / repeats;
+
+        std::vector<std::pair<uint64_t, uint32_t>> pairs(count);
+        BenchmarkTimer stdTimer;
+        for (int repeat = 0; repeat < repeats; ++repeat)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                pairs[i] = std::make_pair(recorded[i], static_cast<uint32_t>(i));
+            }
+            std::sort(pairs.begin(), pairs.end());
+        }
+        double stdMs = stdTimer.elapsedMs() / repeats;
+
+        bool matches = true;
+        for (size_t i = 0; i < count; ++i)
+        {
+            matches = matches && keys[i] == pairs[i].first && recorded[values[i]] == keys[i];
+        }
+
+        std::cout << std::setw(10) << count
+                  << std::fixed << std::setprecision(3)
+                  << std::setw(14) << radixMs
+                  << std::setw(14) << stdMs
+                  << std::setw(18) << countStateChanges(recorded.data(), count).total()
+                  << std::setw(16) << countStateChanges(keys.data(), count).total()
+                  << (matches ? "" : "  MISMATCH") << std::endl;
+    }
+
+    // Material Table
+    // One color per draw, as per-sphere draws of a scene with colored pickups
+    // record them, past the number of material ids a key can hold
+    const size_t colorCounts[] = { 1000, 65534, 100000 };
+    std::cout << std::setw(10) << "colors" << std::setw(14) << "record ms" << std::setw(12) << "materials"
+              << std::setw(12) << "overflow" << std::endl;
+    for (size_t count : colorCounts)
+    {
+        RenderQueue queue;
+        queue.begin(glm::mat4(1.0f), 100.0f);
+        BenchmarkTimer recordTimer;
+        for (size_t i = 0; i < count; ++i)
+        {
+            glm::vec4 color(static_cast<float>(i % 256) / 255.0f, static_cast<float>(i / 256 % 256) / 255.0f, static_cast<float>(i / 65536) / 255.0f, 1.0f);
+            queue.draw(RENDER_PASS_OPAQUE, 0, 0, 0, color, glm::mat4(1.0f));
+        }
+        double recordMs = recordTimer.elapsedMs();
+
+        // Every color gets its own id until the table is full, the rest overflow
+        size_t overflow = 0;
+        std::vector<uint8_t> seen(queue.materialCount(), 0);
+        bool matches = true;
+        for (size_t i = 0; i < queue.size(); ++i)
+        {
+            uint16_t material = sortKeyMaterial(queue.key(i));
+            if (material == RENDER_OVERFLOW_MATERIAL)
+            {
+                ++overflow;
+                continue;
+            }
+            matches = matches && material < queue.materialCount() && !seen[material];
+            if (matches)
+            {
+                seen[material] = 1;
+            }
+        }
+        matches = matches && queue.materialCount() == std::min<size_t>(count, RENDER_MAX_MATERIALS)
+            && overflow == count - queue.materialCount();
+
+        std::cout << std::setw(10) << count
+                  << std::fixed << std::setprecision(3)
+                  << std::setw(14) << recordMs
+                  << std::setw(12) << queue.materialCount()
+                  << std::setw(12) << overflow
+                  << (matches ? "" : "  MISMATCH") << std::endl;
+    }
+}
+
+// Largest difference between any two matching matrix entries
+static float maxMatrixDifference(const std::vector<glm::mat4>& a, const std::vector<glm::mat4>& b)
+{
+    float difference = 0.0f;
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            for (int r = 0; r < 4; ++r)
+            {
+                difference = std::max(difference, std::abs(a[i][c][r] - b[i][c][r]));
+            }
+        }
+    }
+    return difference;
+}
+
+// Batch Transforms
+// Final MVP matrices for the visible pickups: first the way the render loop
+// used to build each model, glm::translate and glm::scale on an identity
+// followed by the view-projection product, then the batch kernels. The
+// general batch multiplies directly built models; the instance kernel skips
+// the models entirely. Differences are against the chained version.
+static void benchmarkTransforms()
+{
+    const size_t counts[] = { 10000, 100000, 1000000 };
+    const size_t repeats = 20;
+    glm::mat4 view = glm::lookAt(glm::vec3(1.0f, 0.0f, 3.5f), glm::vec3(0.5f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
+    glm::mat4 viewProjection = projection * view;
+    Frustum frustum;
+    frustum.extract(viewProjection);
+
+    BoundingSphere sphereBounds;
+    sphereBounds.radius = 0.05f;
+
+    std::cout << std::setw(10) << "pickups"
+              << std::setw(10) << "visible"
+              << std::setw(14) << "chained ms"
+              << std::setw(14) << "batch ms"
+              << std::setw(16) << "instance ms"
+              << std::setw(18) << "instance simd ms"
+              << std::setw(14) << "ns/instance"
+              << std::setw(14) << "max diff" << std::endl;
+
+    for (size_t count : counts)
+    {
+        EntityStore pickups;
+        SpatialHash pickupIndex(COLLECT_RADIUS);
+        scatterPickups(pickups, pickupIndex, count, glm::vec3(-50.0f, -0.4f, -50.0f), glm::vec3(50.0f, -0.4f, 50.0f), 7);
+        std::vector<uint32_t> visible;
+        cullSpheres(frustum, pickups.position.data(), pickups.scale.data(), count, sphereBounds, visible);
+        size_t visibleCount = visible.size();
+
+        std::vector<glm::mat4> chained(visibleCount);
+        BenchmarkTimer chainedTimer;
+        for (size_t repeat = 0; repeat < repeats; ++repeat)
+        {
+            for (size_t i = 0; i < visibleCount; ++i)
+            {
+                uint32_t index = visible[i];
+                glm::mat4 model = glm::mat4(1.0f);
+                model = glm::translate(model, pickups.position[index]);
+                model = glm::scale(model, glm::vec3(pickups.scale[index]));
+                chained[i] = viewProjection * model;
+            }
+        }
+        double chainedMs = chainedTimer.elapsedMs() / repeats;
+
+        std::vector<glm::mat4> models(visibleCount);
+        std::vector<glm::mat4> batch(visibleCount);
+        BenchmarkTimer batchTimer;
+        for (size_t repeat = 0; repeat < repeats; ++repeat)
+        {
+            for (size_t i = 0; i < visibleCount; ++i)
+            {
+                models[i] = translateScale(pickups.position[visible[i]], pickups.scale[visible[i]]);
+            }
+            multiplyMatrices(viewProjection, models.data(), batch.data(), visibleCount);
+        }
+        double batchMs = batchTimer.elapsedMs() / repeats;
+
+        std::vector<glm::mat4> scalar(visibleCount);
+        BenchmarkTimer scalarTimer;
+        for (size_t repeat = 0; repeat < repeats; ++repeat)
+        {
+            computeInstanceMvpsScalar(viewProjection, pickups.position.data(), pickups.scale.data(), visible.data(), visibleCount, scalar.data());
+        }
+        double scalarMs = scalarTimer.elapsedMs() / repeats;
+
+        std::vector<glm::mat4> simd(visibleCount);
+        BenchmarkTimer simdTimer;
+        for (size_t repeat = 0; repeat < repeats; ++repeat)
+        {
+            computeInstanceMvps(viewProjection, pickups.position.data(), pickups.scale.data(), visible.data(), visibleCount, simd.data());
+        }
+        double simdMs = simdTimer.elapsedMs() / repeats;
+
+        if (maxMatrixDifference(scalar, simd) != 0.0f)
+        {
+            std::cerr << "SIMD instance MVPs disagree with the scalar reference" << std::endl;
+        }
+
+        std::cout << std::setw(10) << count
+                  << std::setw(10) << visibleCount
+                  << std::fixed << std::setprecision(3)
+                  << std::setw(14) << chainedMs
+                  << std::setw(14) << batchMs
+                  << std::setw(16) << scalarMs
+                  << std::setw(18) << simdMs
+                  << std::setw(14) << simdMs * 1.0e6 / std::max<size_t>(visibleCount, 1)
+                  << std::setw(14) << std::scientific << std::setprecision(2)
+                  << std::max(maxMatrixDifference(chained, batch), maxMatrixDifference(chained, simd))
+                  << std::defaultfloat << std::endl;
+    }
+}
+
+// Transform Hierarchy
+// 100k nodes in objects of about a hundred nodes each, every object a random
+// tree under its root, with 1% of the nodes moved every frame. Compares the
+// dirty-subtree pass with recomputing every world matrix, and checks that both
+// end on the same matrices.
+static void benchmarkHierarchy()
+{
+    const size_t nodeCount = 100000;
+    const size_t nodesPerObject = 100;
+    const size_t dirtyPerFrame = nodeCount / 100;
+    const size_t frames = 200;
+    std::mt19937 rng(24);
+    std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+    std::uniform_int_distribution<uint32_t> anyNode(0, static_cast<uint32_t>(nodeCount - 1));
+
+    auto randomLocal = [&]()
+    {
+        glm::mat4 local = glm::translate(glm::mat4(1.0f), glm::vec3(offset(rng), offset(rng), offset(rng)));
+        return glm::rotate(local, offset(rng), glm::vec3(0.0f, 1.0f, 0.0f));
+    };
+
+    TransformGraph graph;
+    uint32_t root = 0;
+    for (size_t i = 0; i < nodeCount; ++i)
+    {
+        uint32_t node = static_cast<uint32_t>(i);
+        if (i % nodesPerObject == 0)
+        {
+            root = node;
+            graph.add(TRANSFORM_NO_PARENT, randomLocal());
+        }
+        else
+        {
+            graph.add(root + static_cast<uint32_t>(rng() % (node - root)), randomLocal());
+        }
+    }
+    graph.updateAll();
+    TransformGraph full = graph;
+
+    // The same moves for both runs
+    std::vector<uint32_t> moved(frames * dirtyPerFrame);
+    std::vector<glm::mat4> moves(moved.size());
+    for (size_t i = 0; i < moved.size(); ++i)
+    {
+        moved[i] = anyNode(rng);
+        moves[i] = randomLocal();
+    }
+
+    BenchmarkTimer fullTimer;
+    for (size_t frame = 0; frame < frames; ++frame)
+    {
+        for (size_t i = frame * dirtyPerFrame; i < (frame + 1) * dirtyPerFrame; ++i)
+        {
+            full.setLocal(moved[i], moves[i]);
+        }
+        full.updateAll();
+    }
+    double fullMs = fullTimer.elapsedMs() / frames;
+
+    size_t recomputed = 0;
+    BenchmarkTimer dirtyTimer;
+    for (size_t frame = 0; frame < frames; ++frame)
+    {
+        for (size_t i = frame * dirtyPerFrame; i < (frame + 1) * dirtyPerFrame; ++i)
+        {
+            graph.setLocal(moved[i], moves[i]);
+        }
+        recomputed += graph.update();
+    }
+    double dirtyMs = dirtyTimer.elapsedMs() / frames;
+
+    bool matches = true;
+    for (uint32_t node = 0; node < nodeCount; ++node)
+    {
+        matches = matches && graph.world(node) == full.world(node);
+    }
+
+    std::cout << std::setw(10) << "nodes"
+              << std::setw(14) << "dirty/frame"
+              << std::setw(20) << "recomputed/frame"
+              << std::setw(16) << "full ms"
+              << std::setw(16) << "dirty ms" << std::endl;
+    std::cout << std::setw(10) << nodeCount
+              << std::setw(14) << dirtyPerFrame
+              << std::setw(20) << recomputed / frames
+              << std::fixed << std::setprecision(3)
+              << std::setw(16) << fullMs
+              << std::setw(16) << dirtyMs
+              << (matches ? "" : "  MISMATCH") << std::endl;
+}
+
+// Simulation Thread
+// A render loop whose buffer swap takes 50 ms, first running the simulation
+// inline as the game used to, then on the simulation thread. Inline, ticks
+// bunch up behind every swap; threaded, they keep their 60 Hz spacing.
+static void benchmarkSimulation()
+{
+    const double tickRate = 60.0;
+    const double runSeconds = 2.0;
+    const std::chrono::milliseconds swapTime(50);
+    const size_t pickupCount = 100000;
+
+    std::cout << std::setw(10) << "mode"
+              << std::setw(10) << "ticks/s"
+              << std::setw(16) << "ticks/batch"
+              << std::setw(18) << "max gap ms"
+              << std::setw(12) << "frames" << std::endl;
+
+    // Inline
+    {
+        World world;
+        initWorld(world);
+        scatterPickups(world.pickups, world.pickupIndex, pickupCount, glm::vec3(-2.0f, -0.4f, -2.0f), glm::vec3(2.0f, -0.4f, 3.0f), 42);
+        FixedTimestep timestep;
+        timestep.setTickRate(tickRate);
+        SimulationStats stats;
+        size_t frames = 0;
+        double start = SimulationThread::clockSeconds();
+        double last = start;
+        double lastBatch = 0.0;
+        while (last - start < runSeconds)
+        {
+            double now = SimulationThread::clockSeconds();
+            int ticks = timestep.advance(now - last);
+            last = now;
+            for (int tick = 0; tick < ticks; ++tick)
+            {
+                tickWorld(world, InputState(), static_cast<float>(timestep.tickSeconds));
+            }
+            if (ticks > 0)
+            {
+                stats.maxBatchGapMs = lastBatch > 0.0 ? std::max(stats.maxBatchGapMs, (now - lastBatch) * 1000.0) : 0.0;
+                lastBatch = now;
+                stats.ticks += ticks;
+                stats.batches += 1;
+            }
+            std::this_thread::sleep_for(swapTime);
+            ++frames;
+        }
+        std::cout << std::setw(10) << "inline"
+                  << std::fixed << std::setprecision(1)
+                  << std::setw(10) << stats.ticks / runSeconds
+                  << std::setw(16) << static_cast<double>(stats.ticks) / stats.batches
+                  << std::setw(18) << stats.maxBatchGapMs
+                  << std::setw(12) << frames << std::endl;
+    }
+
+    // Threaded
+    {
+        World world;
+        initWorld(world);
+        scatterPickups(world.pickups, world.pickupIndex, pickupCount, glm::vec3(-2.0f, -0.4f, -2.0f), glm::vec3(2.0f, -0.4f, 3.0f), 42);
+        SimulationThread simulation;
+        size_t frames = 0;
+        size_t pickupsSeen = 0;
+        double start = SimulationThread::clockSeconds();
+        simulation.start(world, tickRate);
+        while (SimulationThread::clockSeconds() - start < runSeconds)
+        {
+            simulation.submitInput(InputState());
+            pickupsSeen += simulation.latestSnapshot().pickups.size();
+            std::this_thread::sleep_for(swapTime);
+            ++frames;
+        }
+        simulation.stop();
+        SimulationStats stats = simulation.stats();
+        std::cout << std::setw(10) << "threaded"
+                  << std::fixed << std::setprecision(1)
+                  << std::setw(10) << stats.ticks / runSeconds
+                  << std::setw(16) << static_cast<double>(stats.ticks) / stats.batches
+                  << std::setw(18) << stats.maxBatchGapMs
+                  << std::setw(12) << frames << std::endl;
+        std::cout << "snapshot cost " << std::setprecision(3) << stats.simulationMs / stats.batches
+                  << " ms/batch including the tick, " << pickupsSeen / frames << " pickups per snapshot" << std::endl;
+    }
+}
+
+// Job System Benchmark
+// One frame of per-entity work as a job graph: NPC updates run alongside
+// culling, and LOD selection starts once culling is done. Runs serially first,
+// then on growing worker counts, and checks every run against the serial one.
+struct JobFrame
+{
+    EntityStore npcs;
+    const CrowdRoutes* routes;
+    std::vector<uint32_t> visible;
+    std::vector<std::vector<uint32_t>> chunkVisible;
+    LodSelector selector;
+    LodBuckets buckets;
+};
+
+static void runJobFrame(JobFrame& frame, JobSystem* jobs, const EntityStore& pickups, const Frustum& frustum,
+    const BoundingSphere& bounds, const glm::mat4& view, const glm::mat4& projection)
+{
+    const float deltaTime = 1.0f / 60.0f;
+    frame.selector.beginFrame(view, projection, 1080.0f);
+    if (!jobs)
+    {
+        updateNpcs(frame.npcs, *frame.routes, {}, deltaTime);
+        cullSpheres(frustum, pickups.position.data(), pickups.scale.data(), pickups.size(), bounds, frame.visible);
+        frame.selector.bucket(pickups, frame.visible, bounds.radius, frame.buckets);
+        return;
+    }
+
+    JobCounter moved;
+    JobCounter culled;
+    JobCounter selected;
+    jobs->run(moved, [&frame, jobs, deltaTime]() { updateNpcs(frame.npcs, *frame.routes, {}, deltaTime, jobs); });
+    jobs->run(culled, [&]()
+    {
+        cullSpheresParallel(*jobs, frustum, pickups.position.data(), pickups.scale.data(), pickups.size(), bounds,
+            frame.visible, frame.chunkVisible);
+    });
+    jobs->runAfter(culled, selected, [&]() { frame.selector.bucket(pickups, frame.visible, bounds.radius, frame.buckets, jobs); });
+    jobs->wait(moved);
+    jobs->wait(selected);
+}
+
+static void benchmarkJobs()
+{
+    const size_t count = 1000000;
+    const size_t frames = 20;
+    const float minPixels[3] = { 48.0f, 20.0f, 8.0f };
+    size_t hardware = std::max<unsigned>(std::thread::hardware_concurrency(), 1);
+
+    std::mt19937 rng(5);
+    EntityStore npcs;
+    CrowdRoutes routes;
+    EntityStore pickups;
+    SpatialHash pickupIndex(COLLECT_RADIUS);
+    spawnRandomEntities(npcs, routes, pickups, pickupIndex, count, rng);
+
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 5.0f, 60.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1920.0f / 1080.0f, 0.1f, 100.0f);
+    Frustum frustum;
+    frustum.extract(projection * view);
+    BoundingSphere bounds;
+    bounds.radius = 0.05f;
+
+    std::cout << count << " NPCs and " << count << " pickups, " << hardware << " hardware threads" << std::endl;
+    std::cout << std::setw(10) << "threads"
+              << std::setw(12) << "ms/frame"
+              << std::setw(12) << "speedup"
+              << std::setw(14) << "efficiency"
+              << std::setw(16) << "worker busy"
+              << std::setw(12) << "steals" << std::endl;
+
+    // Serial reference
+    JobFrame reference;
+    reference.npcs = npcs;
+    reference.routes = &routes;
+    reference.selector.setLevels(3, minPixels);
+    BenchmarkTimer serialTimer;
+    for (size_t frame = 0; frame < frames; ++frame)
+    {
+        runJobFrame(reference, nullptr, pickups, frustum, bounds, view, projection);
+    }
+    double serialMs = serialTimer.elapsedMs() / frames;
+    std::cout << std::setw(10) << "serial"
+              << std::fixed << std::setprecision(3)
+              << std::setw(12) << serialMs << std::endl;
+
+    // At least one worker, so stealing is exercised on single-core machines too
+    size_t maxWorkers = std::max<size_t>(hardware - 1, 1);
+    for (size_t workers = 1; workers <= maxWorkers; workers = workers < 4 ? workers + 1 : workers * 2)
+    {
+        JobSystem jobs(workers);
+        jobs.registerThread();
+        JobFrame run;
+        run.npcs = npcs;
+        run.routes = &routes;
+        run.selector.setLevels(3, minPixels);
+
+        std::vector<WorkerUtilization> utilization;
+        jobs.sampleUtilization(utilization);
+        BenchmarkTimer timer;
+        for (size_t frame = 0; frame < frames; ++frame)
+        {
+            runJobFrame(run, &jobs, pickups, frustum, bounds, view, projection);
+        }
+        double ms = timer.elapsedMs() / frames;
+        jobs.sampleUtilization(utilization);
+
+        float busy = 0.0f;
+        uint64_t steals = 0;
+        for (const WorkerUtilization& worker : utilization)
+        {
+            busy += worker.busy / utilization.size();
+            steals += worker.steals;
+        }
+
+        if (run.npcs.position != reference.npcs.position || run.visible != reference.visible || run.buckets.order != reference.buckets.order)
+        {
+            std::cerr << "Job results differ from the serial run with " << workers << " workers" << std::endl;
+        }
+
+        size_t threads = jobs.concurrency();
+        std::cout << std::setw(10) << threads
+                  << std::setw(12) << ms
+                  << std::setw(12) << std::setprecision(2) << serialMs / ms
+                  << std::setw(13) << std::setprecision(0) << 100.0 * serialMs / ms / threads << "%"
+                  << std::setw(15) << 100.0f * busy << "%"
+                  << std::setw(12) << steals / frames << std::setprecision(3) << std::endl;
+    }
+
+    // Overhead of an empty job, started and waited for in batches
+    {
+        JobSystem jobs(1);
+        jobs.registerThread();
+        const size_t batches = 1000;
+        const size_t batchSize = 1000;
+        BenchmarkTimer timer;
+        for (size_t batch = 0; batch < batches; ++batch)
+        {
+            JobCounter counter;
+            for (size_t i = 0; i < batchSize; ++i)
+            {
+                jobs.run(counter, []() {});
+            }
+            jobs.wait(counter);
+        }
+        std::cout << "empty job " << std::setprecision(1) << timer.elapsedMs() * 1.0e6 / (batches * batchSize) << " ns" << std::endl;
+    }
+}
+
+// Nodes reachable from the first open node of the biggest open area
+static void largestComponent(const NavGraph& graph, std::vector<uint32_t>& nodes)
+{
+    std::vector<uint32_t> component(graph.nodeCount(), NO_NAV_NODE);
+    std::vector<uint32_t> members;
+    nodes.clear();
+    for (uint32_t seed = 0; seed < graph.nodeCount(); ++seed)
+    {
+        if (component[seed] != NO_NAV_NODE || graph.edgeBegin(seed) == graph.edgeEnd(seed))
+        {
+            continue;
+        }
+        members.assign(1, seed);
+        component[seed] = seed;
+        for (size_t i = 0; i < members.size(); ++i)
+        {
+            for (uint32_t edge = graph.edgeBegin(members[i]); edge < graph.edgeEnd(members[i]); ++edge)
+            {
+                uint32_t next = graph.edgeTarget(edge);
+                if (component[next] == NO_NAV_NODE)
+                {
+                    component[next] = seed;
+                    members.push_back(next);
+                }
+            }
+        }
+        if (members.size() > nodes.size())
+        {
+            nodes.swap(members);
+        }
+    }
+}
+
+static void benchmarkPaths()
+{
+    const size_t side = 224;
+    const size_t requestCount = 10000;
+    const size_t hotPairs = 256;
+    const float hotShare = 0.3f;
+    const float maxDistance = 40.0f;
+    const size_t cacheCapacity = 4096;
+    size_t hardware = std::max<unsigned>(std::thread::hardware_concurrency(), 1);
+
+    // Grid with random walls and rooms blocked out
+    std::mt19937 rng(19);
+    std::vector<uint8_t> blocked(side * side, 0);
+    std::uniform_int_distribution<size_t> corner(0, side - 1);
+    std::uniform_int_distribution<size_t> extent(2, 12);
+    for (size_t i = 0; i < 400; ++i)
+    {
+        size_t column = corner(rng);
+        size_t row = corner(rng);
+        size_t width = extent(rng);
+        size_t height = extent(rng) / 4 + 1;
+        if (i % 2)
+        {
+            std::swap(width, height);
+        }
+        for (size_t r = row; r < std::min(row + height, side); ++r)
+        {
+            for (size_t c = column; c < std::min(column + width, side); ++c)
+            {
+                blocked[r * side + c] = 1;
+            }
+        }
+    }
+    NavGraph graph;
+    BenchmarkTimer buildTimer;
+    buildGridGraph(graph, glm::vec3(0.0f), 1.0f, side, side, &blocked);
+    double buildMs = buildTimer.elapsedMs();
+
+    std::vector<uint32_t> reachable;
+    largestComponent(graph, reachable);
+    std::cout << graph.nodeCount() << " nodes, " << graph.edgeCount() / 2 << " edges, " << reachable.size()
+              << " in the largest area, built in " << std::fixed << std::setprecision(2) << buildMs << " ms" << std::endl;
+
+    // Mostly nearby goals, with a share of requests repeating a small set of popular pairs
+    std::uniform_int_distribution<size_t> pick(0, reachable.size() - 1);
+    auto randomRequest = [&]()
+    {
+        PathRequest request;
+        request.start = reachable[pick(rng)];
+        do
+        {
+            request.goal = reachable[pick(rng)];
+        } while (glm::distance(graph.position(request.start), graph.position(request.goal)) > maxDistance);
+        return request;
+    };
+    std::vector<PathRequest> hot(hotPairs);
+    for (PathRequest& request : hot)
+    {
+        request = randomRequest();
+    }
+    std::uniform_real_distribution<float> share(0.0f, 1.0f);
+    std::uniform_int_distribution<size_t> pickHot(0, hotPairs - 1);
+    std::vector<PathRequest> requests(requestCount);
+    for (PathRequest& request : requests)
+    {
+        request = share(rng) < hotShare ? hot[pickHot(rng)] : randomRequest();
+    }
+
+    // Every request searched from scratch
+    PathSolver solver(graph);
+    std::vector<uint32_t> path;
+    size_t expanded = 0;
+    size_t found = 0;
+    BenchmarkTimer solverTimer;
+    for (const PathRequest& request : requests)
+    {
+        found += solver.find(request.start, request.goal, path) ? 1 : 0;
+        expanded += solver.expanded();
+    }
+    double solverMs = solverTimer.elapsedMs();
+    std::cout << "A* " << std::setprecision(4) << solverMs / requestCount << " ms/request, "
+              << expanded / requestCount << " nodes expanded, " << found << "/" << requestCount << " found" << std::endl;
+
+    std::cout << std::setw(10) << "threads"
+              << std::setw(16) << "ms/10k req"
+              << std::setw(12) << "speedup"
+              << std::setw(12) << "hit rate"
+              << std::setw(18) << "core % @10k/s" << std::endl;
+
+    // Through the planner, serial and then batched over the job system
+    std::vector<PathResult> reference;
+    PathPlanner serialPlanner(graph, cacheCapacity);
+    BenchmarkTimer serialTimer;
+    serialPlanner.findBatch(requests, reference);
+    double serialMs = serialTimer.elapsedMs() * 10000.0 / requestCount;
+    PathPlannerStats serialStats = serialPlanner.stats();
+    std::cout << std::setw(10) << "serial"
+              << std::setw(16) << std::setprecision(2) << serialMs
+              << std::setw(12) << 1.0
+              << std::setw(11) << 100.0 * serialStats.cacheHits / serialStats.requests << "%"
+              << std::setw(17) << serialMs / 10.0 << "%" << std::endl;
+
+    size_t maxWorkers = std::max<size_t>(hardware - 1, 1);
+    for (size_t workers = 1; workers <= maxWorkers; workers = workers < 4 ? workers + 1 : workers * 2)
+    {
+        JobSystem jobs(workers);
+        jobs.registerThread();
+        PathPlanner planner(graph, cacheCapacity);
+        std::vector<PathResult> results;
+        BenchmarkTimer timer;
+        planner.findBatch(requests, results, &jobs);
+        double ms = timer.elapsedMs() * 10000.0 / requestCount;
+        PathPlannerStats stats = planner.stats();
+
+        for (size_t i = 0; i < requests.size(); ++i)
+        {
+            if (results[i].found != reference[i].found || results[i].path != reference[i].path)
+            {
+                std::cerr << "Batched path " << i << " differs from the serial planner with " << workers << " workers" << std::endl;
+                break;
+            }
+        }
+
+        // CPU time summed over threads is at most wall time times threads
+        size_t threads = jobs.concurrency();
+        std::cout << std::setw(10) << threads
+                  << std::setw(16) << ms
+                  << std::setw(12) << serialMs / ms
+                  << std::setw(11) << 100.0 * stats.cacheHits / stats.requests << "%"
+                  << std::setw(17) << ms * threads / 10.0 << "%" << std::endl;
+    }
+}
+
+// Point Files
+// Writes ~100 MB of "x y" rows in the format of interpolated_points.txt and
+// loads it with a stream, with from_chars on one thread and on the job system,
+// and from the columnar cache. Reading every byte of the mapped file is the
+// bandwidth the parsers are measured against; the file was just written, so
+// that is the page cache rather than the disk.
+static void benchmarkPoints()
+{
+    const char* textPath = "benchmark_points.txt";
+    const size_t rowCount = 5000000;
+    size_t hardware = std::max<unsigned>(std::thread::hardware_concurrency(), 1);
+
+    {
+        std::mt19937 rng(21);
+        std::uniform_real_distribution<float> coordinate(-1000.0f, 1000.0f);
+        std::ofstream text(textPath, std::ios::binary);
+        std::vector<char> buffer;
+        char line[64];
+        for (size_t i = 0; i < rowCount; ++i)
+        {
+            int length = std::snprintf(line, sizeof(line), "%.4f %.6f\n", coordinate(rng), coordinate(rng) * 0.001f);
+            buffer.insert(buffer.end(), line, line + length);
+            if (buffer.size() > (1 << 20) || i + 1 == rowCount)
+            {
+                text.write(buffer.data(), buffer.size());
+                buffer.clear();
+            }
+        }
+    }
+    std::remove(pointCachePath(textPath).c_str());
+
+    // Every byte of the mapped text
+    MappedFile file;
+    if (!file.open(textPath))
+    {
+        return;
+    }
+    double megabytes = file.size() / (1024.0 * 1024.0);
+    BenchmarkTimer touchTimer;
+    uint64_t checksum = 0;
+    const uint64_t* words = reinterpret_cast<const uint64_t*>(file.data());
+    for (size_t i = 0; i < file.size() / sizeof(uint64_t); ++i)
+    {
+        checksum += words[i];
+    }
+    double touchMs = touchTimer.elapsedMs();
+    file.close();
+
+    // Stream extraction, the way text files are read elsewhere in the project
+    BenchmarkTimer streamTimer;
+    std::ifstream stream(textPath);
+    std::vector<float> streamX;
+    std::vector<float> streamY;
+    streamX.reserve(rowCount);
+    streamY.reserve(rowCount);
+    float x;
+    float y;
+    while (stream >> x >> y)
+    {
+        streamX.push_back(x);
+        streamY.push_back(y);
+    }
+    double streamMs = streamTimer.elapsedMs();
+
+    PointTable reference;
+    BenchmarkTimer serialTimer;
+    readPointFile(textPath, reference);
+    double serialMs = serialTimer.elapsedMs();
+    if (reference.rowCount != rowCount || std::vector<float>(reference.column(0), reference.column(0) + rowCount) != streamX
+        || std::vector<float>(reference.column(1), reference.column(1) + rowCount) != streamY)
+    {
+        std::cerr << "from_chars and stream parsing disagree" << std::endl;
+    }
+
+    auto rate = [megabytes](double ms) { return megabytes / (ms / 1000.0); };
+    std::cout << std::fixed << std::setprecision(2)
+              << rowCount << " rows, " << megabytes << " MB, " << hardware << " hardware threads\n"
+              << std::setw(24) << "" << std::setw(12) << "ms" << std::setw(12) << "MB/s" << "\n"
+              << std::setw(24) << "read mapped bytes" << std::setw(12) << touchMs << std::setw(12) << rate(touchMs) << "\n"
+              << std::setw(24) << "stream >>" << std::setw(12) << streamMs << std::setw(12) << rate(streamMs) << "\n"
+              << std::setw(24) << "from_chars, 1 thread" << std::setw(12) << serialMs << std::setw(12) << rate(serialMs) << std::endl;
+
+    size_t maxWorkers = std::max<size_t>(hardware - 1, 1);
+    for (size_t workers = 1; workers <= maxWorkers; workers = workers < 4 ? workers + 1 : workers * 2)
+    {
+        JobSystem jobs(workers);
+        jobs.registerThread();
+        PointTable table;
+        BenchmarkTimer timer;
+        readPointFile(textPath, table, &jobs);
+        double ms = timer.elapsedMs();
+        if (table.values != reference.values)
+        {
+            std::cerr << "Parallel parse differs from the serial one with " << workers << " workers" << std::endl;
+        }
+        std::string label = "from_chars, " + std::to_string(jobs.concurrency()) + " threads";
+        std::cout << std::setw(24) << label << std::setw(12) << ms << std::setw(12) << rate(ms) << std::endl;
+    }
+
+    // First load parses and writes the cache, the second reads it
+    PointTable table;
+    bool fromCache = false;
+    BenchmarkTimer firstTimer;
+    loadPointFile(textPath, table, nullptr, &fromCache);
+    double firstMs = firstTimer.elapsedMs();
+    BenchmarkTimer cachedTimer;
+    loadPointFile(textPath, table, nullptr, &fromCache);
+    double cachedMs = cachedTimer.elapsedMs();
+    if (!fromCache || table.values != reference.values)
+    {
+        std::cerr << "Point cache was not used or differs from the text" << std::endl;
+    }
+    std::cout << std::setw(24) << "parse + write cache" << std::setw(12) << firstMs << std::setw(12) << rate(firstMs) << "\n"
+              << std::setw(24) << "load cache" << std::setw(12) << cachedMs << std::setw(12) << rate(cachedMs) << std::endl;
+    std::cout << "checksum " << checksum << std::endl;
+
+    std::remove(pointCachePath(textPath).c_str());
+    std::remove(textPath);
+}
+
+// Curve Fitting
+// Fits a million noisy samples, then evaluates ten million random queries with
+// the scalar and SIMD paths: splines through every hundredth sample on evenly
+// and unevenly spaced knots, where the segment lookup is a divide or a binary
+// search, and polynomials, which are pure Horner steps. The full million knot
+// spline is evaluated with sorted queries; random queries into it would wait
+// on a cache miss each.
+static void benchmarkCurves()
+{
+    const size_t sampleCount = 1000000;
+    const size_t knotStride = 100;
+    const size_t queryCount = 10000000;
+    std::mt19937 rng(22);
+    std::uniform_real_distribution<float> noise(-0.01f, 0.01f);
+    std::uniform_real_distribution<float> jitter(0.2f, 1.0f);
+
+    std::vector<float> evenX(sampleCount);
+    std::vector<float> unevenX(sampleCount);
+    std::vector<float> y(sampleCount);
+    float position = 0.0f;
+    for (size_t i = 0; i < sampleCount; ++i)
+    {
+        evenX[i] = i * 0.001f;
+        unevenX[i] = position;
+        position += 0.001f * jitter(rng);
+        y[i] = std::sin(evenX[i]) + noise(rng);
+    }
+
+    CubicCurve fullSpline;
+    CubicCurve evenSpline;
+    CubicCurve unevenSpline;
+    CubicCurve hermite;
+    Polynomial cubic;
+    Polynomial septic;
+    std::cout << std::fixed << std::setprecision(2) << "fit " << sampleCount << " samples:";
+    BenchmarkTimer splineTimer;
+    fitCubicSpline(evenX.data(), y.data(), sampleCount, fullSpline);
+    std::cout << " spline " << splineTimer.elapsedMs() << " ms";
+    BenchmarkTimer hermiteTimer;
+    fitHermite(evenX.data(), y.data(), nullptr, sampleCount, hermite);
+    std::cout << ", hermite " << hermiteTimer.elapsedMs() << " ms";
+    BenchmarkTimer polynomialTimer;
+    fitPolynomial(evenX.data(), y.data(), sampleCount, 3, cubic);
+    std::cout << ", cubic polynomial " << polynomialTimer.elapsedMs() << " ms" << std::endl;
+    fitPolynomial(evenX.data(), y.data(), sampleCount, 7, septic);
+
+    std::vector<float> knotX;
+    std::vector<float> unevenKnotX;
+    std::vector<float> knotY;
+    for (size_t i = 0; i < sampleCount; i += knotStride)
+    {
+        knotX.push_back(evenX[i]);
+        unevenKnotX.push_back(unevenX[i] * (evenX.back() / unevenX.back()));
+        knotY.push_back(y[i]);
+    }
+    fitCubicSpline(knotX.data(), knotY.data(), knotX.size(), evenSpline);
+    fitCubicSpline(unevenKnotX.data(), knotY.data(), knotX.size(), unevenSpline);
+    fitHermite(knotX.data(), knotY.data(), nullptr, knotX.size(), hermite);
+
+    std::uniform_real_distribution<float> query(0.0f, evenX.back());
+    std::vector<float> queries(queryCount);
+    for (float& q : queries)
+    {
+        q = query(rng);
+    }
+    std::vector<float> sortedQueries = queries;
+    std::sort(sortedQueries.begin(), sortedQueries.end());
+    std::vector<float> scalar(queryCount);
+    std::vector<float> simd(queryCount);
+
+    std::cout << queryCount << " queries, " << knotX.size() << " knots unless noted, " << SIMD_LANES_NAME << std::endl;
+    std::cout << std::setw(24) << "curve"
+              << std::setw(14) << "scalar ms"
+              << std::setw(14) << "simd ms"
+              << std::setw(14) << "Mquery/s"
+              << std::setw(12) << "speedup" << std::endl;
+
+    auto run = [&](const char* name, auto evaluateScalar, auto evaluate)
+    {
+        BenchmarkTimer scalarTimer;
+        evaluateScalar();
+        double scalarMs = scalarTimer.elapsedMs();
+        BenchmarkTimer simdTimer;
+        evaluate();
+        double simdMs = simdTimer.elapsedMs();
+        if (scalar != simd)
+        {
+            std::cerr << name << ": SIMD evaluation disagrees with the scalar reference" << std::endl;
+        }
+        std::cout << std::setw(24) << name
+                  << std::setw(14) << scalarMs
+                  << std::setw(14) << simdMs
+                  << std::setw(14) << queryCount / (simdMs * 1000.0)
+                  << std::setw(12) << scalarMs / simdMs << std::endl;
+    };
+    run("spline, even knots",
+        [&]() { evenSpline.evaluateScalar(queries.data(), scalar.data(), queryCount); },
+        [&]() { evenSpline.evaluate(queries.data(), simd.data(), queryCount); });
+    run("spline, uneven knots",
+        [&]() { unevenSpline.evaluateScalar(queries.data(), scalar.data(), queryCount); },
+        [&]() { unevenSpline.evaluate(queries.data(), simd.data(), queryCount); });
+    run("hermite, even knots",
+        [&]() { hermite.evaluateScalar(queries.data(), scalar.data(), queryCount); },
+        [&]() { hermite.evaluate(queries.data(), simd.data(), queryCount); });
+    run("spline, 1M knots sorted",
+        [&]() { fullSpline.evaluateScalar(sortedQueries.data(), scalar.data(), queryCount); },
+        [&]() { fullSpline.evaluate(sortedQueries.data(), simd.data(), queryCount); });
+    run("polynomial, degree 3",
+        [&]() { cubic.evaluateScalar(queries.data(), scalar.data(), queryCount); },
+        [&]() { cubic.evaluate(queries.data(), simd.data(), queryCount); });
+    run("polynomial, degree 7",
+        [&]() { septic.evaluateScalar(queries.data(), scalar.data(), queryCount); },
+        [&]() { septic.evaluate(queries.data(), simd.data(), queryCount); });
+}
+
+bool runBenchmark(const std::string& name)
+{
+    if (name == "entities")
+    {
+        benchmarkEntities();
+        return true;
+    }
+    if (name == "crowd")
+    {
+        benchmarkCrowd();
+        return true;
+    }
+    if (name == "pickups")
+    {
+        benchmarkPickups();
+        return true;
+    }
+    if (name == "culling")
+    {
+        benchmarkCulling();
+        return true;
+    }
+    if (name == "meshes")
+    {
+        benchmarkMeshes();
+        return true;
+    }
+    if (name == "lod")
+    {
+        benchmarkLod();
+        return true;
+    }
+    if (name == "optimizer")
+    {
+        benchmarkOptimizer();
+        return true;
+    }
+    if (name == "quantization")
+    {
+        benchmarkQuantization();
+        return true;
+    }
+    if (name == "scene")
+    {
+        benchmarkScene();
+        return true;
+    }
+    if (name == "renderqueue")
+    {
+        benchmarkRenderQueue();
+        return true;
+    }
+    if (name == "simulation")
+    {
+        benchmarkSimulation();
+        return true;
+    }
+    if (name == "jobs")
+    {
+        benchmarkJobs();
+        return true;
+    }
+    if (name == "paths")
+    {
+        benchmarkPaths();
+        return true;
+    }
+    if (name == "points")
+    {
+        benchmarkPoints();
+        return true;
+    }
+    if (name == "curves")
+    {
+        benchmarkCurves();
+        return true;
+    }
+    if (name == "transforms")
+    {
+        benchmarkTransforms();
+        return true;
+    }
+    if (name == "hierarchy")
+    {
+        benchmarkHierarchy();
+        return true;
+    }
+
+    std::cerr << "Unknown benchmark: " << name << std::endl;
+    std::cerr << "Available: entities, crowd, pickups, culling, meshes, lod, optimizer, quantization, scene, renderqueue, simulation, jobs, paths, points, curves, transforms, hierarchy" << std::endl;
+    return false;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+
+// Benchmark Timer
+struct BenchmarkTimer
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    double elapsedMs() const
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+// Runs the benchmark with the given name, returns false if there is none
+bool runBenchmark(const std::string& name);
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+// Bounding Sphere
+struct BoundingSphere
+{
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 0.0f;
+
+    // Sphere enclosing this one after a model transform, scaled by the largest axis scale
+    BoundingSphere transformed(const glm::mat4& model) const
+    {
+        float scaleX = glm::dot(glm::vec3(model[0]), glm::vec3(model[0]));
+        float scaleY = glm::dot(glm::vec3(model[1]), glm::vec3(model[1]));
+        float scaleZ = glm::dot(glm::vec3(model[2]), glm::vec3(model[2]));
+
+        BoundingSphere result;
+        result.center = glm::vec3(model * glm::vec4(center, 1.0f));
+        result.radius = radius * std::sqrt(std::max(scaleX, std::max(scaleY, scaleZ)));
+        return result;
+    }
+};
+
+// Sphere around the centre of the vertices' bounding box, from tightly packed xyz positions
+inline BoundingSphere computeBoundingSphere(const float* vertices, size_t vertexCount)
+{
+    BoundingSphere sphere;
+    if (vertexCount == 0)
+    {
+        return sphere;
+    }
+
+    glm::vec3 min(vertices[0], vertices[1], vertices[2]);
+    glm::vec3 max = min;
+    for (size_t i = 1; i < vertexCount; ++i)
+    {
+        glm::vec3 vertex(vertices[i * 3], vertices[i * 3 + 1], vertices[i * 3 + 2]);
+        min = glm::min(min, vertex);
+        max = glm::max(max, vertex);
+    }
+
+    sphere.center = (min + max) * 0.5f;
+    float radiusSquared = 0.0f;
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        glm::vec3 offset = glm::vec3(vertices[i * 3], vertices[i * 3 + 1], vertices[i * 3 + 2]) - sphere.center;
+        radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+    }
+    sphere.radius = std::sqrt(radiusSquared);
+    return sphere;
+}
@@ -0,0 +1,31 @@
+#include "Camera.h"
+
+void Camera::setView(const glm::mat4& view)
+{
+    if (view != viewMatrix)
+    {
+        viewMatrix = view;
+        viewProjectionDirty = true;
+        ++changes;
+    }
+}
+
+void Camera::setProjection(const glm::mat4& projection)
+{
+    if (projection != projectionMatrix)
+    {
+        projectionMatrix = projection;
+        viewProjectionDirty = true;
+        ++changes;
+    }
+}
+
+const glm::mat4& Camera::viewProjection() const
+{
+    if (viewProjectionDirty)
+    {
+        viewProjectionMatrix = projectionMatrix * viewMatrix;
+        viewProjectionDirty = false;
+    }
+    return viewProjectionMatrix;
+}
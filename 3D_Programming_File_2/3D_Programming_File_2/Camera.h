@@ -0,0 +1,30 @@
+#pragma once
+
+#include <glm.hpp>
+#include <cstdint>
+
+// Camera
+// View and projection with their product cached. A setter only counts as a
+// change when the matrix differs, and the product is rebuilt on the first
+// viewProjection() call after a change. revision() counts the changes, so
+// anything built from the camera, such as per-instance MVPs, can tell when
+// it is stale without comparing matrices.
+class Camera
+{
+public:
+    void setView(const glm::mat4& view);
+    void setProjection(const glm::mat4& projection);
+
+    const glm::mat4& view() const { return viewMatrix; }
+    const glm::mat4& projection() const { return projectionMatrix; }
+    const glm::mat4& viewProjection() const;
+
+    uint64_t revision() const { return changes; }
+
+private:
+    glm::mat4 viewMatrix = glm::mat4(1.0f);
+    glm::mat4 projectionMatrix = glm::mat4(1.0f);
+    mutable glm::mat4 viewProjectionMatrix = glm::mat4(1.0f);
+    mutable bool viewProjectionDirty = false;
+    uint64_t changes = 0;
+};
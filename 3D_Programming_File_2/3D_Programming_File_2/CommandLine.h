@@ -0,0 +1,53 @@
+#pragma once
+
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <limits>
+
+// Command Line Numbers
+// Checked parses of the value after an option, shared by the game and the
+// headless runner. A value that is not a number all the way through, or is out
+// of range, prints "expected ... after <option>" and leaves value unchanged.
+
+// Whole number from minimum to maximum. There is no sign, so "-1" is rejected instead of wrapping.
+inline bool parseCountArgument(const char* option, const char* text, size_t& value, size_t minimum = 0,
+    size_t maximum = std::numeric_limits<size_t>::max())
+{
+    const char* end = text + std::strlen(text);
+    size_t parsed = 0;
+    std::from_chars_result result = std::from_chars(text, end, parsed);
+    if (result.ec != std::errc() || result.ptr != end || parsed < minimum || parsed > maximum)
+    {
+        std::cerr << "expected a number";
+        if (maximum < std::numeric_limits<size_t>::max())
+        {
+            std::cerr << " from " << minimum << " to " << maximum;
+        }
+        else if (minimum > 0)
+        {
+            std::cerr << " of at least " << minimum;
+        }
+        std::cerr << " after " << option << std::endl;
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+// Finite number above 0, e.g. a rate
+inline bool parsePositiveArgument(const char* option, const char* text, double& value)
+{
+    const char* end = text + std::strlen(text);
+    double parsed = 0.0;
+    std::from_chars_result result = std::from_chars(text, end, parsed);
+    if (result.ec != std::errc() || result.ptr != end || !std::isfinite(parsed) || parsed <= 0.0)
+    {
+        std::cerr << "expected a number above 0 after " << option << std::endl;
+        return false;
+    }
+    value = parsed;
+    return true;
+}
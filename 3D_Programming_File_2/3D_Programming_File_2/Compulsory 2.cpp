@@ -8,29 +8,47 @@
 #include <gtc/matrix_transform.hpp>
 #include <gtc/type_ptr.hpp>
 #include <vector>
+#include <string>
+#include <future>
+#include "World.h"
+#include "Benchmark.h"
+#include "InstanceBuffer.h"
+#include "Camera.h"
+#include "TransformBatch.h"
+#include "Shader.h"
+#include "MeshRegistry.h"
+#include "SceneFile.h"
+#include "MeshGenerator.h"
+#include "Frustum.h"
+#include "Lod.h"
+#include "RenderQueue.h"
+#include "SimulationThread.h"
+#include "JobSystem.h"
+#include "InputRecording.h"
+#include "Profiler.h"
+#include "GpuProfiler.h"
+#include "WorldStreaming.h"
+#include "CommandLine.h"
 
 // Window Dimensions
 const GLint WIDTH = 1920, HEIGHT = 1080;
 
-// Camera Struct
-struct Camera 
-{
-    glm::mat4 view;
-    glm::mat4 projection;
-};
-
 // Camera
 Camera camera;
+const float CAMERA_NEAR = 0.1f;
+const float CAMERA_FAR = 100.0f;
 
 // Vertex Shaders
+// The model-view-projection matrix is computed on the CPU, see RenderQueue::computeMvps
 const char* vertexShaderSource = R"(
     #version 330 core
     layout (location = 0) in vec3 aPos;
-    uniform mat4 model;
-    uniform mat4 view;
-    uniform mat4 projection;
+    layout (location = 6) in vec4 aQuantizationOffset;
+    layout (location = 7) in vec4 aQuantizationScale;
+    uniform mat4 mvp;
     void main() {
-        gl_Position = projection * view * model * vec4(aPos, 1.0);
+        vec3 position = aQuantizationOffset.xyz + aPos * aQuantizationScale.xyz;
+        gl_Position = mvp * vec4(position, 1.0);
     }
 )";
 
@@ -44,225 +62,211 @@ const char* fragmentShaderSource = R"(
     }
 )";
 
-// Vertex data for Player
-GLfloat playerVertices[] = 
-{
-    -0.5f, -0.5f, 0.5f,
-     0.5f, -0.5f, 0.5f,
-     0.5f,  0.5f, 0.5f,
-    -0.5f,  0.5f, 0.5f,
-    -0.5f, -0.5f, -0.5f,
-     0.5f, -0.5f, -0.5f,
-     0.5f,  0.5f, -0.5f,
-    -0.5f,  0.5f, -0.5f
-};
-
-// Indices for Player
-GLuint playerIndices[] = 
-{
-    0, 1, 2, 2, 3, 0,
-    4, 5, 6, 6, 7, 4,
-    4, 0, 3, 3, 7, 4,
-    1, 5, 6, 6, 2, 1,
-    3, 2, 6, 6, 7, 3,
-    0, 1, 5, 5, 4, 0
-};
-
-// Vertex Data for NPC
-GLfloat npcVertices[] = 
-{
-    -0.25f, -0.25f, 0.25f,
-    0.25f, -0.25f, 0.25f,
-    0.25f, 0.25f, 0.25f,
-    -0.25f, 0.25f, 0.25f,
-    -0.25f, -0.25f, -0.25f,
-    0.25f, -0.25f, -0.25f,
-    0.25f, 0.25f, -0.25f,
-    -0.25f, 0.25f, -0.25f
-};
-
-// Indices for NPC
-GLuint npcIndices[] = 
-{
-    0, 1, 2,
-    2, 3, 0,
-    4, 5, 6,
-    6, 7, 4,
-    4, 0, 3,
-    3, 7, 4,
-    1, 5, 6,
-    6, 2, 1,
-    3, 2, 6,
-    6, 7, 3,
-    0, 1, 5,
-    5, 4, 0
-};
-
-// NPC Position and Movement Speed
-bool npcOnPath1 = true;
-glm::vec3 npcPosition1 = glm::vec3(-1.5f, -0.2f, 0.0f);
-glm::vec3 npcPosition2 = glm::vec3(0.0f, -0.2f, 0.5f);
-glm::vec3 npcPosition3 = glm::vec3(0.0f, -0.2f, 0.5f);
-glm::vec3 npcPosition4 = glm::vec3(0.0f, -0.2f, -1.0f);
-glm::vec3 npcPosition;
-float npcSpeed = 1.0f;
-
-// NPC Movement
-void updateNPCPosition(float deltaTime) 
-{
-    glm::vec3& currentStartPos = npcOnPath1 ? npcPosition1 : npcPosition3;
-    glm::vec3& currentEndPos = npcOnPath1 ? npcPosition2 : npcPosition4;
-
-    glm::vec3 direction = glm::normalize(currentEndPos - npcPosition);
-    npcPosition += direction * npcSpeed * deltaTime;
+// Instanced Vertex Shader
+// Color and model-view-projection matrix come from the instance buffer instead of uniforms.
+// Quantized positions are decoded with the mesh's bounds first, see MeshRegistry.
+const char* instancedVertexShaderSource = R"(
+    #version 330 core
+    layout (location = 0) in vec3 aPos;
+    layout (location = 1) in vec4 aColor;
+    layout (location = 2) in mat4 aMvp;
+    layout (location = 6) in vec4 aQuantizationOffset;
+    layout (location = 7) in vec4 aQuantizationScale;
+    out vec4 instanceColor;
+    void main() {
+        instanceColor = aColor;
+        vec3 position = aQuantizationOffset.xyz + aPos * aQuantizationScale.xyz;
+        gl_Position = aMvp * vec4(position, 1.0);
+    }
+)";
 
-    if (glm::length(npcPosition - currentEndPos) < 0.05f) 
-    {
-        std::swap(currentStartPos, currentEndPos);
+// Instanced Fragment Shader
+const char* instancedFragmentShaderSource = R"(
+    #version 330 core
+    in vec4 instanceColor;
+    out vec4 FragColor;
+    void main() {
+        FragColor = instanceColor;
     }
-}
+)";
 
+// Generated Meshes
+// Cached by parameters, the sphere LOD chain is generated while the window opens
+MeshGenerator meshGenerator;
+const float SPHERE_RADIUS = 0.05f;
 const int SPHERE_SECTORS = 36;
 const int SPHERE_STACKS = 18;
-
-std::vector<GLfloat> sphereVertices;
-std::vector<GLuint> sphereIndices;
-
-void createSphere(float radius, int sectors, int stacks) 
-{
-    for (int i = 0; i <= stacks; ++i) 
-    {
-        float stackAngle = glm::pi<float>() * static_cast<float>(i) / stacks;
-        float stackRadius = radius * sin(stackAngle);
-        float stackHeight = radius * cos(stackAngle);
-        for (int j = 0; j <= sectors; ++j) 
-        {
-            float sectorAngle = 2 * glm::pi<float>() * static_cast<float>(j) / sectors;
-            float x = stackRadius * sin(sectorAngle);
-            float z = stackRadius * cos(sectorAngle);
-            float y = stackHeight;
-            sphereVertices.push_back(x);
-            sphereVertices.push_back(y);
-            sphereVertices.push_back(z);
-        }
-    }
-    for (int i = 0; i < stacks; ++i) 
-    {
-        for (int j = 0; j < sectors; ++j) 
-        {
-            int k0 = i * (sectors + 1) + j;
-            int k1 = k0 + 1;
-            int k2 = (i + 1) * (sectors + 1) + j + 1;
-            int k3 = (i + 1) * (sectors + 1) + j;
-            sphereIndices.push_back(k0);
-            sphereIndices.push_back(k1);
-            sphereIndices.push_back(k2);
-            sphereIndices.push_back(k0);
-            sphereIndices.push_back(k2);
-            sphereIndices.push_back(k3);
-        }
-    }
-}
-
-std::vector<glm::vec3> spherePositions;
-
-// Sphere Positions
-void initSpherePositions() 
-{
-    spherePositions.push_back(glm::vec3(-1.5f, -0.4f, 0.0f));
-    spherePositions.push_back(glm::vec3(0.0f, -0.4f, 0.5f));
-    spherePositions.push_back(glm::vec3(2.5f, -0.4f, 0.2f));
-    spherePositions.push_back(glm::vec3(1.5f, -0.4f, 2.0f));
-    spherePositions.push_back(glm::vec3(0.0f, -0.4f, 2.0f));
-    spherePositions.push_back(glm::vec3(0.0f, -0.4f, -1.0f));
-}
-
-// Player Position and Movement Speed
-glm::vec3 playerPosition = glm::vec3(1.0f, -0.4, 2.0f);
-float playerSpeed = 0.001f;
-
-bool isNear(glm::vec3 point1, glm::vec3 point2, float distanceThreshold) 
-{
-    float distanceSquared = glm::length(point1 - point2);
-    return distanceSquared <= (distanceThreshold * distanceThreshold);
-}
-
-bool cKeyWasPressed = false;
-bool isInHouse = false;
+const int SPHERE_LOD_LEVELS = 4;
+
+// Smallest projected diameter in pixels at which each sphere LOD is still used
+const float SPHERE_LOD_PIXELS[SPHERE_LOD_LEVELS - 1] = { 48.0f, 20.0f, 8.0f };
+
+// Profiles a draw section on the CPU and, through gpuProfiler, on the GPU
+#define PROFILE_DRAW(name) PROFILE_SCOPE(name); GPU_PROFILE_SCOPE(gpuProfiler, name)
+
+// Chrome trace written on F10 and at exit
+const char* PROFILE_PATH = "profile.json";
+
+// World
+World world;
+
+// Sphere Draw Path
+bool useInstancing = true;
+
+// Vertex Quantization
+// --vertex-format <float|snorm16|half|snorm10> picks the format of the generated
+// meshes (player, NPC and pickup spheres). The hand-written meshes stay float.
+VertexFormat compactVertexFormat = VERTEX_SNORM10;
+
+// Simulation Timing
+// --tick-rate <hz> sets the simulation rate, --vsync renders at display rate,
+// --timings prints the simulation and render cost once per second
+double tickRate = 60.0;
+bool vsync = false;
+bool printTimings = false;
+
+// Job System
+// --workers <n> sets the number of worker threads. 0 starts one per hardware thread
+// minus one, since the main thread joins in, up to the job system's thread slots.
+size_t workerCount = 0;
+
+// Scene File
+// --scene <file> loads meshes and placements from a compiled scene (see scene.txt).
+// Scene meshes replace the built-in ones with the same name; the pickup sphere
+// is always generated, since its LOD chain drives the instanced path.
+SceneFile scene;
+const char* const SCENE_MESH_NAMES[MESH_COUNT] = { "plane", "house", "door", "player", "npc", nullptr, "interior" };
+
+// Spline NPC
+// --spline <file> sets the points an extra NPC walks a curve through, "none"
+// leaves it out. Replays need the same file passed to the headless runner.
+std::string splinePath = "../interpolated_points.txt";
+
+// Input Recording
+// --record <file> writes the input of every tick for the headless runner to replay
+std::string recordPath;
+InputRecording recording;
+
+// World Streaming
+// --gpu-budget <KB> sets the geometry above which cells the player is not in
+// are evicted, at least 1 KB. 0 does not mean unlimited, a large budget does.
+// Doors prefetch the cell behind them within DOOR_PREFETCH_RADIUS.
+size_t gpuBudgetKb = 64 * 1024;
+const float DOOR_PREFETCH_RADIUS = 1.0f;
 
 // Keyboard Input
-void processInput(GLFWwindow* window) 
+// Samples the keys the simulation cares about; the simulation itself runs in tickWorld
+InputState processInput(GLFWwindow* window) 
 {
     static bool cKeyWasPressed = false;
 
-    float sprintFactor = 1.0f;
+    InputState input;
 
     if (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS) 
     {
-        sprintFactor = 2.0f;
+        input.sprint = true;
     }
 
     if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) 
     {
-        playerPosition.z -= playerSpeed * sprintFactor;
+        input.moveZ -= 1.0f;
     }
     if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) 
     {
-        playerPosition.z += playerSpeed * sprintFactor;
+        input.moveZ += 1.0f;
     }
     if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) 
     {
-        playerPosition.x -= playerSpeed * sprintFactor;
+        input.moveX -= 1.0f;
     }
     if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) 
     {
-        playerPosition.x += playerSpeed * sprintFactor;
+        input.moveX += 1.0f;
     }
     if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS) 
     {
-        for (auto it = spherePositions.begin(); it != spherePositions.end(); ) 
-        {
-            if (isNear(playerPosition, *it, 0.3f)) 
-            {
-                it = spherePositions.erase(it);
-            }
-            else {
-                ++it;
-            }
-        }
+        input.collect = true;
     }
 
     bool cKeyPressed = glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS;
     if (cKeyPressed && !cKeyWasPressed)
     {
-        npcOnPath1 = !npcOnPath1;
-        npcPosition = npcOnPath1 ? npcPosition1 : npcPosition3;
+        input.toggleRoute = true;
     }
     cKeyWasPressed = cKeyPressed;
 
+    // Toggle between instanced and per-sphere draws to compare their cost
+    static bool iKeyWasPressed = false;
+    bool iKeyPressed = glfwGetKey(window, GLFW_KEY_I) == GLFW_PRESS;
+    if (iKeyPressed && !iKeyWasPressed)
+    {
+        useInstancing = !useInstancing;
+        std::cout << "Sphere draw path: " << (useInstancing ? "instanced" : "per sphere") << std::endl;
+    }
+    iKeyWasPressed = iKeyPressed;
+
+#ifdef ENABLE_PROFILER
+    static bool f10KeyWasPressed = false;
+    bool f10KeyPressed = glfwGetKey(window, GLFW_KEY_F10) == GLFW_PRESS;
+    if (f10KeyPressed && !f10KeyWasPressed)
+    {
+        profilerWriteChromeTrace(PROFILE_PATH);
+    }
+    f10KeyWasPressed = f10KeyPressed;
+#endif
+
     if (glfwGetKey(window, GLFW_KEY_O) == GLFW_PRESS) 
     {
-        glm::vec3 doorPosition = glm::vec3(1.3f, -0.45f, 0.01f);
-        if (isNear(playerPosition, doorPosition, 0.3f)) 
-        {
-            isInHouse = !isInHouse;
-            if (isInHouse) 
-            {
-                playerPosition = glm::vec3(0.0f, -0.4f, 0.0f);
+        input.useDoor = true;
+    }
+    return input;
+}
 
-                camera.view = glm::lookAt(
-                    glm::vec3(-0.5f, 1.0f, 1.0f),
-                    glm::vec3(0.0f, 0.0f, 0.0f), 
-                    glm::vec3(0.0f, 1.0f, 0.0f)
-                );
-            }
-            else 
-            {
-                playerPosition = glm::vec3(1.5f, -0.4f, 0.5f);
-                camera.view = glm::lookAt(glm::vec3(1.0f, 0.0f, 3.5f), glm::vec3(0.5f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-            }
-        }
-    } 
+// Camera View for the scene the player is in
+void updateCameraView(bool isInHouse)
+{
+    if (isInHouse) 
+    {
+        camera.setView(glm::lookAt(
+            glm::vec3(-0.5f, 1.0f, 1.0f),
+            glm::vec3(0.0f, 0.0f, 0.0f), 
+            glm::vec3(0.0f, 1.0f, 0.0f)
+        ));
+    }
+    else 
+    {
+        camera.setView(glm::lookAt(glm::vec3(1.0f, 0.0f, 3.5f), glm::vec3(0.5f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+    }
+}
+
+// Frame Timings
+// Simulation and render CPU cost measured separately, printed once per second.
+// The simulation thread keeps running totals, the report shows their change.
+struct FrameTimings
+{
+    SimulationStats simulationAtReport;
+    double renderMs = 0.0;
+    size_t frames = 0;
+    double lastReport = 0.0;
+};
+
+void reportFrameTimings(FrameTimings& timings, const SimulationStats& simulation, double now)
+{
+    if (now - timings.lastReport < 1.0)
+    {
+        return;
+    }
+
+    double seconds = now - timings.lastReport;
+    uint64_t ticks = simulation.ticks - timings.simulationAtReport.ticks;
+    double simulationMs = simulation.simulationMs - timings.simulationAtReport.simulationMs;
+    std::cout << "[timings] " << ticks / seconds << " ticks/s at "
+              << (ticks ? simulationMs / ticks : 0.0) << " ms/tick, "
+              << timings.frames / seconds << " frames/s at "
+              << (timings.frames ? timings.renderMs / timings.frames : 0.0) << " ms/frame" << std::endl;
+    timings = FrameTimings();
+    timings.simulationAtReport = simulation;
+    timings.lastReport = now;
 }
 
 // Initialize GLFW
@@ -286,370 +290,729 @@ void initWindow()
     gladLoadGL();
 }
 
-// Render Loop
-void renderLoop(GLFWwindow* window) 
+// Sphere Draw Stats
+// CPU time spent culling and recording the pickup spheres, printed once per second with --timings
+struct SphereDrawStats
 {
-    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-    glEnable(GL_DEPTH_TEST);
+    double submitMs = 0.0;
+    size_t drawCalls = 0;
+    size_t visible = 0;
+    size_t triangles = 0;
+    size_t fullDetailTriangles = 0;
+    size_t lodInstances[MAX_LOD_LEVELS] = {};
+    size_t frames = 0;
+    double lastReport = 0.0;
+};
 
-    camera.projection = glm::perspective(glm::radians(45.0f), (float)WIDTH / (float)HEIGHT, 0.1f, 100.0f);
-    camera.view = glm::lookAt(glm::vec3(1.0f, 0.0f, 3.5f), glm::vec3(0.5f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+void reportSphereDrawStats(SphereDrawStats& stats, size_t spheres, double now)
+{
+    if (now - stats.lastReport < 1.0 || stats.frames == 0)
+    {
+        return;
+    }
 
-    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-    glCompileShader(vertexShader);
+    std::cout << (useInstancing ? "[instanced] " : "[per sphere] ")
+              << spheres << " spheres, "
+              << stats.visible / stats.frames << " visible/frame, "
+              << stats.drawCalls / stats.frames << " draw calls/frame, "
+              << stats.submitMs / stats.frames << " ms record/frame, "
+              << stats.triangles / stats.frames << " triangles/frame ("
+              << stats.fullDetailTriangles / stats.frames << " without LOD), instances per LOD";
+    for (size_t count : stats.lodInstances)
+    {
+        std::cout << ' ' << count / stats.frames;
+    }
+    std::cout << std::endl;
+    stats = SphereDrawStats();
+    stats.lastReport = now;
+}
 
-    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-    glCompileShader(fragmentShader);
+// Cull Stats
+// Objects that passed or failed the frustum test this frame, sent to the profiler
+struct CullStats
+{
+    size_t visible = 0;
+    size_t culled = 0;
+};
 
-    GLuint shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
+// Frustum test for one mesh drawn with the given model matrix
+bool isVisible(const Frustum& frustum, const BoundingSphere& bounds, const glm::mat4& model, CullStats& stats)
+{
+    bool visible = frustum.containsSphere(bounds.transformed(model));
+    stats.visible += visible ? 1 : 0;
+    stats.culled += visible ? 0 : 1;
+    return visible;
+}
+
+// Render Programs, the program field of every sort key
+enum RenderProgram : uint32_t
+{
+    PROGRAM_BASIC, // MVP matrix and material color from uniforms
+    PROGRAM_INSTANCED // MVP matrix and color from the instance buffer
+};
 
-    int success;
-    char infoLog[512];
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success) 
+// Records a plain draw if the mesh is inside the frustum
+void recordDraw(RenderQueue& queue, const MeshRegistry& registry, const Frustum& frustum, CullStats& stats,
+    MeshHandle mesh, const glm::vec4& color, const glm::mat4& model)
+{
+    if (isVisible(frustum, registry.bounds(mesh), model, stats))
     {
-        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-        std::cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+        queue.draw(RENDER_PASS_OPAQUE, PROGRAM_BASIC, registry.range(mesh).vertexFormat, mesh, color, model);
     }
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+}
 
-    // Vertex Data for Ground Plane
-    GLfloat planeVertices[] = 
+// Render Queue Submission
+// Walks the sorted queue and only switches program or material color when the
+// key says they changed. The registry skips VAO binds for unchanged vertex formats.
+void submitRenderQueue(const RenderQueue& queue, const ShaderProgram* const programs[], GLint mvpLoc, GLint colorLoc,
+    const MeshRegistry& registry, const InstanceBuffer& instances)
+{
+    uint32_t currentProgram = RENDER_MAX_PROGRAMS;
+    uint16_t currentMaterial = RENDER_NO_MATERIAL;
+    for (size_t i = 0; i < queue.size(); ++i)
     {
-        -2.0f, -0.5f, -2.0f,
-        2.0f, -0.5f, -2.0f,
-        2.0f, -0.5f, 3.0f,
-        -2.0f, -0.5f, 3.0f
-    };
-
-    // Indices for Ground Plane
-    GLuint planeIndices[] = 
+        uint64_t key = queue.key(i);
+        const DrawCommand& command = queue.command(i);
+
+        uint32_t program = sortKeyProgram(key);
+        if (program != currentProgram)
+        {
+            programs[program]->use();
+            currentProgram = program;
+            currentMaterial = RENDER_NO_MATERIAL;
+        }
+
+        // Draws past the material table's capacity set their color every time
+        uint16_t material = sortKeyMaterial(key);
+        if (material != RENDER_NO_MATERIAL && (material != currentMaterial || material == RENDER_OVERFLOW_MATERIAL))
+        {
+            glUniform4fv(colorLoc, 1, glm::value_ptr(queue.color(command)));
+            currentMaterial = material;
+        }
+
+        if (command.instanceCount > 0)
+        {
+            instances.setFirstInstance(command.firstInstance);
+            registry.drawInstanced(command.mesh, static_cast<GLsizei>(command.instanceCount));
+        }
+        else
+        {
+            glUniformMatrix4fv(mvpLoc, 1, GL_FALSE, glm::value_ptr(queue.mvp(command)));
+            registry.draw(command.mesh);
+        }
+    }
+}
+
+// Render Queue Stats
+// Draws and state changes per frame in recorded and sorted order, printed with --timings
+struct RenderQueueStats
+{
+    size_t draws = 0;
+    StateChangeCounts recorded;
+    StateChangeCounts sorted;
+    double sortMs = 0.0;
+    size_t frames = 0;
+    double lastReport = 0.0;
+};
+
+void addStateChanges(StateChangeCounts& total, const StateChangeCounts& frame)
+{
+    total.program += frame.program;
+    total.vertexFormat += frame.vertexFormat;
+    total.mesh += frame.mesh;
+    total.material += frame.material;
+}
+
+void reportRenderQueueStats(RenderQueueStats& stats, double now)
+{
+    if (now - stats.lastReport < 1.0 || stats.frames == 0)
     {
-        0, 1, 2,
-        2, 3, 0
-    };
+        return;
+    }
+
+    size_t frames = stats.frames;
+    std::cout << "[render queue] " << stats.draws / frames << " draws/frame, "
+              << stats.sortMs / frames << " ms sort/frame, state changes/frame "
+              << stats.recorded.total() / frames << " -> " << stats.sorted.total() / frames
+              << " (program " << stats.recorded.program / frames << " -> " << stats.sorted.program / frames
+              << ", vertex format " << stats.recorded.vertexFormat / frames << " -> " << stats.sorted.vertexFormat / frames
+              << ", mesh " << stats.recorded.mesh / frames << " -> " << stats.sorted.mesh / frames
+              << ", material " << stats.recorded.material / frames << " -> " << stats.sorted.material / frames << ")" << std::endl;
+    stats = RenderQueueStats();
+    stats.lastReport = now;
+}
+
+// Vertex Data for Ground Plane
+const GLfloat planeVertices[] = 
+{
+    -2.0f, -0.5f, -2.0f,
+    2.0f, -0.5f, -2.0f,
+    2.0f, -0.5f, 3.0f,
+    -2.0f, -0.5f, 3.0f
+};
+
+// Indices for Ground Plane
+const GLuint planeIndices[] = 
+{
+    0, 1, 2,
+    2, 3, 0
+};
+
+// Vertex Data for House
+// The last four vertices and six indices are the door
+const GLfloat houseVertices[] = 
+{
+    -0.5f, -0.5f, 0.0f,
+    0.5f, -0.5f, 0.0f,
+    0.5f, 0.5f, 0.0f,
+    -0.5f, 0.5f, 0.0f,
+    -0.5f, -0.5f, 1.0f,
+    0.5f, -0.5f, 1.0f,
+    0.5f, 0.5f, 1.0f,
+    -0.5f, 0.5f, 1.0f,
+    0.0f, 1.0f, 0.5f,
+    -0.1f, -0.495f, 0.0f,
+    0.1f, -0.51f, 0.0f,
+    0.1f, 0.0f, 0.0f,
+    -0.1f, 0.0f, 0.0f
+};
 
-    // Vertex Data for House
-    GLfloat houseVertices[] = 
+// Indices for House
+const GLuint houseIndices[] = 
+{
+    0, 1, 2,
+    2, 3, 0,
+    4, 5, 6,
+    6, 7, 4,
+    0, 4, 7,
+    7, 3, 0,
+    1, 5, 6,
+    6, 2, 1,
+    0, 1, 5,
+    5, 4, 0,
+    3, 2, 6,
+    6, 7, 3,
+    9, 10, 11,
+    11, 12, 9
+};
+
+// Vertex data for Interior
+const GLfloat houseInteriorVertices[] = 
+{
+    -0.5f, -0.5f,  0.5f,
+     0.5f, -0.5f,  0.5f,
+     0.5f, -0.5f, -0.5f,
+    -0.5f, -0.5f, -0.5f,
+    -0.5f, 0.5f, -0.5f,
+     0.5f, 0.5f, -0.5f,
+     0.5f, -0.5f, -0.5f,
+    -0.5f, -0.5f, -0.5f,
+     0.5f, 0.5f, -0.5f,
+     0.5f, 0.5f,  0.5f,
+     0.5f, -0.5f,  0.5f,
+     0.5f, -0.5f, -0.5f,
+};
+
+// Indices for Interior
+const GLuint houseInteriorIndices[] = 
+{
+    0, 1, 2,
+    0, 2, 3,
+    4, 5, 6, 
+    4, 6, 7,
+    8, 9, 10,
+    8, 10, 11
+};
+
+// Cell Meshes
+// Built on the streamer's loader thread from the arrays above
+MeshData meshFromArrays(const GLfloat* vertices, size_t floatCount, const GLuint* indices, size_t indexCount)
+{
+    MeshData mesh;
+    mesh.vertices.assign(vertices, vertices + floatCount);
+    mesh.intIndices.assign(indices, indices + indexCount);
+    return mesh;
+}
+
+MeshData buildPlaneMesh()
+{
+    return meshFromArrays(planeVertices, sizeof(planeVertices) / sizeof(GLfloat), planeIndices, sizeof(planeIndices) / sizeof(GLuint));
+}
+
+MeshData buildHouseMesh()
+{
+    return meshFromArrays(houseVertices, sizeof(houseVertices) / sizeof(GLfloat), houseIndices, sizeof(houseIndices) / sizeof(GLuint));
+}
+
+MeshData buildInteriorMesh()
+{
+    return meshFromArrays(houseInteriorVertices, sizeof(houseInteriorVertices) / sizeof(GLfloat),
+        houseInteriorIndices, sizeof(houseInteriorIndices) / sizeof(GLuint));
+}
+
+// World Cells
+// The exterior owns the plane and the house with its door, the house cell the
+// interior. The door is a portal both ways, so walking up to it loads the other
+// side before it is used. The hand-written meshes stay float.
+struct CellPortals
+{
+    size_t houseEntrance = 0;
+    size_t houseExit = 0;
+};
+
+CellPortals setupCells(CellStreamer& streamer)
+{
+    CellManifest exterior;
+    exterior.meshes.push_back({ MESH_PLANE, buildPlaneMesh, VERTEX_FLOAT3, {} });
+    exterior.meshes.push_back({ MESH_COUNT, buildHouseMesh, VERTEX_FLOAT3, { 36 } });
+    exterior.submeshes.push_back({ MESH_HOUSE, 1, 0, 36 });
+    exterior.submeshes.push_back({ MESH_DOOR, 1, 36, 6 });
+    streamer.setManifest(CELL_EXTERIOR, exterior);
+
+    CellManifest house;
+    house.meshes.push_back({ MESH_INTERIOR, buildInteriorMesh, VERTEX_FLOAT3, {} });
+    streamer.setManifest(CELL_HOUSE, house);
+
+    CellPortals portals;
+    portals.houseEntrance = streamer.addPortal({ CELL_EXTERIOR, CELL_HOUSE, glm::vec3(0.0f), DOOR_PREFETCH_RADIUS });
+    portals.houseExit = streamer.addPortal({ CELL_HOUSE, CELL_EXTERIOR, glm::vec3(0.0f), DOOR_PREFETCH_RADIUS });
+    return portals;
+}
+
+// Render Loop
+void renderLoop(GLFWwindow* window, JobSystem& jobs) 
+{
+    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+    glEnable(GL_DEPTH_TEST);
+    glfwSwapInterval(vsync ? 1 : 0);
+
+    camera.setProjection(glm::perspective(glm::radians(45.0f), (float)WIDTH / (float)HEIGHT, CAMERA_NEAR, CAMERA_FAR));
+    CellId displayedCell = world.isInHouse ? CELL_HOUSE : CELL_EXTERIOR;
+    updateCameraView(displayedCell == CELL_HOUSE);
+
+    ShaderProgram shaderProgram;
+    shaderProgram.create(vertexShaderSource, fragmentShaderSource);
+    GLint mvpLoc = shaderProgram.uniform("mvp");
+    GLint colorLoc = shaderProgram.uniform("objectColor");
+
+    ShaderProgram instancedProgram;
+    instancedProgram.create(instancedVertexShaderSource, instancedFragmentShaderSource);
+
+    // Geometry Arena
+    // Every static mesh shares one vertex buffer, one index buffer and one VAO per vertex format
+    MeshRegistry meshRegistry;
+    meshRegistry.create(1024, 4096);
+
+    // The plane, house, door and interior come from the cell streamer below
+    MeshHandle meshes[MESH_COUNT];
+    MeshHandle sceneOverrides[MESH_COUNT];
+    for (uint32_t id = 0; id < MESH_COUNT; ++id)
     {
-        -0.5f, -0.5f, 0.0f,
-        0.5f, -0.5f, 0.0f,
-        0.5f, 0.5f, 0.0f,
-        -0.5f, 0.5f, 0.0f,
-        -0.5f, -0.5f, 1.0f,
-        0.5f, -0.5f, 1.0f,
-        0.5f, 0.5f, 1.0f,
-        -0.5f, 0.5f, 1.0f,
-        0.0f, 1.0f, 0.5f,
-        -0.1f, -0.495f, 0.0f,
-        0.1f, -0.51f, 0.0f,
-        0.1f, 0.0f, 0.0f,
-        -0.1f, 0.0f, 0.0f
-    };
-
-    // Indices for House
-    GLuint houseIndices[] = 
+        meshes[id] = INVALID_MESH;
+        sceneOverrides[id] = INVALID_MESH;
+    }
+    meshRegistry.vertexFormat = compactVertexFormat;
+    meshes[MESH_PLAYER] = meshRegistry.add(meshGenerator.box(glm::vec3(0.5f))[0]);
+    meshes[MESH_NPC] = meshRegistry.add(meshGenerator.box(glm::vec3(0.25f))[0]);
+
+    // Sphere LOD chain, level 0 doubles as MESH_SPHERE
+    const MeshLods& sphereChain = meshGenerator.uvSphere(SPHERE_RADIUS, SPHERE_SECTORS, SPHERE_STACKS, SPHERE_LOD_LEVELS);
+    MeshHandle sphereLods[MAX_LOD_LEVELS];
+    for (size_t level = 0; level < sphereChain.size(); ++level)
     {
-        0, 1, 2,
-        2, 3, 0,
-        4, 5, 6,
-        6, 7, 4,
-        0, 4, 7,
-        7, 3, 0,
-        1, 5, 6,
-        6, 2, 1,
-        0, 1, 5,
-        5, 4, 0,
-        3, 2, 6,
-        6, 7, 3,
-        9, 10, 11,
-        11, 12, 9
-    };
-
-    // Vertex data for Interior
-    GLfloat houseInteriorVertices[] = 
+        sphereLods[level] = meshRegistry.add(sphereChain[level]);
+    }
+    meshes[MESH_SPHERE] = sphereLods[0];
+    meshRegistry.vertexFormat = VERTEX_FLOAT3;
+
+    // Scene Meshes, uploaded straight from the mapped file. They stay resident and
+    // take the place of the cells' meshes with the same name.
+    if (scene.isOpen())
     {
-        -0.5f, -0.5f,  0.5f,
-         0.5f, -0.5f,  0.5f,
-         0.5f, -0.5f, -0.5f,
-        -0.5f, -0.5f, -0.5f,
-        -0.5f, 0.5f, -0.5f,
-         0.5f, 0.5f, -0.5f,
-         0.5f, -0.5f, -0.5f,
-        -0.5f, -0.5f, -0.5f,
-         0.5f, 0.5f, -0.5f,
-         0.5f, 0.5f,  0.5f,
-         0.5f, -0.5f,  0.5f,
-         0.5f, -0.5f, -0.5f,
-    };
-
-    // Indices for Interior
-    GLuint houseInteriorIndices[] = 
+        BenchmarkTimer sceneTimer;
+        std::vector<MeshHandle> sceneMeshes;
+        meshRegistry.addScene(scene, sceneMeshes);
+        for (uint32_t id = 0; id < MESH_COUNT; ++id)
+        {
+            uint32_t index = SCENE_MESH_NAMES[id] ? scene.findMesh(SCENE_MESH_NAMES[id]) : SCENE_NO_MESH;
+            if (index != SCENE_NO_MESH)
+            {
+                meshes[id] = sceneMeshes[index];
+                sceneOverrides[id] = sceneMeshes[index];
+            }
+        }
+        std::cout << "[scene] " << scene.meshCount() << " meshes, " << scene.entityCount() << " entities, "
+                  << (scene.vertexDataSize() + scene.indexDataSize()) / 1024 << " KB of geometry uploaded in "
+                  << sceneTimer.elapsedMs() << " ms" << std::endl;
+    }
+
+    // World Streaming
+    // Only the cell the player starts in is loaded up front, the rest streams in
+    CellStreamer streamer;
+    CellPortals portals = setupCells(streamer);
+    streamer.budgetBytes = gpuBudgetKb * 1024;
+    streamer.loadNow(meshRegistry, displayedCell);
+
+    // Mesh Optimizer Report
+    for (MeshHandle mesh = 0; mesh < meshRegistry.meshCount(); ++mesh)
     {
-        0, 1, 2,
-        0, 2, 3,
-        4, 5, 6, 
-        4, 6, 7,
-        8, 9, 10,
-        8, 10, 11
-    };
-
-    // VAO, VBO, and EBO for Ground Plane
-    GLuint planeVAO, planeVBO, planeEBO;
-    glGenVertexArrays(1, &planeVAO);
-    glGenBuffers(1, &planeVBO);
-    glGenBuffers(1, &planeEBO);
-    glBindVertexArray(planeVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, planeVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(planeVertices), planeVertices, GL_STATIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, planeEBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(planeIndices), planeIndices, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glBindVertexArray(0);
-
-    // VAO, VBO, and EBO for House
-    GLuint houseVAO, houseVBO, houseEBO;
-    glGenVertexArrays(1, &houseVAO);
-    glGenBuffers(1, &houseVBO);
-    glGenBuffers(1, &houseEBO);
-    glBindVertexArray(houseVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, houseVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(houseVertices), houseVertices, GL_STATIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, houseEBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(houseIndices), houseIndices, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glBindVertexArray(0);
-
-    // VAO, VBO, and EBO for Player
-    GLuint playerVAO, playerVBO, playerEBO;
-    glGenVertexArrays(1, &playerVAO);
-    glGenBuffers(1, &playerVBO);
-    glGenBuffers(1, &playerEBO);
-    glBindVertexArray(playerVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, playerVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(playerVertices), playerVertices, GL_STATIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, playerEBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(playerIndices), playerIndices, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glBindVertexArray(0);
-
-    // VAO, VBO, and EBO for NPC
-    GLuint npcVAO, npcVBO, npcEBO;
-    glGenVertexArrays(1, &npcVAO);
-    glGenBuffers(1, &npcVBO);
-    glGenBuffers(1, &npcEBO);
-    glBindVertexArray(npcVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, npcVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(npcVertices), npcVertices, GL_STATIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, npcEBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(npcIndices), npcIndices, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glBindVertexArray(0);
-
-    // VAO, VBO, and EBO for Sphere
-    GLuint sphereVAO, sphereVBO, sphereEBO;
-    glGenVertexArrays(1, &sphereVAO);
-    glGenBuffers(1, &sphereVBO);
-    glGenBuffers(1, &sphereEBO);
-    glBindVertexArray(sphereVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, sphereVBO);
-    glBufferData(GL_ARRAY_BUFFER, sphereVertices.size() * sizeof(GLfloat), sphereVertices.data(), GL_STATIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sphereEBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sphereIndices.size() * sizeof(GLuint), sphereIndices.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (void*)0);
-    glEnableVertexAttribArray(0);
-    glBindVertexArray(0);
-
-    // VAO, VBO, and EBO for Interior
-    GLuint houseInteriorVAO, houseInteriorVBO, houseInteriorEBO;
-    glGenVertexArrays(1, &houseInteriorVAO);
-    glGenBuffers(1, &houseInteriorVBO);
-    glGenBuffers(1, &houseInteriorEBO);
-    glBindVertexArray(houseInteriorVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, houseInteriorVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(houseInteriorVertices), houseInteriorVertices, GL_STATIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, houseInteriorEBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(houseInteriorIndices), houseInteriorIndices, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glBindVertexArray(0);
-
-    initSpherePositions();
+        if (!meshRegistry.isLive(mesh))
+        {
+            continue;
+        }
+        const MeshOptimizeReport& report = meshRegistry.optimizeReport(mesh);
+        const MeshRange& range = meshRegistry.range(mesh);
+        std::cout << "[mesh " << mesh << "] " << range.indexCount / 3 << " triangles, ACMR "
+                  << report.before.acmr << " -> " << report.after.acmr << ", ATVR "
+                  << report.before.atvr << " -> " << report.after.atvr << ", "
+                  << vertexFormatName(range.vertexFormat) << " " << range.vertexCount * vertexFormatSize(range.vertexFormat)
+                  << " vertex bytes, error " << meshRegistry.quantizationError(mesh) << std::endl;
+    }
+
+    // Instance Buffer for Pickup Spheres
+    InstanceBuffer pickupInstances;
+    pickupInstances.create(meshRegistry.vertexArray(meshRegistry.range(sphereLods[0]).vertexFormat));
+    SphereDrawStats sphereStats;
+
+    // Frustum Culling
+    Frustum frustum;
+    std::vector<uint32_t> visiblePickups;
+    std::vector<std::vector<uint32_t>> visiblePickupChunks;
+
+    // Pickup LOD
+    LodSelector pickupLodSelector;
+    pickupLodSelector.setLevels(static_cast<int>(sphereChain.size()), SPHERE_LOD_PIXELS);
+    LodBuckets pickupBuckets;
+
+    // Render Queue
+    RenderQueue renderQueue;
+    RenderQueueStats renderQueueStats;
+    const ShaderProgram* renderPrograms[] = { &shaderProgram, &instancedProgram };
+
+#ifdef ENABLE_PROFILER
+    GpuProfiler gpuProfiler;
+    gpuProfiler.create();
+#endif
+
+    // Simulation Thread
+    // Owns the world from here on, the loop below only reads its snapshots
+    SimulationThread simulation;
+    simulation.start(world, tickRate, recordPath.empty() ? nullptr : &recording);
+    FrameTimings timings;
 
     // Main Render Loop
     while (!glfwWindowShouldClose(window)) 
     {
-        processInput(window);
-        float deltaTime = 0.001f;
-        updateNPCPosition(deltaTime);
+        double now = glfwGetTime();
 
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+#ifdef ENABLE_PROFILER
+        gpuProfiler.beginFrame();
+#endif
 
-        glUseProgram(shaderProgram);
-
-        GLint viewLoc = glGetUniformLocation(shaderProgram, "view");
-        GLint projLoc = glGetUniformLocation(shaderProgram, "projection");
-        glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(camera.view));
-        glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(camera.projection));
+        {
+            PROFILE_SCOPE("processInput");
+            simulation.submitInput(processInput(window));
+        }
 
-        GLint modelLoc = glGetUniformLocation(shaderProgram, "model");
-        GLint colorLoc = glGetUniformLocation(shaderProgram, "objectColor");
+        // Render between the last two ticks of the newest snapshot
+        BenchmarkTimer renderTimer;
+        const RenderSnapshot& snapshot = simulation.latestSnapshot();
+        float alpha = snapshot.alpha(SimulationThread::clockSeconds());
 
-        if (!isInHouse) 
+        // World Streaming
+        // The displayed cell only switches once the cell the player is in is resident,
+        // so going through a door never waits on a load
         {
-            // Draw Plane
-            glBindVertexArray(planeVAO);
-            glUniform4f(colorLoc, 0.0f, 1.0f, 0.0f, 1.0f); // RGBA green
-            glm::mat4 model = glm::mat4(1.0f);
-            model = glm::rotate(model, glm::radians(60.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-            glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-            glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-            glBindVertexArray(0);
-
-            // Draw House
-            glBindVertexArray(houseVAO);
-            glUniform4f(colorLoc, 1.0f, 0.0f, 0.0f, 1.0f); // RGBA red
-            model = glm::translate(model, glm::vec3(1.5f, 0.0f, 0.5f));
-            glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-            glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
-            glBindVertexArray(0);
-
-            // Draw Door
-            glUniform4f(colorLoc, 0.0f, 0.0f, 1.0f, 1.0f); // RGBA blue
-            model = glm::mat4(1.0f);
-            float DoorWidth = 0.3f;
-            float DoorHeight = 1.0f;
-            model = glm::translate(model, glm::vec3(1.3f, -0.45f + DoorHeight / 2, 0.01f));
-            model = glm::scale(model, glm::vec3(1.0f, 1.0f, 1.0f));
-            glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-            glBindVertexArray(houseVAO);
-            glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, (void*)(36 * sizeof(GLuint)));
-
-            // Draw Player
-            glUniform4f(colorLoc, 0.5f, 0.0f, 0.5f, 1.0f); // RGBA purple
-            glBindVertexArray(playerVAO);
-            glm::mat4 playerModel = glm::mat4(1.0f);
-            playerModel = glm::translate(playerModel, playerPosition);
-            playerModel = glm::scale(playerModel, glm::vec3(0.1f));
-            glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(playerModel));
-            glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
-            glBindVertexArray(0);
-
-            // Draw NPC
-            glUniform4f(colorLoc, 1.0f, 0.5f, 0.0f, 1.0f); // RGBA orange
-            glBindVertexArray(npcVAO);
-            glm::mat4 npcModel = glm::mat4(1.0f);
-            npcModel = glm::translate(npcModel, npcPosition);
-            npcModel = glm::scale(npcModel, glm::vec3(0.1f));
-            glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(npcModel));
-            glBindVertexArray(playerVAO);
-            glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
-            glBindVertexArray(0);
-
-            // NPC Movement
-            if (npcOnPath1)
+            PROFILE_SCOPE("Stream Cells");
+            CellId wantedCell = snapshot.isInHouse ? CELL_HOUSE : CELL_EXTERIOR;
+            glm::vec3 door = doorThresholdPosition(snapshot.transforms, snapshot.sceneNodes);
+            streamer.setPortalPosition(portals.houseEntrance, door);
+            streamer.setPortalPosition(portals.houseExit, door);
+            streamer.update(meshRegistry, displayedCell, wantedCell, snapshot.players.position[snapshot.players.indexOf(snapshot.player)]);
+            if (wantedCell != displayedCell && streamer.isResident(wantedCell))
             {
-                npcPosition += glm::normalize(npcPosition2 - npcPosition1) * npcSpeed * deltaTime;
-                if (glm::length(npcPosition - npcPosition2) < 0.001f) 
-                {
-                    npcOnPath1 = false;
-                }
+                displayedCell = wantedCell;
+                updateCameraView(displayedCell == CELL_HOUSE);
             }
-            else {
-                npcPosition += glm::normalize(npcPosition1 - npcPosition2) * npcSpeed * deltaTime;
-                if (glm::length(npcPosition - npcPosition1) < 0.001f) 
+            streamer.resolve(displayedCell, meshes);
+            for (uint32_t id = 0; id < MESH_COUNT; ++id)
+            {
+                if (sceneOverrides[id] != INVALID_MESH)
                 {
-                    npcOnPath1 = true;
+                    meshes[id] = sceneOverrides[id];
                 }
             }
+        }
+
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        // Planes are extracted once per frame and shared by every draw below
+        frustum.extract(camera.viewProjection());
+        CullStats cullStats;
+        renderQueue.begin(camera.view(), CAMERA_FAR);
+
+        if (displayedCell == CELL_EXTERIOR) 
+        {
+            PROFILE_SCOPE("Record Draws");
+            const TransformGraph& transforms = snapshot.transforms;
+            const SceneNodes& nodes = snapshot.sceneNodes;
+
+            // Plane
+            recordDraw(renderQueue, meshRegistry, frustum, cullStats, meshes[MESH_PLANE], glm::vec4(0.0f, 1.0f, 0.0f, 1.0f), transforms.world(nodes.plane)); // RGBA green
+
+            // House
+            recordDraw(renderQueue, meshRegistry, frustum, cullStats, meshes[MESH_HOUSE], glm::vec4(1.0f, 0.0f, 0.0f, 1.0f), transforms.world(nodes.house)); // RGBA red
+
+            // Door
+            recordDraw(renderQueue, meshRegistry, frustum, cullStats, meshes[MESH_DOOR], glm::vec4(0.0f, 0.0f, 1.0f, 1.0f), transforms.world(nodes.door)); // RGBA blue
+
+            // Player
+            glm::mat4 playerModel = translateScale(snapshot.players.interpolatedPosition(snapshot.players.indexOf(snapshot.player), alpha), 0.1f);
+            recordDraw(renderQueue, meshRegistry, frustum, cullStats, meshes[MESH_PLAYER], PLAYER_COLOR, playerModel);
+
+            // NPCs
+            for (size_t i = 0; i < snapshot.npcs.size(); ++i)
+            {
+                glm::mat4 npcModel = translateScale(snapshot.npcs.interpolatedPosition(i, alpha), snapshot.npcs.scale[i]);
+                recordDraw(renderQueue, meshRegistry, frustum, cullStats, meshes[snapshot.npcs.meshId[i]], snapshot.npcs.color[i], npcModel);
+            }
 
-            // Draw Spheres
-            glBindVertexArray(sphereVAO);
-            for (const auto& position : spherePositions) 
+            // Spheres
             {
-                glm::mat4 sphereModel = glm::mat4(1.0f);
-                sphereModel = glm::translate(sphereModel, position);
-                glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(sphereModel));
-                glUniform4f(colorLoc, 1.0f, 0.843f, 0.0f, 1.0f); // RGBA gold
-                glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(sphereIndices.size()), GL_UNSIGNED_INT, 0);
+                BenchmarkTimer sphereTimer;
+                {
+                    PROFILE_SCOPE("Cull Spheres");
+                    cullSpheresParallel(jobs, frustum, snapshot.pickups.position.data(), snapshot.pickups.scale.data(), snapshot.pickups.size(),
+                        meshRegistry.bounds(meshes[MESH_SPHERE]), visiblePickups, visiblePickupChunks);
+                }
+                cullStats.visible += visiblePickups.size();
+                cullStats.culled += snapshot.pickups.size() - visiblePickups.size();
+                sphereStats.visible += visiblePickups.size();
 
+                {
+                    PROFILE_SCOPE("Select Sphere LODs");
+                    pickupLodSelector.beginFrame(camera.view(), camera.projection(), static_cast<float>(HEIGHT));
+                    pickupLodSelector.bucket(snapshot.pickups, visiblePickups, meshRegistry.bounds(meshes[MESH_SPHERE]).radius, pickupBuckets, &jobs);
+                }
+
+                // One instanced draw per level that has instances, sorted by the level's first instance
+                if (useInstancing)
+                {
+                    pickupInstances.update(snapshot.pickups, pickupBuckets.order, camera);
+                    for (int level = 0; level < pickupLodSelector.levelCount(); ++level)
+                    {
+                        if (pickupBuckets.count(level) > 0)
+                        {
+                            MeshHandle mesh = sphereLods[level];
+                            renderQueue.drawInstanced(RENDER_PASS_OPAQUE, PROGRAM_INSTANCED, meshRegistry.range(mesh).vertexFormat, mesh,
+                                RENDER_NO_MATERIAL, snapshot.pickups.position[pickupBuckets.order[pickupBuckets.offsets[level]]],
+                                static_cast<uint32_t>(pickupBuckets.offsets[level]), static_cast<uint32_t>(pickupBuckets.count(level)));
+                            sphereStats.drawCalls += 1;
+                        }
+                    }
+                }
+                else
+                {
+                    for (int level = 0; level < pickupLodSelector.levelCount(); ++level)
+                    {
+                        MeshHandle mesh = sphereLods[level];
+                        for (size_t slot = pickupBuckets.offsets[level]; slot < pickupBuckets.offsets[level + 1]; ++slot)
+                        {
+                            uint32_t i = pickupBuckets.order[slot];
+                            glm::mat4 sphereModel = translateScale(snapshot.pickups.position[i], snapshot.pickups.scale[i]);
+                            renderQueue.draw(RENDER_PASS_OPAQUE, PROGRAM_BASIC, meshRegistry.range(mesh).vertexFormat, mesh,
+                                snapshot.pickups.color[i], sphereModel);
+                        }
+                    }
+                    sphereStats.drawCalls += visiblePickups.size();
+                }
+
+                // Triangle Stats
+                size_t sphereTriangles = 0;
+                for (int level = 0; level < pickupLodSelector.levelCount(); ++level)
+                {
+                    sphereTriangles += pickupBuckets.count(level) * (meshRegistry.range(sphereLods[level]).indexCount / 3);
+                    sphereStats.lodInstances[level] += pickupBuckets.count(level);
+                }
+                sphereStats.triangles += sphereTriangles;
+                sphereStats.fullDetailTriangles += visiblePickups.size() * (meshRegistry.range(sphereLods[0]).indexCount / 3);
+                PROFILE_COUNTER("Sphere Triangles", sphereTriangles);
+                sphereStats.submitMs += sphereTimer.elapsedMs();
+                sphereStats.frames += 1;
             }
         }
         else 
         {
-            // Draw Sphere Inside
+            PROFILE_SCOPE("Record Draws");
+
+            // Sphere Inside
             glm::vec3 greenSpherePosition = glm::vec3(0.35f, -0.4f, -0.3f);
-            glBindVertexArray(sphereVAO);
             glm::mat4 sphereModel = glm::mat4(1.0f);
             sphereModel = glm::translate(sphereModel, greenSpherePosition);
-            glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(sphereModel));
-            glUniform4f(colorLoc, 0.0f, 1.0f, 0.0f, 1.0f); // RGBA green
-            glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(sphereIndices.size()), GL_UNSIGNED_INT, 0);
-            glBindVertexArray(0);
-
-            // Draw Player Inside
-            glBindVertexArray(playerVAO);
-            glm::mat4 playerModel = glm::mat4(1.0f);
-            playerModel = glm::translate(playerModel, playerPosition);
-            playerModel = glm::scale(playerModel, glm::vec3(0.1f));
-            glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(playerModel));
-            glUniform4f(colorLoc, 0.5f, 0.0f, 0.5f, 1.0f); // RGBA purple
-            glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
-            glBindVertexArray(0);
-
-            // Draw Interior
-            glBindVertexArray(houseInteriorVAO);
-            glUniform4f(colorLoc, 0.8f, 0.8f, 0.8f, 1.0f); // RGBA grey
-            glm::mat4 model = glm::mat4(1.0f);
-            model = glm::translate(model, glm::vec3(0.0f, 0.0f, 0.0f));
-            model = glm::scale(model, glm::vec3(1.0f, 1.0f, 1.0f));
-            glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-            glDrawElements(GL_TRIANGLES, sizeof(houseInteriorIndices) / sizeof(GLuint), GL_UNSIGNED_INT, 0);
-            glBindVertexArray(0);
+            recordDraw(renderQueue, meshRegistry, frustum, cullStats, meshes[MESH_SPHERE], glm::vec4(0.0f, 1.0f, 0.0f, 1.0f), sphereModel); // RGBA green
+
+            // Player Inside
+            glm::mat4 playerModel = translateScale(snapshot.players.interpolatedPosition(snapshot.players.indexOf(snapshot.player), alpha), 0.1f);
+            recordDraw(renderQueue, meshRegistry, frustum, cullStats, meshes[MESH_PLAYER], PLAYER_COLOR, playerModel);
+
+            // Interior
+            recordDraw(renderQueue, meshRegistry, frustum, cullStats, meshes[MESH_INTERIOR], glm::vec4(0.8f, 0.8f, 0.8f, 1.0f),
+                snapshot.transforms.world(snapshot.sceneNodes.interior)); // RGBA grey
         }
 
-        glfwSwapBuffers(window);
+        // Sort and Submit
+        {
+            PROFILE_SCOPE("Sort Draws");
+            BenchmarkTimer sortTimer;
+            renderQueue.sort();
+            renderQueueStats.sortMs += sortTimer.elapsedMs();
+        }
+        {
+            PROFILE_SCOPE("Compute MVPs");
+            renderQueue.computeMvps(camera.viewProjection());
+        }
+        {
+            PROFILE_DRAW("Submit Draws");
+            meshRegistry.bind();
+            submitRenderQueue(renderQueue, renderPrograms, mvpLoc, colorLoc, meshRegistry, pickupInstances);
+        }
+        renderQueueStats.draws += renderQueue.size();
+        addStateChanges(renderQueueStats.recorded, renderQueue.recordedChanges());
+        addStateChanges(renderQueueStats.sorted, renderQueue.sortedChanges());
+        renderQueueStats.frames += 1;
+        PROFILE_COUNTER("State Changes Recorded", renderQueue.recordedChanges().total());
+        PROFILE_COUNTER("State Changes Sorted", renderQueue.sortedChanges().total());
+        PROFILE_COUNTER("Visible Objects", cullStats.visible);
+        PROFILE_COUNTER("Culled Objects", cullStats.culled);
+        jobs.publishUtilization();
+        timings.renderMs += renderTimer.elapsedMs();
+        timings.frames += 1;
+        if (printTimings)
+        {
+            reportFrameTimings(timings, simulation.stats(), now);
+            reportRenderQueueStats(renderQueueStats, now);
+            reportSphereDrawStats(sphereStats, snapshot.pickups.size(), now);
+        }
+
+        {
+            PROFILE_SCOPE("glfwSwapBuffers");
+            glfwSwapBuffers(window);
+        }
         glfwPollEvents();
     }
+    simulation.stop();
 
     // Delete Resources
-    glDeleteVertexArrays(1, &planeVAO);
-    glDeleteBuffers(1, &planeVBO);
-    glDeleteBuffers(1, &planeEBO);
-    glDeleteVertexArrays(1, &houseVAO);
-    glDeleteBuffers(1, &houseVBO);
-    glDeleteBuffers(1, &houseEBO);
-    glDeleteVertexArrays(1, &playerVAO);
-    glDeleteBuffers(1, &playerVBO);
-    glDeleteBuffers(1, &playerEBO);
-    glDeleteVertexArrays(1, &sphereVAO);
-    glDeleteBuffers(1, &sphereVBO);
-    glDeleteBuffers(1, &sphereEBO);
-    glDeleteVertexArrays(1, &npcVAO);
-    glDeleteBuffers(1, &npcVBO);
-    glDeleteBuffers(1, &npcEBO);
-    glDeleteVertexArrays(1, &houseInteriorVAO);
-    glDeleteBuffers(1, &houseInteriorVBO);
-    glDeleteBuffers(1, &houseInteriorEBO);
-    glDeleteProgram(shaderProgram);
+#ifdef ENABLE_PROFILER
+    gpuProfiler.destroy();
+#endif
+    streamer.unloadAll(meshRegistry);
+    meshRegistry.destroy();
+    pickupInstances.destroy();
+    shaderProgram.destroy();
+    instancedProgram.destroy();
 }
 
-int main()
+int main(int argc, char* argv[])
 {
+    // Benchmarks run without a window: --bench <name>
+    if (argc > 2 && std::string(argv[1]) == "--bench")
+    {
+        return runBenchmark(argv[2]) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    PROFILE_THREAD_NAME("Main");
+    std::future<void> sphereGeneration = std::async(std::launch::async, []()
+    {
+        meshGenerator.uvSphere(SPHERE_RADIUS, SPHERE_SECTORS, SPHERE_STACKS, SPHERE_LOD_LEVELS);
+    });
     initWindow();
-    createSphere(0.05f, SPHERE_SECTORS, SPHERE_STACKS);
-    npcPosition = npcPosition1;
-    renderLoop(glfwGetCurrentContext());
+    initWorld(world);
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+
+        // Extra pickups scattered over the ground plane: --pickups <count>
+        if (argument == "--pickups" && i + 1 < argc)
+        {
+            size_t count = 0;
+            if (parseCountArgument("--pickups", argv[++i], count))
+            {
+                scatterPickups(world.pickups, world.pickupIndex, count, glm::vec3(-2.0f, -0.4f, -2.0f), glm::vec3(2.0f, -0.4f, 3.0f), 42);
+            }
+        }
+        else if (argument == "--tick-rate" && i + 1 < argc)
+        {
+            parsePositiveArgument("--tick-rate", argv[++i], tickRate);
+        }
+        else if (argument == "--vsync")
+        {
+            vsync = true;
+        }
+        else if (argument == "--timings")
+        {
+            printTimings = true;
+        }
+        else if (argument == "--record" && i + 1 < argc)
+        {
+            recordPath = argv[++i];
+        }
+        else if (argument == "--scene" && i + 1 < argc)
+        {
+            if (scene.open(argv[++i]))
+            {
+                loadSceneEntities(world, scene);
+            }
+        }
+        else if (argument == "--workers" && i + 1 < argc)
+        {
+            parseCountArgument("--workers", argv[++i], workerCount);
+        }
+        else if (argument == "--spline" && i + 1 < argc)
+        {
+            splinePath = argv[++i];
+        }
+        else if (argument == "--gpu-budget" && i + 1 < argc)
+        {
+            // At least 1 KB, and no more than fits in bytes
+            parseCountArgument("--gpu-budget", argv[++i], gpuBudgetKb, 1, std::numeric_limits<size_t>::max() / 1024);
+        }
+        else if (argument == "--vertex-format" && i + 1 < argc)
+        {
+            if (!parseVertexFormat(argv[++i], compactVertexFormat))
+            {
+                std::cerr << "Unknown vertex format: " << argv[i] << std::endl;
+            }
+        }
+    }
+
+    // After the scene, which may replace the NPCs
+    std::vector<glm::vec3> splinePoints;
+    if (splinePath != "none" && loadSplinePoints(splinePath, splinePoints) && !addSplineNpc(world, splinePoints))
+    {
+        std::cerr << "Not enough points for a spline: " << splinePath << std::endl;
+    }
+
+    // Workers for culling, LOD selection and NPC updates; the main and simulation threads join in while they wait
+    JobSystem jobs(workerCount);
+    jobs.registerThread();
+    world.jobs = &jobs;
+
+    // The mesh cache is filled by now in all but the slowest cases
+    sphereGeneration.wait();
+    renderLoop(glfwGetCurrentContext(), jobs);
+    world.jobs = nullptr;
+
+    if (!recordPath.empty())
+    {
+        recording.tickRate = tickRate;
+        recording.save(recordPath);
+    }
+
+#ifdef ENABLE_PROFILER
+    profilerWriteChromeTrace(PROFILE_PATH);
+#endif
     glfwTerminate();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,261 @@
+#include "Crowd.h"
+#include "SimdMath.h"
+
+uint32_t CrowdRoutes::add(const glm::vec3* waypoints, size_t waypointCount, float routeSpeed)
+{
+    uint32_t start = static_cast<uint32_t>(x.size());
+    for (size_t i = 0; i < waypointCount; ++i)
+    {
+        size_t previous = x.size() - 1;
+        if (x.size() > start && x[previous] == waypoints[i].x && y[previous] == waypoints[i].y && z[previous] == waypoints[i].z)
+        {
+            continue;
+        }
+        x.push_back(waypoints[i].x);
+        y.push_back(waypoints[i].y);
+        z.push_back(waypoints[i].z);
+    }
+
+    // The route loops, so a last waypoint equal to the first is a duplicate too
+    size_t last = x.size() - 1;
+    if (x.size() > start + 1 && x[last] == x[start] && y[last] == y[start] && z[last] == z[start])
+    {
+        x.pop_back();
+        y.pop_back();
+        z.pop_back();
+    }
+
+    first.push_back(start);
+    count.push_back(static_cast<uint32_t>(x.size()) - start);
+    speed.push_back(routeSpeed);
+    return static_cast<uint32_t>(first.size() - 1);
+}
+
+void CrowdRoutes::clear()
+{
+    x.clear();
+    y.clear();
+    z.clear();
+    first.clear();
+    count.clear();
+    speed.clear();
+}
+
+void assignRoute(EntityStore& npcs, size_t index, const CrowdRoutes& routes, uint32_t route)
+{
+    uint32_t next = routes.count[route] > 1 ? 1 : 0;
+    glm::vec3 from = routes.waypoint(route, 0);
+    glm::vec3 to = routes.waypoint(route, next);
+
+    npcs.position[index] = from;
+    npcs.previousPosition[index] = from;
+    npcs.waypointFrom[index] = from;
+    npcs.waypointTo[index] = to;
+    npcs.route[index] = route;
+    npcs.waypointIndex[index] = next;
+
+    glm::vec3 direction = to - from;
+    float length = glm::length(direction);
+    npcs.velocity[index] = length > 0.0f ? direction * (routes.speed[route] / length) : glm::vec3(0.0f);
+}
+
+void updateCrowdScalar(EntityStore& npcs, const CrowdRoutes& routes, size_t begin, size_t end, float deltaTime)
+{
+    glm::vec3* position = npcs.position.data();
+    glm::vec3* velocity = npcs.velocity.data();
+    glm::vec3* from = npcs.waypointFrom.data();
+    glm::vec3* to = npcs.waypointTo.data();
+    uint32_t* route = npcs.route.data();
+    uint32_t* waypointIndex = npcs.waypointIndex.data();
+
+    for (size_t i = begin; i < end; ++i)
+    {
+        position[i] += velocity[i] * deltaTime;
+        bool moving = glm::dot(velocity[i], velocity[i]) > 0.0f;
+        if (moving && glm::dot(to[i] - position[i], velocity[i]) <= 0.0f)
+        {
+            uint32_t r = route[i];
+            uint32_t next = waypointIndex[i] + 1;
+            next = next >= routes.count[r] ? 0 : next;
+            glm::vec3 target = routes.waypoint(r, next);
+
+            position[i] = to[i];
+            from[i] = to[i];
+            to[i] = target;
+            waypointIndex[i] = next;
+
+            glm::vec3 direction = target - position[i];
+            float length = glm::length(direction);
+            velocity[i] = length > 0.0f ? direction * (routes.speed[r] / length) : glm::vec3(0.0f);
+        }
+    }
+}
+
+#if SIMD_SSE
+
+// SIMD Lanes
+// The few operations the crowd kernel needs, for four SSE lanes and eight AVX
+// lanes. Positions stay packed vec3s in the store and are transposed to x, y
+// and z registers on load and back on store, see SimdMath.h.
+struct Lanes4
+{
+    typedef __m128 Float;
+    static const int WIDTH = 4;
+
+    static Float set1(float value) { return _mm_set1_ps(value); }
+    static Float zero() { return _mm_setzero_ps(); }
+    static Float load(const float* values) { return _mm_loadu_ps(values); }
+    static Float add(Float a, Float b) { return _mm_add_ps(a, b); }
+    static Float sub(Float a, Float b) { return _mm_sub_ps(a, b); }
+    static Float mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+    static Float div(Float a, Float b) { return _mm_div_ps(a, b); }
+    static Float sqrt(Float a) { return _mm_sqrt_ps(a); }
+    static Float bitAnd(Float a, Float b) { return _mm_and_ps(a, b); }
+    static Float lessEqual(Float a, Float b) { return _mm_cmple_ps(a, b); }
+    static Float greater(Float a, Float b) { return _mm_cmpgt_ps(a, b); }
+    static int mask(Float a) { return _mm_movemask_ps(a); }
+
+    // b where mask is set, a elsewhere
+    static Float select(Float a, Float b, Float mask) { return _mm_or_ps(_mm_and_ps(mask, b), _mm_andnot_ps(mask, a)); }
+
+    static void load3(const glm::vec3* vectors, Float& x, Float& y, Float& z) { loadVec3x4(&vectors[0].x, x, y, z); }
+    static void store3(glm::vec3* vectors, Float x, Float y, Float z) { storeVec3x4(&vectors[0].x, x, y, z); }
+};
+
+#if SIMD_AVX
+
+struct Lanes8
+{
+    typedef __m256 Float;
+    static const int WIDTH = 8;
+
+    static Float set1(float value) { return _mm256_set1_ps(value); }
+    static Float zero() { return _mm256_setzero_ps(); }
+    static Float load(const float* values) { return _mm256_loadu_ps(values); }
+    static Float add(Float a, Float b) { return _mm256_add_ps(a, b); }
+    static Float sub(Float a, Float b) { return _mm256_sub_ps(a, b); }
+    static Float mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+    static Float div(Float a, Float b) { return _mm256_div_ps(a, b); }
+    static Float sqrt(Float a) { return _mm256_sqrt_ps(a); }
+    static Float bitAnd(Float a, Float b) { return _mm256_and_ps(a, b); }
+    static Float lessEqual(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+    static Float greater(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    static int mask(Float a) { return _mm256_movemask_ps(a); }
+    static Float select(Float a, Float b, Float mask) { return _mm256_blendv_ps(a, b, mask); }
+
+    static void load3(const glm::vec3* vectors, Float& x, Float& y, Float& z) { loadVec3x8(&vectors[0].x, x, y, z); }
+    static void store3(glm::vec3* vectors, Float x, Float y, Float z) { storeVec3x8(&vectors[0].x, x, y, z); }
+};
+
+#endif
+
+template <typename Lanes>
+static typename Lanes::Float dot3(typename Lanes::Float ax, typename Lanes::Float ay, typename Lanes::Float az,
+    typename Lanes::Float bx, typename Lanes::Float by, typename Lanes::Float bz)
+{
+    return Lanes::add(Lanes::add(Lanes::mul(ax, bx), Lanes::mul(ay, by)), Lanes::mul(az, bz));
+}
+
+// Runs whole groups of Lanes::WIDTH entities from begin, returns where it stopped.
+// The operations are the ones updateCrowdScalar does, in the same order, so the
+// results are identical.
+template <typename Lanes>
+static size_t updateCrowdLanes(EntityStore& npcs, const CrowdRoutes& routes, size_t begin, size_t end, float deltaTime)
+{
+    typedef typename Lanes::Float Float;
+    const int WIDTH = Lanes::WIDTH;
+
+    glm::vec3* position = npcs.position.data();
+    glm::vec3* velocity = npcs.velocity.data();
+    glm::vec3* from = npcs.waypointFrom.data();
+    glm::vec3* to = npcs.waypointTo.data();
+    uint32_t* route = npcs.route.data();
+    uint32_t* waypointIndex = npcs.waypointIndex.data();
+
+    Float step = Lanes::set1(deltaTime);
+    Float zero = Lanes::zero();
+
+    size_t i = begin;
+    for (; i + WIDTH <= end; i += WIDTH)
+    {
+        Float px, py, pz, vx, vy, vz, tx, ty, tz;
+        Lanes::load3(position + i, px, py, pz);
+        Lanes::load3(velocity + i, vx, vy, vz);
+        Lanes::load3(to + i, tx, ty, tz);
+
+        px = Lanes::add(px, Lanes::mul(vx, step));
+        py = Lanes::add(py, Lanes::mul(vy, step));
+        pz = Lanes::add(pz, Lanes::mul(vz, step));
+
+        Float moving = Lanes::greater(dot3<Lanes>(vx, vy, vz, vx, vy, vz), zero);
+        Float ahead = dot3<Lanes>(Lanes::sub(tx, px), Lanes::sub(ty, py), Lanes::sub(tz, pz), vx, vy, vz);
+        Float arrived = Lanes::bitAnd(moving, Lanes::lessEqual(ahead, zero));
+
+        // Most ticks nobody in the group arrives
+        int arrivedMask = Lanes::mask(arrived);
+        if (arrivedMask != 0)
+        {
+            // Lanes that haven't arrived read route 0's first waypoint and keep their state
+            float nextX[WIDTH], nextY[WIDTH], nextZ[WIDTH], nextSpeed[WIDTH];
+            for (int lane = 0; lane < WIDTH; ++lane)
+            {
+                bool hit = ((arrivedMask >> lane) & 1) != 0;
+                uint32_t r = hit ? route[i + lane] : 0;
+                uint32_t next = hit ? waypointIndex[i + lane] + 1 : 0;
+                next = next >= routes.count[r] ? 0 : next;
+                uint32_t slot = routes.first[r] + next;
+                nextX[lane] = routes.x[slot];
+                nextY[lane] = routes.y[slot];
+                nextZ[lane] = routes.z[slot];
+                nextSpeed[lane] = routes.speed[r];
+                waypointIndex[i + lane] = hit ? next : waypointIndex[i + lane];
+            }
+            Float nx = Lanes::load(nextX);
+            Float ny = Lanes::load(nextY);
+            Float nz = Lanes::load(nextZ);
+
+            px = Lanes::select(px, tx, arrived);
+            py = Lanes::select(py, ty, arrived);
+            pz = Lanes::select(pz, tz, arrived);
+
+            // Normalize the new leg; a zero length leg divides by zero and is masked to no velocity
+            Float dx = Lanes::sub(nx, px);
+            Float dy = Lanes::sub(ny, py);
+            Float dz = Lanes::sub(nz, pz);
+            Float length = Lanes::sqrt(dot3<Lanes>(dx, dy, dz, dx, dy, dz));
+            Float scale = Lanes::div(Lanes::load(nextSpeed), length);
+            Float valid = Lanes::greater(length, zero);
+            vx = Lanes::select(vx, Lanes::bitAnd(Lanes::mul(dx, scale), valid), arrived);
+            vy = Lanes::select(vy, Lanes::bitAnd(Lanes::mul(dy, scale), valid), arrived);
+            vz = Lanes::select(vz, Lanes::bitAnd(Lanes::mul(dz, scale), valid), arrived);
+            Lanes::store3(velocity + i, vx, vy, vz);
+
+            Float fx, fy, fz;
+            Lanes::load3(from + i, fx, fy, fz);
+            Lanes::store3(from + i, Lanes::select(fx, tx, arrived), Lanes::select(fy, ty, arrived), Lanes::select(fz, tz, arrived));
+            Lanes::store3(to + i, Lanes::select(tx, nx, arrived), Lanes::select(ty, ny, arrived), Lanes::select(tz, nz, arrived));
+        }
+
+        Lanes::store3(position + i, px, py, pz);
+    }
+    return i;
+}
+
+void updateCrowd(EntityStore& npcs, const CrowdRoutes& routes, size_t begin, size_t end, float deltaTime)
+{
+    size_t i = begin;
+#if SIMD_AVX
+    i = updateCrowdLanes<Lanes8>(npcs, routes, i, end, deltaTime);
+#endif
+    i = updateCrowdLanes<Lanes4>(npcs, routes, i, end, deltaTime);
+    updateCrowdScalar(npcs, routes, i, end, deltaTime);
+}
+
+#else
+
+void updateCrowd(EntityStore& npcs, const CrowdRoutes& routes, size_t begin, size_t end, float deltaTime)
+{
+    updateCrowdScalar(npcs, routes, begin, end, deltaTime);
+}
+
+#endif
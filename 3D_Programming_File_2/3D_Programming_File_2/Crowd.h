@@ -0,0 +1,51 @@
+#pragma once
+
+#include <glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "EntityStore.h"
+
+// Crowd Routes
+// Looping waypoint lists shared by any number of NPCs. The waypoints of every
+// route are stored back to back in separate x, y and z columns, route r being
+// waypoints first[r] .. first[r] + count[r] - 1, walked at speed[r].
+struct CrowdRoutes
+{
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+
+    std::vector<uint32_t> first;
+    std::vector<uint32_t> count;
+    std::vector<float> speed;
+
+    // Needs at least one waypoint. Consecutive duplicate waypoints are dropped,
+    // so every leg has a direction. Returns the route's id.
+    uint32_t add(const glm::vec3* waypoints, size_t waypointCount, float speed);
+
+    glm::vec3 waypoint(uint32_t route, uint32_t index) const
+    {
+        uint32_t slot = first[route] + index;
+        return glm::vec3(x[slot], y[slot], z[slot]);
+    }
+
+    size_t size() const { return first.size(); }
+    void clear();
+};
+
+// Puts an entity on its route's first waypoint, heading for the second
+void assignRoute(EntityStore& npcs, size_t index, const CrowdRoutes& routes, uint32_t route);
+
+// Crowd Update
+// Moves entities [begin, end) of a store along their routes for one tick.
+// Velocity is fixed per leg, so a tick is a multiply-add per entity; an entity
+// has arrived once it no longer moves towards its target, which also catches
+// steps that would jump over a fixed arrival radius. Arriving entities snap to
+// the target and turn towards the next waypoint of their route, looping at the
+// end. Entities that don't move never arrive, so NO_ROUTE is never looked up.
+// The SIMD version runs four entities at a time with SSE, or eight in AVX builds,
+// switches waypoints with masks instead of branches and matches
+// updateCrowdScalar bit for bit.
+void updateCrowd(EntityStore& npcs, const CrowdRoutes& routes, size_t begin, size_t end, float deltaTime);
+void updateCrowdScalar(EntityStore& npcs, const CrowdRoutes& routes, size_t begin, size_t end, float deltaTime);
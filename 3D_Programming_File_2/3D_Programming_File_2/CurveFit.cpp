@@ -0,0 +1,453 @@
+#include "CurveFit.h"
+#include <algorithm>
+#include <cmath>
+#include "SimdMath.h"
+
+// Knots within this fraction of the average spacing from an even grid count as
+// even; the lookup corrects the guess by a step, so rounded knots still qualify
+static const double EVEN_SPACING_TOLERANCE = 0.25;
+
+// Piecewise Cubic
+size_t CubicCurve::segmentOf(float x) const
+{
+    ptrdiff_t last = static_cast<ptrdiff_t>(segments.size()) - 1;
+    if (spacing > 0.0f)
+    {
+        ptrdiff_t segment = static_cast<ptrdiff_t>(std::floor((x - knots[0]) / spacing));
+        segment = std::min(std::max<ptrdiff_t>(segment, 0), last);
+        segment -= segment > 0 && x < knots[segment] ? 1 : 0;
+        segment += segment < last && x >= knots[segment + 1] ? 1 : 0;
+        return static_cast<size_t>(segment);
+    }
+
+    // Branchless binary search for the last knot at or before x, the halving doesn't depend on the comparisons
+    const float* base = knots.data();
+    size_t count = static_cast<size_t>(last) + 1;
+    while (count > 1)
+    {
+        size_t half = count / 2;
+        base = base[half] <= x ? base + half : base;
+        count -= half;
+    }
+    return static_cast<size_t>(base - knots.data());
+}
+
+float CubicCurve::evaluate(float x) const
+{
+    size_t segment = segmentOf(x);
+    const glm::vec4& k = segments[segment];
+    float t = x - knots[segment];
+    return ((k.w * t + k.z) * t + k.y) * t + k.x;
+}
+
+float CubicCurve::slope(float x) const
+{
+    size_t segment = segmentOf(x);
+    const glm::vec4& k = segments[segment];
+    float t = x - knots[segment];
+    return (3.0f * k.w * t + 2.0f * k.z) * t + k.y;
+}
+
+void CubicCurve::evaluateScalar(const float* x, float* y, size_t count) const
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        y[i] = evaluate(x[i]);
+    }
+}
+
+// Polynomial
+float Polynomial::evaluate(float x) const
+{
+    float u = (x - center) * scale;
+    float result = 0.0f;
+    for (size_t k = coefficients.size(); k-- > 0;)
+    {
+        result = result * u + coefficients[k];
+    }
+    return result;
+}
+
+void Polynomial::evaluateScalar(const float* x, float* y, size_t count) const
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        y[i] = evaluate(x[i]);
+    }
+}
+
+#if SIMD_SSE
+
+// SIMD Lanes
+// Horner's rule needs multiplies and adds; segment coefficients are gathered
+// one vec4 per lane and transposed into a, b, c and d registers.
+struct CurveLanes4
+{
+    typedef __m128 Float;
+    static const int WIDTH = 4;
+
+    static Float set1(float value) { return _mm_set1_ps(value); }
+    static Float zero() { return _mm_setzero_ps(); }
+    static Float load(const float* values) { return _mm_loadu_ps(values); }
+    static void store(float* values, Float a) { _mm_storeu_ps(values, a); }
+    static Float add(Float a, Float b) { return _mm_add_ps(a, b); }
+    static Float sub(Float a, Float b) { return _mm_sub_ps(a, b); }
+    static Float mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+
+    static void loadSegments(const glm::vec4* segments, const uint32_t* index, Float& a, Float& b, Float& c, Float& d)
+    {
+        a = _mm_loadu_ps(&segments[index[0]].x);
+        b = _mm_loadu_ps(&segments[index[1]].x);
+        c = _mm_loadu_ps(&segments[index[2]].x);
+        d = _mm_loadu_ps(&segments[index[3]].x);
+        _MM_TRANSPOSE4_PS(a, b, c, d);
+    }
+};
+
+#if SIMD_AVX
+
+struct CurveLanes8
+{
+    typedef __m256 Float;
+    static const int WIDTH = 8;
+
+    static Float set1(float value) { return _mm256_set1_ps(value); }
+    static Float zero() { return _mm256_setzero_ps(); }
+    static Float load(const float* values) { return _mm256_loadu_ps(values); }
+    static void store(float* values, Float a) { _mm256_storeu_ps(values, a); }
+    static Float add(Float a, Float b) { return _mm256_add_ps(a, b); }
+    static Float sub(Float a, Float b) { return _mm256_sub_ps(a, b); }
+    static Float mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+
+    static void loadSegments(const glm::vec4* segments, const uint32_t* index, Float& a, Float& b, Float& c, Float& d)
+    {
+        __m128 a0, b0, c0, d0, a1, b1, c1, d1;
+        CurveLanes4::loadSegments(segments, index, a0, b0, c0, d0);
+        CurveLanes4::loadSegments(segments, index + 4, a1, b1, c1, d1);
+        a = _mm256_insertf128_ps(_mm256_castps128_ps256(a0), a1, 1);
+        b = _mm256_insertf128_ps(_mm256_castps128_ps256(b0), b1, 1);
+        c = _mm256_insertf128_ps(_mm256_castps128_ps256(c0), c1, 1);
+        d = _mm256_insertf128_ps(_mm256_castps128_ps256(d0), d1, 1);
+    }
+};
+
+#endif
+
+// Runs whole groups of Lanes::WIDTH queries from begin, returns where it stopped.
+// The segment lookup stays scalar; the operations after it are the scalar ones in the same order.
+template <typename Lanes>
+static size_t evaluateCubicLanes(const CubicCurve& curve, const float* x, float* y, size_t begin, size_t end)
+{
+    typedef typename Lanes::Float Float;
+    const int WIDTH = Lanes::WIDTH;
+
+    size_t i = begin;
+    for (; i + WIDTH <= end; i += WIDTH)
+    {
+        uint32_t index[WIDTH];
+        float knot[WIDTH];
+        for (int lane = 0; lane < WIDTH; ++lane)
+        {
+            index[lane] = static_cast<uint32_t>(curve.segmentOf(x[i + lane]));
+            knot[lane] = curve.knots[index[lane]];
+        }
+
+        Float a, b, c, d;
+        Lanes::loadSegments(curve.segments.data(), index, a, b, c, d);
+        Float t = Lanes::sub(Lanes::load(x + i), Lanes::load(knot));
+        Float result = Lanes::add(Lanes::mul(Lanes::add(Lanes::mul(Lanes::add(Lanes::mul(d, t), c), t), b), t), a);
+        Lanes::store(y + i, result);
+    }
+    return i;
+}
+
+template <typename Lanes>
+static size_t evaluatePolynomialLanes(const Polynomial& polynomial, const float* x, float* y, size_t begin, size_t end)
+{
+    typedef typename Lanes::Float Float;
+    const int WIDTH = Lanes::WIDTH;
+
+    Float center = Lanes::set1(polynomial.center);
+    Float scale = Lanes::set1(polynomial.scale);
+    const float* coefficients = polynomial.coefficients.data();
+    size_t terms = polynomial.coefficients.size();
+
+    size_t i = begin;
+    for (; i + WIDTH <= end; i += WIDTH)
+    {
+        Float u = Lanes::mul(Lanes::sub(Lanes::load(x + i), center), scale);
+        Float result = Lanes::zero();
+        for (size_t k = terms; k-- > 0;)
+        {
+            result = Lanes::add(Lanes::mul(result, u), Lanes::set1(coefficients[k]));
+        }
+        Lanes::store(y + i, result);
+    }
+    return i;
+}
+
+void CubicCurve::evaluate(const float* x, float* y, size_t count) const
+{
+    size_t i = 0;
+#if SIMD_AVX
+    i = evaluateCubicLanes<CurveLanes8>(*this, x, y, i, count);
+#endif
+    i = evaluateCubicLanes<CurveLanes4>(*this, x, y, i, count);
+    evaluateScalar(x + i, y + i, count - i);
+}
+
+void Polynomial::evaluate(const float* x, float* y, size_t count) const
+{
+    size_t i = 0;
+#if SIMD_AVX
+    i = evaluatePolynomialLanes<CurveLanes8>(*this, x, y, i, count);
+#endif
+    i = evaluatePolynomialLanes<CurveLanes4>(*this, x, y, i, count);
+    evaluateScalar(x + i, y + i, count - i);
+}
+
+#else
+
+void CubicCurve::evaluate(const float* x, float* y, size_t count) const
+{
+    evaluateScalar(x, y, count);
+}
+
+void Polynomial::evaluate(const float* x, float* y, size_t count) const
+{
+    evaluateScalar(x, y, count);
+}
+
+#endif
+
+// Curve Fitting
+static bool increasing(const float* x, size_t count)
+{
+    for (size_t i = 1; i < count; ++i)
+    {
+        if (!(x[i] > x[i - 1]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void setKnots(const float* x, size_t count, CubicCurve& curve)
+{
+    curve.knots.assign(x, x + count);
+    curve.segments.resize(count - 1);
+
+    double spacing = (double(x[count - 1]) - x[0]) / (count - 1);
+    curve.spacing = static_cast<float>(spacing);
+    for (size_t i = 1; i + 1 < count; ++i)
+    {
+        if (std::fabs(x[i] - (x[0] + i * spacing)) > spacing * EVEN_SPACING_TOLERANCE)
+        {
+            curve.spacing = 0.0f;
+            break;
+        }
+    }
+}
+
+// Segment from its end values and end slopes. This is the curve glm::hermite
+// draws, kept as power coefficients so evaluation is one Horner step per lane
+static glm::vec4 hermiteSegment(double h, double y0, double y1, double m0, double m1)
+{
+    double secant = (y1 - y0) / h;
+    return glm::vec4(static_cast<float>(y0), static_cast<float>(m0),
+        static_cast<float>((3.0 * secant - 2.0 * m0 - m1) / h), static_cast<float>((m0 + m1 - 2.0 * secant) / (h * h)));
+}
+
+// Solves a tridiagonal system in place (Thomas algorithm): below[i] x[i - 1] + diagonal[i] x[i] + above[i] x[i + 1] = right[i]
+static void solveTridiagonal(std::vector<double>& below, std::vector<double>& diagonal, std::vector<double>& above, std::vector<double>& right)
+{
+    size_t n = diagonal.size();
+    for (size_t i = 1; i < n; ++i)
+    {
+        double factor = below[i] / diagonal[i - 1];
+        diagonal[i] -= factor * above[i - 1];
+        right[i] -= factor * right[i - 1];
+    }
+    right[n - 1] /= diagonal[n - 1];
+    for (size_t i = n - 1; i-- > 0;)
+    {
+        right[i] = (right[i] - above[i] * right[i + 1]) / diagonal[i];
+    }
+}
+
+bool fitCubicSpline(const float* x, const float* y, size_t count, CubicCurve& curve, SplineEnd end)
+{
+    if (count < 2 || !increasing(x, count))
+    {
+        return false;
+    }
+    setKnots(x, count, curve);
+
+    std::vector<double> h(count - 1);
+    for (size_t i = 0; i + 1 < count; ++i)
+    {
+        h[i] = double(x[i + 1]) - x[i];
+    }
+
+    // Second derivatives M; the interior rows are
+    // h[i - 1] M[i - 1] + 2 (h[i - 1] + h[i]) M[i] + h[i] M[i + 1] = 6 (secant[i] - secant[i - 1])
+    std::vector<double> curvature(count, 0.0);
+    size_t unknowns = count >= 3 ? count - 2 : 0;
+    if (unknowns > 0)
+    {
+        std::vector<double> below(unknowns), diagonal(unknowns), above(unknowns), right(unknowns);
+        for (size_t row = 0; row < unknowns; ++row)
+        {
+            size_t i = row + 1;
+            below[row] = h[i - 1];
+            diagonal[row] = 2.0 * (h[i - 1] + h[i]);
+            above[row] = h[i];
+            right[row] = 6.0 * ((double(y[i + 1]) - y[i]) / h[i] - (double(y[i]) - y[i - 1]) / h[i - 1]);
+        }
+
+        // Not-a-knot sets the third derivative equal across the second and the
+        // second to last knot; M[0] and M[n - 1] are substituted out of the end rows
+        bool notAKnot = end == SPLINE_NOT_A_KNOT && count >= 4;
+        if (notAKnot)
+        {
+            double h0 = h[0], h1 = h[1];
+            diagonal[0] = (h0 + h1) * (h0 + 2.0 * h1);
+            above[0] = h1 * h1 - h0 * h0;
+            right[0] *= h1;
+
+            double hn = h[count - 2], hm = h[count - 3];
+            diagonal[unknowns - 1] = (hn + hm) * (hn + 2.0 * hm);
+            below[unknowns - 1] = hm * hm - hn * hn;
+            right[unknowns - 1] *= hm;
+        }
+        solveTridiagonal(below, diagonal, above, right);
+        std::copy(right.begin(), right.end(), curvature.begin() + 1);
+
+        if (notAKnot)
+        {
+            curvature[0] = ((h[0] + h[1]) * curvature[1] - h[0] * curvature[2]) / h[1];
+            size_t n = count - 1;
+            curvature[n] = ((h[n - 1] + h[n - 2]) * curvature[n - 1] - h[n - 1] * curvature[n - 2]) / h[n - 2];
+        }
+    }
+
+    for (size_t i = 0; i + 1 < count; ++i)
+    {
+        double secant = (double(y[i + 1]) - y[i]) / h[i];
+        curve.segments[i] = glm::vec4(y[i],
+            static_cast<float>(secant - h[i] * (2.0 * curvature[i] + curvature[i + 1]) / 6.0),
+            static_cast<float>(curvature[i] / 2.0),
+            static_cast<float>((curvature[i + 1] - curvature[i]) / (6.0 * h[i])));
+    }
+    return true;
+}
+
+bool fitHermite(const float* x, const float* y, const float* slopes, size_t count, CubicCurve& curve)
+{
+    if (count < 2 || !increasing(x, count))
+    {
+        return false;
+    }
+    setKnots(x, count, curve);
+
+    auto slope = [&](size_t i)
+    {
+        if (slopes)
+        {
+            return double(slopes[i]);
+        }
+        size_t before = i > 0 ? i - 1 : i;
+        size_t after = i + 1 < count ? i + 1 : i;
+        return (double(y[after]) - y[before]) / (double(x[after]) - x[before]);
+    };
+    for (size_t i = 0; i + 1 < count; ++i)
+    {
+        curve.segments[i] = hermiteSegment(double(x[i + 1]) - x[i], y[i], y[i + 1], slope(i), slope(i + 1));
+    }
+    return true;
+}
+
+bool fitPolynomial(const float* x, const float* y, size_t count, size_t degree, Polynomial& polynomial)
+{
+    size_t terms = degree + 1;
+    if (count < terms)
+    {
+        return false;
+    }
+
+    double low = *std::min_element(x, x + count);
+    double high = *std::max_element(x, x + count);
+    double center = 0.5 * (low + high);
+    double scale = high > low ? 2.0 / (high - low) : 1.0;
+
+    // Normal equations: sums of u^(j + k) and of y u^j
+    std::vector<double> powerSums(2 * terms - 1, 0.0);
+    std::vector<double> right(terms, 0.0);
+    for (size_t i = 0; i < count; ++i)
+    {
+        double u = (x[i] - center) * scale;
+        double power = 1.0;
+        for (size_t k = 0; k < powerSums.size(); ++k)
+        {
+            powerSums[k] += power;
+            if (k < terms)
+            {
+                right[k] += y[i] * power;
+            }
+            power *= u;
+        }
+    }
+    std::vector<double> matrix(terms * terms);
+    for (size_t row = 0; row < terms; ++row)
+    {
+        for (size_t column = 0; column < terms; ++column)
+        {
+            matrix[row * terms + column] = powerSums[row + column];
+        }
+    }
+
+    // Gaussian elimination with partial pivoting
+    for (size_t column = 0; column < terms; ++column)
+    {
+        size_t pivot = column;
+        for (size_t row = column + 1; row < terms; ++row)
+        {
+            if (std::fabs(matrix[row * terms + column]) > std::fabs(matrix[pivot * terms + column]))
+            {
+                pivot = row;
+            }
+        }
+        if (matrix[pivot * terms + column] == 0.0)
+        {
+            return false;
+        }
+        if (pivot != column)
+        {
+            std::swap_ranges(matrix.begin() + pivot * terms, matrix.begin() + (pivot + 1) * terms, matrix.begin() + column * terms);
+            std::swap(right[pivot], right[column]);
+        }
+        for (size_t row = column + 1; row < terms; ++row)
+        {
+            double factor = matrix[row * terms + column] / matrix[column * terms + column];
+            for (size_t k = column; k < terms; ++k)
+            {
+                matrix[row * terms + k] -= factor * matrix[column * terms + k];
+            }
+            right[row] -= factor * right[column];
+        }
+    }
+    for (size_t row = terms; row-- > 0;)
+    {
+        for (size_t k = row + 1; k < terms; ++k)
+        {
+            right[row] -= matrix[row * terms + k] * right[k];
+        }
+        right[row] /= matrix[row * terms + row];
+    }
+
+    polynomial.center = static_cast<float>(center);
+    polynomial.scale = static_cast<float>(scale);
+    polynomial.coefficients.assign(right.begin(), right.end());
+    return true;
+}
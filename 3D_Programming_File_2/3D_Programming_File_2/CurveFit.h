@@ -0,0 +1,64 @@
+#pragma once
+
+#include <glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Piecewise Cubic
+// y(x) = a + b t + c t^2 + d t^3 with t = x - knots[i] on segment i, which
+// spans knots[i] .. knots[i + 1]. Each segment's coefficients are one vec4
+// (a, b, c, d), so a lookup touches 16 bytes and four segments transpose into
+// four registers. Queries outside the knots extend the end segments.
+struct CubicCurve
+{
+    std::vector<float> knots;
+    std::vector<glm::vec4> segments;
+    float spacing = 0.0f; // Set when the knots are near evenly spaced, which makes the segment lookup a divide
+
+    size_t segmentOf(float x) const;
+    float evaluate(float x) const;
+    float slope(float x) const;
+
+    // y[i] = curve(x[i]). The SIMD version evaluates eight queries at a time
+    // in AVX builds, or four with SSE, in Horner form; it matches evaluateScalar bit for bit.
+    void evaluate(const float* x, float* y, size_t count) const;
+    void evaluateScalar(const float* x, float* y, size_t count) const;
+};
+
+// Polynomial
+// Least squares fit in the scaled variable u = (x - center) * scale, which
+// keeps powers of large x from swamping the normal equations.
+// coefficients[k] multiplies u^k.
+struct Polynomial
+{
+    float center = 0.0f;
+    float scale = 1.0f;
+    std::vector<float> coefficients;
+
+    float evaluate(float x) const;
+    void evaluate(const float* x, float* y, size_t count) const;
+    void evaluateScalar(const float* x, float* y, size_t count) const;
+};
+
+enum SplineEnd
+{
+    SPLINE_NATURAL,    // No curvature at the ends
+    SPLINE_NOT_A_KNOT  // The first two and last two segments are one cubic each, so cubic data is reproduced exactly
+};
+
+// Curve Fitting
+// x must be increasing. Fits are solved in double and stored as float.
+// Interpolating cubic spline, solved for the second derivatives with one
+// tridiagonal pass. Not-a-knot needs four points and falls back to natural.
+bool fitCubicSpline(const float* x, const float* y, size_t count, CubicCurve& curve, SplineEnd end = SPLINE_NOT_A_KNOT);
+
+// Cubic Hermite segments through the points with the given slopes (dy/dx), or
+// with Catmull-Rom slopes (central differences) if slopes is null. Segments
+// match glm::hermite, and on evenly spaced knots the Catmull-Rom version is
+// the curve glm::catmullRom draws; neither is called, gtx/spline.hpp only
+// evaluates, and the kernels need the coefficients.
+bool fitHermite(const float* x, const float* y, const float* slopes, size_t count, CubicCurve& curve);
+
+// Least squares polynomial of the given degree, needs more points than the degree
+bool fitPolynomial(const float* x, const float* y, size_t count, size_t degree, Polynomial& polynomial);
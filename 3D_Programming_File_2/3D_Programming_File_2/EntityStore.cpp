@@ -0,0 +1,136 @@
+#include "EntityStore.h"
+
+static const uint32_t INVALID_INDEX = 0xFFFFFFFFu;
+
+EntityId EntityStore::create(const glm::vec3& position, float scale, const glm::vec4& color, uint32_t meshId)
+{
+    EntityId id;
+    if (!freeIds.empty())
+    {
+        id = freeIds.back();
+        freeIds.pop_back();
+    }
+    else
+    {
+        id = static_cast<EntityId>(sparse.size());
+        sparse.push_back(INVALID_INDEX);
+    }
+
+    sparse[id] = static_cast<uint32_t>(ids.size());
+    ids.push_back(id);
+
+    this->position.push_back(position);
+    previousPosition.push_back(position);
+    this->scale.push_back(scale);
+    velocity.push_back(glm::vec3(0.0f));
+    waypointFrom.push_back(position);
+    waypointTo.push_back(position);
+    route.push_back(NO_ROUTE);
+    waypointIndex.push_back(0);
+    spline.push_back(NO_SPLINE);
+    splineDistance.push_back(0.0f);
+    this->color.push_back(color);
+    this->meshId.push_back(meshId);
+
+    ++storeRevision;
+    return id;
+}
+
+void EntityStore::destroy(EntityId id)
+{
+    if (isAlive(id))
+    {
+        destroyAt(sparse[id]);
+    }
+}
+
+void EntityStore::destroyAt(size_t index)
+{
+    size_t last = ids.size() - 1;
+    EntityId removed = ids[index];
+
+    // Swap And Pop
+    if (index != last)
+    {
+        position[index] = position[last];
+        previousPosition[index] = previousPosition[last];
+        scale[index] = scale[last];
+        velocity[index] = velocity[last];
+        waypointFrom[index] = waypointFrom[last];
+        waypointTo[index] = waypointTo[last];
+        route[index] = route[last];
+        waypointIndex[index] = waypointIndex[last];
+        spline[index] = spline[last];
+        splineDistance[index] = splineDistance[last];
+        color[index] = color[last];
+        meshId[index] = meshId[last];
+        ids[index] = ids[last];
+        sparse[ids[index]] = static_cast<uint32_t>(index);
+    }
+
+    position.pop_back();
+    previousPosition.pop_back();
+    scale.pop_back();
+    velocity.pop_back();
+    waypointFrom.pop_back();
+    waypointTo.pop_back();
+    route.pop_back();
+    waypointIndex.pop_back();
+    spline.pop_back();
+    splineDistance.pop_back();
+    color.pop_back();
+    meshId.pop_back();
+    ids.pop_back();
+
+    sparse[removed] = INVALID_INDEX;
+    freeIds.push_back(removed);
+    ++storeRevision;
+}
+
+bool EntityStore::isAlive(EntityId id) const
+{
+    return id < sparse.size() && sparse[id] != INVALID_INDEX;
+}
+
+size_t EntityStore::indexOf(EntityId id) const
+{
+    return sparse[id];
+}
+
+void EntityStore::reserve(size_t count)
+{
+    position.reserve(count);
+    previousPosition.reserve(count);
+    scale.reserve(count);
+    velocity.reserve(count);
+    waypointFrom.reserve(count);
+    waypointTo.reserve(count);
+    route.reserve(count);
+    waypointIndex.reserve(count);
+    spline.reserve(count);
+    splineDistance.reserve(count);
+    color.reserve(count);
+    meshId.reserve(count);
+    ids.reserve(count);
+    sparse.reserve(count);
+}
+
+void EntityStore::clear()
+{
+    position.clear();
+    previousPosition.clear();
+    scale.clear();
+    velocity.clear();
+    waypointFrom.clear();
+    waypointTo.clear();
+    route.clear();
+    waypointIndex.clear();
+    spline.clear();
+    splineDistance.clear();
+    color.clear();
+    meshId.clear();
+    ids.clear();
+    sparse.clear();
+    freeIds.clear();
+    ++storeRevision;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <glm.hpp>
+#include <cstdint>
+#include <vector>
+
+// Entity Handle
+typedef uint32_t EntityId;
+const EntityId INVALID_ENTITY = 0xFFFFFFFFu;
+
+// Route id of entities that don't follow a route, see CrowdRoutes
+const uint32_t NO_ROUTE = 0xFFFFFFFFu;
+
+// Spline id of entities that don't follow a spline, see SplinePath
+const uint32_t NO_SPLINE = 0xFFFFFFFFu;
+
+// Entity Store
+// Keeps every component in its own contiguous column (structure of arrays).
+// Index i of every column belongs to the same entity, and live entities are
+// always packed into [0, size()), so systems can run as plain loops over the
+// columns. Destroying an entity swaps the last one into its slot.
+class EntityStore
+{
+public:
+    EntityId create(const glm::vec3& position, float scale, const glm::vec4& color, uint32_t meshId);
+    void destroy(EntityId id);
+    void destroyAt(size_t index);
+
+    bool isAlive(EntityId id) const;
+    size_t indexOf(EntityId id) const;
+
+    size_t size() const { return ids.size(); }
+    bool empty() const { return ids.empty(); }
+    void reserve(size_t count);
+    void clear();
+
+    // Bumped whenever entities are created or destroyed
+    uint64_t revision() const { return storeRevision; }
+
+    // Copies position into previousPosition, called at the start of every simulation tick
+    void savePreviousPositions() { previousPosition = position; }
+
+    // Position blended between the last two simulation ticks
+    glm::vec3 interpolatedPosition(size_t index, float alpha) const
+    {
+        return glm::mix(previousPosition[index], position[index], alpha);
+    }
+
+    // Transform
+    std::vector<glm::vec3> position;
+    std::vector<glm::vec3> previousPosition;
+    std::vector<float> scale;
+
+    // Motion
+    std::vector<glm::vec3> velocity;
+    std::vector<glm::vec3> waypointFrom;
+    std::vector<glm::vec3> waypointTo;
+    std::vector<uint32_t> route;
+    std::vector<uint32_t> waypointIndex; // Of waypointTo within the route
+    std::vector<uint32_t> spline;
+    std::vector<float> splineDistance; // Walked along the spline, within one lap
+
+    // Appearance
+    std::vector<glm::vec4> color;
+    std::vector<uint32_t> meshId;
+
+    // Dense index -> entity handle
+    std::vector<EntityId> ids;
+
+private:
+    // Entity handle -> dense index
+    std::vector<uint32_t> sparse;
+    std::vector<EntityId> freeIds;
+    uint64_t storeRevision = 0;
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+// Fixed Timestep
+// Accumulates real frame time and hands it out as whole simulation ticks of a
+// fixed length. Whatever is left over becomes the interpolation factor between
+// the previous and the current simulation state.
+struct FixedTimestep
+{
+    double tickSeconds = 1.0 / 60.0;
+    double accumulator = 0.0;
+    uint64_t tick = 0;
+
+    // Upper bound on ticks per frame so a long stall cannot snowball into ever longer frames
+    int maxTicksPerFrame = 250;
+
+    // ticksPerSecond must be above 0, the command lines reject anything else
+    void setTickRate(double ticksPerSecond)
+    {
+        tickSeconds = 1.0 / ticksPerSecond;
+    }
+
+    // Returns how many ticks to run for a frame that took frameSeconds
+    int advance(double frameSeconds)
+    {
+        accumulator += frameSeconds;
+        int ticks = static_cast<int>(accumulator / tickSeconds);
+        if (ticks > maxTicksPerFrame)
+        {
+            ticks = maxTicksPerFrame;
+            accumulator = 0.0;
+        }
+        else
+        {
+            accumulator -= ticks * tickSeconds;
+        }
+        tick += ticks;
+        return ticks;
+    }
+
+    // How far the current frame is between the last two ticks, in [0, 1]
+    float alpha() const
+    {
+        return static_cast<float>(std::min(accumulator / tickSeconds, 1.0));
+    }
+};
@@ -0,0 +1,166 @@
+#include "Frustum.h"
+#include "JobSystem.h"
+#include "SimdMath.h"
+
+// Gribb/Hartmann plane extraction, glm matrices are column-major so row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+void Frustum::extract(const glm::mat4& m)
+{
+    glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    planes[LEFT] = row3 + row0;
+    planes[RIGHT] = row3 - row0;
+    planes[BOTTOM] = row3 + row1;
+    planes[TOP] = row3 - row1;
+    planes[NEAR_PLANE] = row3 + row2;
+    planes[FAR_PLANE] = row3 - row2;
+
+    // Normalized so plane distances are in world units and comparable to radii
+    for (glm::vec4& plane : planes)
+    {
+        plane /= glm::length(glm::vec3(plane));
+    }
+}
+
+bool Frustum::containsSphere(const glm::vec3& center, float radius) const
+{
+    for (const glm::vec4& plane : planes)
+    {
+        if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t cullSpheresScalar(const Frustum& frustum, const glm::vec3* positions, const float* scales, size_t count,
+    const BoundingSphere& bounds, std::vector<uint32_t>& visible)
+{
+    visible.resize(count);
+    size_t visibleCount = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        glm::vec3 center = positions[i] + bounds.center * scales[i];
+        visible[visibleCount] = static_cast<uint32_t>(i);
+        visibleCount += frustum.containsSphere(center, bounds.radius * scales[i]) ? 1 : 0;
+    }
+    visible.resize(visibleCount);
+    return visibleCount;
+}
+
+#if SIMD_SSE
+
+size_t cullSpheres(const Frustum& frustum, const glm::vec3* positions, const float* scales, size_t count,
+    const BoundingSphere& bounds, std::vector<uint32_t>& visible)
+{
+    visible.resize(count);
+    uint32_t* output = visible.data();
+    size_t visibleCount = 0;
+
+    __m128 planeX[Frustum::PLANE_COUNT];
+    __m128 planeY[Frustum::PLANE_COUNT];
+    __m128 planeZ[Frustum::PLANE_COUNT];
+    __m128 planeW[Frustum::PLANE_COUNT];
+    for (int p = 0; p < Frustum::PLANE_COUNT; ++p)
+    {
+        planeX[p] = _mm_set1_ps(frustum.planes[p].x);
+        planeY[p] = _mm_set1_ps(frustum.planes[p].y);
+        planeZ[p] = _mm_set1_ps(frustum.planes[p].z);
+        planeW[p] = _mm_set1_ps(frustum.planes[p].w);
+    }
+    __m128 boundsX = _mm_set1_ps(bounds.center.x);
+    __m128 boundsY = _mm_set1_ps(bounds.center.y);
+    __m128 boundsZ = _mm_set1_ps(bounds.center.z);
+    __m128 boundsRadius = _mm_set1_ps(bounds.radius);
+    __m128 zero = _mm_setzero_ps();
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 x, y, z;
+        loadVec3x4(&positions[i].x, x, y, z);
+
+        __m128 scale = _mm_loadu_ps(scales + i);
+        x = _mm_add_ps(x, _mm_mul_ps(boundsX, scale));
+        y = _mm_add_ps(y, _mm_mul_ps(boundsY, scale));
+        z = _mm_add_ps(z, _mm_mul_ps(boundsZ, scale));
+        __m128 negativeRadius = _mm_sub_ps(zero, _mm_mul_ps(boundsRadius, scale));
+
+        __m128 inside = _mm_cmpeq_ps(zero, zero);
+        for (int p = 0; p < Frustum::PLANE_COUNT; ++p)
+        {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], x), _mm_mul_ps(planeY[p], y)),
+                _mm_add_ps(_mm_mul_ps(planeZ[p], z), planeW[p]));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+        }
+
+        // Branch-free compaction: always write the index, only advance on a hit
+        int mask = _mm_movemask_ps(inside);
+        output[visibleCount] = static_cast<uint32_t>(i);
+        visibleCount += mask & 1;
+        output[visibleCount] = static_cast<uint32_t>(i + 1);
+        visibleCount += (mask >> 1) & 1;
+        output[visibleCount] = static_cast<uint32_t>(i + 2);
+        visibleCount += (mask >> 2) & 1;
+        output[visibleCount] = static_cast<uint32_t>(i + 3);
+        visibleCount += (mask >> 3) & 1;
+    }
+
+    // Tail
+    for (; i < count; ++i)
+    {
+        glm::vec3 center = positions[i] + bounds.center * scales[i];
+        output[visibleCount] = static_cast<uint32_t>(i);
+        visibleCount += frustum.containsSphere(center, bounds.radius * scales[i]) ? 1 : 0;
+    }
+
+    visible.resize(visibleCount);
+    return visibleCount;
+}
+
+#else
+
+size_t cullSpheres(const Frustum& frustum, const glm::vec3* positions, const float* scales, size_t count,
+    const BoundingSphere& bounds, std::vector<uint32_t>& visible)
+{
+    return cullSpheresScalar(frustum, positions, scales, count, bounds, visible);
+}
+
+#endif
+
+// Instances per culling job, a chunk takes a few microseconds
+static const size_t CULL_CHUNK = 4096;
+
+size_t cullSpheresParallel(JobSystem& jobs, const Frustum& frustum, const glm::vec3* positions, const float* scales, size_t count,
+    const BoundingSphere& bounds, std::vector<uint32_t>& visible, std::vector<std::vector<uint32_t>>& chunkVisible)
+{
+    size_t chunks = jobs.chunkCount(count, CULL_CHUNK);
+    if (chunkVisible.size() < chunks)
+    {
+        chunkVisible.resize(chunks);
+    }
+    for (std::vector<uint32_t>& chunk : chunkVisible)
+    {
+        chunk.clear();
+    }
+
+    jobs.parallelForChunks(count, chunks, [&](size_t chunk, size_t begin, size_t end)
+    {
+        std::vector<uint32_t>& output = chunkVisible[chunk];
+        cullSpheres(frustum, positions + begin, scales + begin, end - begin, bounds, output);
+        for (uint32_t& index : output)
+        {
+            index += static_cast<uint32_t>(begin);
+        }
+    });
+
+    visible.clear();
+    for (size_t chunk = 0; chunk < chunks; ++chunk)
+    {
+        visible.insert(visible.end(), chunkVisible[chunk].begin(), chunkVisible[chunk].end());
+    }
+    return visible.size();
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <glm.hpp>
+#include <cstdint>
+#include <vector>
+#include "Bounds.h"
+
+class JobSystem;
+
+// View Frustum
+// Six planes (normal.xyz, distance.w) pointing inwards, extracted from a
+// view-projection matrix. A sphere is visible unless it lies entirely behind
+// one of the planes; spheres near a corner can pass, which is fine for culling.
+struct Frustum
+{
+    enum Plane { LEFT, RIGHT, BOTTOM, TOP, NEAR_PLANE, FAR_PLANE, PLANE_COUNT };
+
+    glm::vec4 planes[PLANE_COUNT];
+
+    void extract(const glm::mat4& viewProjection);
+
+    bool containsSphere(const glm::vec3& center, float radius) const;
+    bool containsSphere(const BoundingSphere& sphere) const { return containsSphere(sphere.center, sphere.radius); }
+};
+
+// Batch Culling
+// Tests count instances of a mesh with the given local bounds, placed at
+// positions[i] and uniformly scaled by scales[i]. The indices of the visible
+// instances are written to visible in ascending order; returns how many there are.
+// The SIMD version tests four instances at a time and falls back to
+// cullSpheresScalar on targets without SSE.
+size_t cullSpheres(const Frustum& frustum, const glm::vec3* positions, const float* scales, size_t count,
+    const BoundingSphere& bounds, std::vector<uint32_t>& visible);
+size_t cullSpheresScalar(const Frustum& frustum, const glm::vec3* positions, const float* scales, size_t count,
+    const BoundingSphere& bounds, std::vector<uint32_t>& visible);
+
+// Parallel Culling
+// Splits the instances into chunks that are culled on the job system and
+// concatenates the results, so visible is in the same ascending order as with
+// cullSpheres. chunkVisible keeps each chunk's output between frames.
+size_t cullSpheresParallel(JobSystem& jobs, const Frustum& frustum, const glm::vec3* positions, const float* scales, size_t count,
+    const BoundingSphere& bounds, std::vector<uint32_t>& visible, std::vector<std::vector<uint32_t>>& chunkVisible);
@@ -0,0 +1,80 @@
+#include "GpuProfiler.h"
+
+#ifdef ENABLE_PROFILER
+
+void GpuProfiler::create()
+{
+    for (Frame& frame : frames)
+    {
+        frame.sections.resize(GPU_PROFILER_MAX_SECTIONS);
+        for (Section& section : frame.sections)
+        {
+            glGenQueries(1, &section.query);
+            section.name = nullptr;
+            section.issuedNs = 0;
+        }
+        frame.used = 0;
+    }
+    currentFrame = 0;
+}
+
+void GpuProfiler::destroy()
+{
+    for (Frame& frame : frames)
+    {
+        for (Section& section : frame.sections)
+        {
+            glDeleteQueries(1, &section.query);
+        }
+        frame.sections.clear();
+        frame.used = 0;
+    }
+}
+
+void GpuProfiler::beginFrame()
+{
+    currentFrame = (currentFrame + 1) % GPU_PROFILER_LATENCY;
+    Frame& frame = frames[currentFrame];
+
+    // This slot was last used GPU_PROFILER_LATENCY frames ago, its results should be ready by now
+    for (size_t i = 0; i < frame.used; ++i)
+    {
+        Section& section = frame.sections[i];
+        GLint available = 0;
+        glGetQueryObjectiv(section.query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available)
+        {
+            GLuint64 elapsedNs = 0;
+            glGetQueryObjectui64v(section.query, GL_QUERY_RESULT, &elapsedNs);
+            profilerRecord(section.name, section.issuedNs, elapsedNs, PROFILE_GPU);
+        }
+    }
+    frame.used = 0;
+}
+
+void GpuProfiler::begin(const char* name)
+{
+    // Nested sections are folded into the outermost one
+    Frame& frame = frames[currentFrame];
+    if (depth++ > 0 || frame.used == frame.sections.size())
+    {
+        return;
+    }
+
+    Section& section = frame.sections[frame.used++];
+    section.name = name;
+    section.issuedNs = profilerNowNs();
+    glBeginQuery(GL_TIME_ELAPSED, section.query);
+    queryOpen = true;
+}
+
+void GpuProfiler::end()
+{
+    if (--depth == 0 && queryOpen)
+    {
+        glEndQuery(GL_TIME_ELAPSED);
+        queryOpen = false;
+    }
+}
+
+#endif
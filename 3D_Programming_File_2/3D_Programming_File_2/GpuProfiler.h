@@ -0,0 +1,67 @@
+#pragma once
+
+#include <glad/glad.h>
+#include "Profiler.h"
+
+#ifdef ENABLE_PROFILER
+
+#include <cstdint>
+#include <vector>
+
+// GPU Profiler
+// Times GPU sections with GL_TIME_ELAPSED queries. Queries are kept per frame in
+// a ring of GPU_PROFILER_LATENCY frames and only read back once that many frames
+// have passed, so reading results never stalls the pipeline. Sections are placed
+// in the trace at the CPU time they were issued. GL_TIME_ELAPSED queries cannot
+// nest, so a section opened inside another one is timed as part of the outer one.
+const int GPU_PROFILER_LATENCY = 4;
+const int GPU_PROFILER_MAX_SECTIONS = 32;
+
+class GpuProfiler
+{
+public:
+    void create();
+    void destroy();
+
+    // Reads back the frame issued GPU_PROFILER_LATENCY frames ago
+    void beginFrame();
+
+    void begin(const char* name);
+    void end();
+
+private:
+    struct Section
+    {
+        GLuint query;
+        const char* name;
+        uint64_t issuedNs;
+    };
+
+    struct Frame
+    {
+        std::vector<Section> sections;
+        size_t used = 0;
+    };
+
+    Frame frames[GPU_PROFILER_LATENCY];
+    int currentFrame = 0;
+    int depth = 0;
+    bool queryOpen = false;
+};
+
+// GPU Scope
+struct GpuProfileScope
+{
+    GpuProfiler& profiler;
+
+    GpuProfileScope(GpuProfiler& profiler, const char* name) : profiler(profiler) { profiler.begin(name); }
+    ~GpuProfileScope() { profiler.end(); }
+};
+
+#define GPU_PROFILE_SCOPE(profiler, name) GpuProfileScope PROFILE_CONCAT(gpuProfileScope, __LINE__)(profiler, name)
+
+#else
+
+#define GPU_PROFILE_SCOPE(profiler, name) ((void)0)
+
+#endif
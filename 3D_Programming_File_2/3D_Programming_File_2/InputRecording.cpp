@@ -0,0 +1,72 @@
+#include "InputRecording.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+bool InputRecording::save(const std::string& path) const
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        std::cerr << "Failed to write input recording: " << path << std::endl;
+        return false;
+    }
+
+    file << "# tick-rate " << tickRate << "\n";
+    for (const InputState& input : ticks)
+    {
+        unsigned flags = 0;
+        flags |= input.sprint ? INPUT_FLAG_SPRINT : 0u;
+        flags |= input.collect ? INPUT_FLAG_COLLECT : 0u;
+        flags |= input.toggleRoute ? INPUT_FLAG_TOGGLE_ROUTE : 0u;
+        flags |= input.useDoor ? INPUT_FLAG_USE_DOOR : 0u;
+        file << input.moveX << ' ' << input.moveZ << ' ' << flags << "\n";
+    }
+    return true;
+}
+
+bool InputRecording::load(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        std::cerr << "Failed to read input recording: " << path << std::endl;
+        return false;
+    }
+
+    ticks.clear();
+    std::string line;
+    while (std::getline(file, line))
+    {
+        if (line.empty())
+        {
+            continue;
+        }
+
+        std::istringstream stream(line);
+        if (line[0] == '#')
+        {
+            std::string hash, key;
+            stream >> hash >> key;
+            if (key == "tick-rate")
+            {
+                stream >> tickRate;
+            }
+            continue;
+        }
+
+        InputState input;
+        unsigned flags = 0;
+        if (!(stream >> input.moveX >> input.moveZ >> flags))
+        {
+            std::cerr << "Malformed input recording line " << ticks.size() + 1 << ": " << line << std::endl;
+            return false;
+        }
+        input.sprint = (flags & INPUT_FLAG_SPRINT) != 0;
+        input.collect = (flags & INPUT_FLAG_COLLECT) != 0;
+        input.toggleRoute = (flags & INPUT_FLAG_TOGGLE_ROUTE) != 0;
+        input.useDoor = (flags & INPUT_FLAG_USE_DOOR) != 0;
+        ticks.push_back(input);
+    }
+    return true;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "World.h"
+#include <string>
+#include <vector>
+
+// Input Flags
+const unsigned INPUT_FLAG_SPRINT = 1u << 0;
+const unsigned INPUT_FLAG_COLLECT = 1u << 1;
+const unsigned INPUT_FLAG_TOGGLE_ROUTE = 1u << 2;
+const unsigned INPUT_FLAG_USE_DOOR = 1u << 3;
+
+// Input Recording
+// The InputState of every simulation tick, in order. Replaying it through
+// tickWorld at the same tick rate reproduces the recorded session exactly.
+//
+// File format (text):
+//   # tick-rate <hz>
+//   <moveX> <moveZ> <flags>      one line per tick, flags = INPUT_FLAG_* bits
+struct InputRecording
+{
+    double tickRate = 60.0;
+    std::vector<InputState> ticks;
+
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+};
@@ -0,0 +1,109 @@
+#include "InstanceBuffer.h"
+#include "TransformBatch.h"
+#include <cstddef>
+
+void InstanceBuffer::create(GLuint vao)
+{
+    this->vao = vao;
+    glGenBuffers(1, &vbo);
+
+    glBindVertexArray(vao);
+    glEnableVertexAttribArray(INSTANCE_COLOR_LOCATION);
+    glVertexAttribDivisor(INSTANCE_COLOR_LOCATION, 1);
+    for (GLuint column = 0; column < 4; ++column)
+    {
+        glEnableVertexAttribArray(INSTANCE_MVP_LOCATION + column);
+        glVertexAttribDivisor(INSTANCE_MVP_LOCATION + column, 1);
+    }
+    setFirstInstance(0);
+    glBindVertexArray(0);
+}
+
+void InstanceBuffer::setFirstInstance(size_t firstInstance) const
+{
+    size_t mvpOffset = firstInstance * sizeof(glm::mat4);
+    size_t colorOffset = capacity * sizeof(glm::mat4) + firstInstance * sizeof(glm::vec4);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    for (GLuint column = 0; column < 4; ++column)
+    {
+        glVertexAttribPointer(INSTANCE_MVP_LOCATION + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+            (void*)(mvpOffset + column * sizeof(glm::vec4)));
+    }
+    glVertexAttribPointer(INSTANCE_COLOR_LOCATION, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)colorOffset);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void InstanceBuffer::destroy()
+{
+    glDeleteBuffers(1, &vbo);
+    vbo = 0;
+    capacity = 0;
+    instanceCount = 0;
+    uploadedRevision = ~0ull;
+    uploadedCameraRevision = ~0ull;
+    uploadedAll = false;
+    uploadedVisible.clear();
+}
+
+bool InstanceBuffer::update(const EntityStore& store, const Camera& camera)
+{
+    if (store.revision() == uploadedRevision && camera.revision() == uploadedCameraRevision && uploadedAll)
+    {
+        return false;
+    }
+
+    size_t count = store.size();
+    stagingMvps.resize(count);
+    stagingColors.assign(store.color.begin(), store.color.end());
+    computeInstanceMvps(camera.viewProjection(), store.position.data(), store.scale.data(), nullptr, count, stagingMvps.data());
+    upload(count);
+
+    uploadedRevision = store.revision();
+    uploadedCameraRevision = camera.revision();
+    uploadedAll = true;
+    return true;
+}
+
+bool InstanceBuffer::update(const EntityStore& store, const std::vector<uint32_t>& visible, const Camera& camera)
+{
+    if (store.revision() == uploadedRevision && camera.revision() == uploadedCameraRevision && !uploadedAll && visible == uploadedVisible)
+    {
+        return false;
+    }
+
+    size_t count = visible.size();
+    stagingMvps.resize(count);
+    stagingColors.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        stagingColors[i] = store.color[visible[i]];
+    }
+    computeInstanceMvps(camera.viewProjection(), store.position.data(), store.scale.data(), visible.data(), count, stagingMvps.data());
+    upload(count);
+
+    uploadedRevision = store.revision();
+    uploadedCameraRevision = camera.revision();
+    uploadedAll = false;
+    uploadedVisible = visible;
+    return true;
+}
+
+void InstanceBuffer::upload(size_t count)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    if (count > capacity)
+    {
+        // Grow geometrically so a stream of spawns does not reallocate every time
+        capacity = count + count / 2;
+        glBufferData(GL_ARRAY_BUFFER, capacity * (sizeof(glm::mat4) + sizeof(glm::vec4)), nullptr, GL_DYNAMIC_DRAW);
+    }
+    if (count > 0)
+    {
+        glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(glm::mat4), stagingMvps.data());
+        glBufferSubData(GL_ARRAY_BUFFER, capacity * sizeof(glm::mat4), count * sizeof(glm::vec4), stagingColors.data());
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    instanceCount = static_cast<GLsizei>(count);
+}
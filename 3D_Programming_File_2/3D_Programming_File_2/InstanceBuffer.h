@@ -0,0 +1,53 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm.hpp>
+#include <vector>
+#include "Camera.h"
+#include "EntityStore.h"
+
+// Per-Instance Attributes of the instanced shaders
+// Color at location 1 and the model-view-projection matrix at locations 2-5,
+// one column each; 6 and 7 hold the mesh's quantization bounds.
+const GLuint INSTANCE_COLOR_LOCATION = 1;
+const GLuint INSTANCE_MVP_LOCATION = 2;
+
+// Instance Buffer
+// Vertex buffer with one MVP and one color per entity of a store, the MVPs
+// first and the colors after them, so the batch transform writes one
+// contiguous array. The buffer is only rewritten when the store's revision
+// changes, i.e. when entities are added or removed, when the set of visible
+// entities passed in changes, or when the camera does.
+class InstanceBuffer
+{
+public:
+    // Creates the buffer and hooks it up to the given VAO with an attribute divisor of 1
+    void create(GLuint vao);
+    void destroy();
+
+    // Returns true if the store or camera had changed and was uploaded
+    bool update(const EntityStore& store, const Camera& camera);
+
+    // Uploads only the entities at the given store indices, e.g. the output of frustum culling
+    bool update(const EntityStore& store, const std::vector<uint32_t>& visible, const Camera& camera);
+
+    GLsizei count() const { return instanceCount; }
+
+    // Points the instance attributes at the given instance, so an instanced draw
+    // can start part-way into the buffer (GL 3.3 has no base instance). Leaves the VAO bound.
+    void setFirstInstance(size_t firstInstance) const;
+
+private:
+    GLuint vao = 0;
+    GLuint vbo = 0;
+    GLsizei instanceCount = 0;
+    size_t capacity = 0;
+    uint64_t uploadedRevision = ~0ull;
+    uint64_t uploadedCameraRevision = ~0ull;
+    bool uploadedAll = false;
+    std::vector<uint32_t> uploadedVisible;
+    std::vector<glm::mat4> stagingMvps;
+    std::vector<glm::vec4> stagingColors;
+
+    void upload(size_t count);
+};
@@ -0,0 +1,371 @@
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <chrono>
+
+// Worker Names, string literals because the profiler keeps the pointers
+static const char* const WORKER_THREAD_NAMES[JOB_MAX_THREADS] = {
+    "Worker 0", "Worker 1", "Worker 2", "Worker 3", "Worker 4", "Worker 5", "Worker 6", "Worker 7",
+    "Worker 8", "Worker 9", "Worker 10", "Worker 11", "Worker 12", "Worker 13", "Worker 14", "Worker 15",
+    "Worker 16", "Worker 17", "Worker 18", "Worker 19", "Worker 20", "Worker 21", "Worker 22", "Worker 23",
+    "Worker 24", "Worker 25", "Worker 26", "Worker 27", "Worker 28", "Worker 29", "Worker 30", "Worker 31"
+};
+
+static const char* const WORKER_BUSY_NAMES[JOB_MAX_THREADS] = {
+    "Worker 0 Busy", "Worker 1 Busy", "Worker 2 Busy", "Worker 3 Busy", "Worker 4 Busy", "Worker 5 Busy",
+    "Worker 6 Busy", "Worker 7 Busy", "Worker 8 Busy", "Worker 9 Busy", "Worker 10 Busy", "Worker 11 Busy",
+    "Worker 12 Busy", "Worker 13 Busy", "Worker 14 Busy", "Worker 15 Busy", "Worker 16 Busy", "Worker 17 Busy",
+    "Worker 18 Busy", "Worker 19 Busy", "Worker 20 Busy", "Worker 21 Busy", "Worker 22 Busy", "Worker 23 Busy",
+    "Worker 24 Busy", "Worker 25 Busy", "Worker 26 Busy", "Worker 27 Busy", "Worker 28 Busy", "Worker 29 Busy",
+    "Worker 30 Busy", "Worker 31 Busy"
+};
+
+// Slots kept free for registered threads when the worker count is picked automatically
+static const size_t REGISTERED_THREAD_SLOTS = 4;
+
+// Failed find attempts before an idle worker goes to sleep
+static const int IDLE_SPINS = 64;
+
+// Chunks per thread in parallelFor, so a thread that falls behind can be helped
+static const size_t CHUNKS_PER_THREAD = 4;
+
+static thread_local const JobSystem* currentSystem = nullptr;
+static thread_local void* currentSlot = nullptr;
+
+static uint64_t nowNs()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Work-Stealing Deque
+// Memory orders follow Le, Pop, Cohen and Zappa Nardelli, "Correct and
+// Efficient Work-Stealing for Weak Memory Models" (PPoPP 2013), except that
+// push publishes with a release store instead of a release fence, which costs
+// the same on x86 and is understood by ThreadSanitizer.
+bool JobDeque::push(Job* job)
+{
+    int64_t b = bottom.load(std::memory_order_relaxed);
+    int64_t t = top.load(std::memory_order_acquire);
+    if (b - t >= CAPACITY)
+    {
+        return false;
+    }
+    buffer[b & (CAPACITY - 1)].store(job, std::memory_order_relaxed);
+    bottom.store(b + 1, std::memory_order_release);
+    return true;
+}
+
+Job* JobDeque::pop()
+{
+    int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top.load(std::memory_order_relaxed);
+
+    if (t > b)
+    {
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    Job* job = buffer[b & (CAPACITY - 1)].load(std::memory_order_relaxed);
+    if (t == b)
+    {
+        // Last job, race the thieves for it
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        {
+            job = nullptr;
+        }
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+Job* JobDeque::steal()
+{
+    int64_t t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom.load(std::memory_order_acquire);
+    if (t >= b)
+    {
+        return nullptr;
+    }
+
+    Job* job = buffer[t & (CAPACITY - 1)].load(std::memory_order_relaxed);
+    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+    {
+        return nullptr;
+    }
+    return job;
+}
+
+JobSystem::JobSystem(size_t workerCount)
+{
+    if (workerCount == 0)
+    {
+        size_t hardware = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        workerCount = std::min(hardware - 1, JOB_MAX_THREADS - REGISTERED_THREAD_SLOTS);
+    }
+    workerCount = std::min(workerCount, JOB_MAX_THREADS - 1);
+
+    for (size_t i = 0; i < JOB_MAX_THREADS; ++i)
+    {
+        slots[i].store(i < workerCount ? new Worker() : nullptr, std::memory_order_relaxed);
+    }
+    slotCount.store(workerCount, std::memory_order_release);
+    sampledAtNs = nowNs();
+
+    workers.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; ++i)
+    {
+        workers.emplace_back(&JobSystem::workerMain, this, i);
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        running.store(false, std::memory_order_release);
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+    for (std::atomic<Worker*>& slot : slots)
+    {
+        delete slot.load();
+    }
+}
+
+void JobSystem::registerThread()
+{
+    if (currentSystem == this)
+    {
+        return;
+    }
+
+    size_t slot = slotCount.load(std::memory_order_acquire);
+    while (slot < JOB_MAX_THREADS && !slotCount.compare_exchange_weak(slot, slot + 1, std::memory_order_acq_rel))
+    {
+    }
+    if (slot >= JOB_MAX_THREADS)
+    {
+        return;
+    }
+
+    // Thieves skip the slot until the worker is published
+    Worker* worker = new Worker();
+    slots[slot].store(worker, std::memory_order_release);
+    currentSystem = this;
+    currentSlot = worker;
+}
+
+JobSystem::Worker* JobSystem::currentWorker() const
+{
+    return currentSystem == this ? static_cast<Worker*>(currentSlot) : nullptr;
+}
+
+size_t JobSystem::chunkCount(size_t count, size_t minChunk) const
+{
+    size_t byGrain = (count + std::max<size_t>(minChunk, 1) - 1) / std::max<size_t>(minChunk, 1);
+    return std::max<size_t>(std::min(byGrain, concurrency() * CHUNKS_PER_THREAD), 1);
+}
+
+void JobSystem::schedule(Job* job)
+{
+    // Jobs are only allocated on threads with a slot, so there is always a deque here
+    Worker* worker = currentWorker();
+    if (!worker->deque.push(job))
+    {
+        // A full deque means the caller is far ahead of the workers, so it does the work itself
+        execute(job, *worker);
+        return;
+    }
+
+    // Pairs with the sleeper raising sleeping before its last look at the deques
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping.load() > 0)
+    {
+        // Taking the lock orders this push before the sleeper's last look for work
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+        }
+        wake.notify_one();
+    }
+}
+
+void JobSystem::addContinuation(JobCounter& dependency, Job* job)
+{
+    Job* head = dependency.continuations.load(std::memory_order_relaxed);
+    do
+    {
+        job->nextContinuation = head;
+    } while (!dependency.continuations.compare_exchange_weak(head, job));
+
+    // If the dependency finished before the job was added, whoever takes the list first queues it
+    if (dependency.pending.load() == 0)
+    {
+        scheduleContinuations(dependency);
+    }
+}
+
+void JobSystem::scheduleContinuations(JobCounter& counter)
+{
+    Job* job = counter.continuations.exchange(nullptr);
+    while (job)
+    {
+        Job* next = job->nextContinuation;
+        schedule(job);
+        job = next;
+    }
+}
+
+void JobSystem::execute(Job* job, Worker& worker)
+{
+    uint64_t start = nowNs();
+    JobCounter* counter = job->counter;
+    job->invoke(*job);
+
+    // The job is not touched after this, its slot can be handed out again
+    job->busy.store(false, std::memory_order_release);
+
+    // finishing keeps the counter alive for wait() until its continuations are queued
+    counter->finishing.fetch_add(1);
+    if (counter->pending.fetch_sub(1) == 1)
+    {
+        scheduleContinuations(*counter);
+    }
+    counter->finishing.fetch_sub(1);
+
+    worker.busyNs.fetch_add(nowNs() - start, std::memory_order_relaxed);
+    worker.jobsRun.fetch_add(1, std::memory_order_relaxed);
+}
+
+Job* JobSystem::findJob(Worker& worker)
+{
+    Job* job = worker.deque.pop();
+    if (job)
+    {
+        return job;
+    }
+
+    // Steal from the other deques, starting at a different one each time so thieves spread out
+    size_t count = slotCount.load(std::memory_order_acquire);
+    size_t start = static_cast<size_t>(worker.nextJob + worker.jobsRun.load(std::memory_order_relaxed));
+    for (size_t i = 0; i < count; ++i)
+    {
+        Worker* victim = slots[(start + i) % count].load(std::memory_order_acquire);
+        if (!victim || victim == &worker)
+        {
+            continue;
+        }
+        job = victim->deque.steal();
+        if (job)
+        {
+            worker.steals.fetch_add(1, std::memory_order_relaxed);
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+void JobSystem::wait(JobCounter& counter)
+{
+    Worker* worker = currentWorker();
+    while (!counter.done())
+    {
+        Job* job = worker ? findJob(*worker) : nullptr;
+        if (job)
+        {
+            execute(job, *worker);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::workerMain(size_t index)
+{
+    PROFILE_THREAD_NAME(WORKER_THREAD_NAMES[index]);
+    currentSystem = this;
+    Worker& worker = *slots[index].load(std::memory_order_relaxed);
+    currentSlot = &worker;
+
+    int idle = 0;
+    while (running.load(std::memory_order_acquire))
+    {
+        Job* job = findJob(worker);
+        if (job)
+        {
+            execute(job, worker);
+            idle = 0;
+            continue;
+        }
+        if (++idle < IDLE_SPINS)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        // The timeout bounds how long a job pushed without a wakeup can sit
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        if (!running.load(std::memory_order_acquire))
+        {
+            break;
+        }
+        sleeping.fetch_add(1);
+        job = findJob(worker);
+        if (!job)
+        {
+            wake.wait_for(lock, std::chrono::milliseconds(2));
+        }
+        sleeping.fetch_sub(1);
+        lock.unlock();
+
+        if (job)
+        {
+            execute(job, worker);
+        }
+        idle = 0;
+    }
+}
+
+void JobSystem::sampleUtilization(std::vector<WorkerUtilization>& utilization)
+{
+    uint64_t now = nowNs();
+    double elapsed = static_cast<double>(std::max<uint64_t>(now - sampledAtNs, 1));
+    sampledAtNs = now;
+
+    utilization.resize(workers.size());
+    for (size_t i = 0; i < workers.size(); ++i)
+    {
+        Worker& worker = *slots[i].load(std::memory_order_relaxed);
+        uint64_t busyNs = worker.busyNs.load(std::memory_order_relaxed);
+        uint64_t jobs = worker.jobsRun.load(std::memory_order_relaxed);
+        uint64_t steals = worker.steals.load(std::memory_order_relaxed);
+
+        utilization[i].busy = static_cast<float>(std::min((busyNs - worker.sampledBusyNs) / elapsed, 1.0));
+        utilization[i].jobs = jobs - worker.sampledJobs;
+        utilization[i].steals = steals - worker.sampledSteals;
+
+        worker.sampledBusyNs = busyNs;
+        worker.sampledJobs = jobs;
+        worker.sampledSteals = steals;
+    }
+}
+
+void JobSystem::publishUtilization()
+{
+#ifdef ENABLE_PROFILER
+    std::vector<WorkerUtilization> utilization;
+    sampleUtilization(utilization);
+    for (size_t i = 0; i < utilization.size(); ++i)
+    {
+        PROFILE_COUNTER(WORKER_BUSY_NAMES[i], utilization[i].busy);
+    }
+#endif
+}
@@ -0,0 +1,275 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Job Limits
+// Worker threads plus threads registered with registerThread. Every thread
+// hands out jobs from its own ring of JOB_POOL_SIZE. A thread with more jobs
+// outstanding than that runs the next ones itself (and asserts in debug builds).
+const size_t JOB_MAX_THREADS = 32;
+const size_t JOB_POOL_SIZE = 4096;
+const size_t JOB_STORAGE_SIZE = 64;
+
+struct Job;
+
+// Job Counter
+// Counts the unfinished jobs that were started with it. Jobs started with
+// runAfter wait on a counter without blocking a thread: they are queued as soon
+// as the counter they depend on drops to zero, which is how job graphs are built.
+// A counter may be destroyed once done() returns true.
+class JobCounter
+{
+public:
+    JobCounter() = default;
+    JobCounter(const JobCounter&) = delete;
+    JobCounter& operator=(const JobCounter&) = delete;
+
+    bool done() const { return pending.load() == 0 && finishing.load() == 0; }
+
+private:
+    friend class JobSystem;
+
+    std::atomic<int32_t> pending{ 0 };
+
+    // Jobs between finishing and queueing this counter's continuations
+    std::atomic<int32_t> finishing{ 0 };
+    std::atomic<Job*> continuations{ nullptr };
+};
+
+struct Job
+{
+    void (*invoke)(Job& job);
+    JobCounter* counter;
+    Job* nextContinuation;
+
+    // Set from allocation until the job has run, the ring slot is not reused before
+    std::atomic<bool> busy{ false };
+    alignas(16) unsigned char storage[JOB_STORAGE_SIZE];
+};
+
+// Work-Stealing Deque
+// Chase-Lev deque of fixed capacity. The owning thread pushes and pops at the
+// bottom, every other thread steals from the top.
+class JobDeque
+{
+public:
+    static const int64_t CAPACITY = 4096;
+
+    // Owner only, returns false if the deque is full
+    bool push(Job* job);
+    Job* pop();
+
+    // Any thread
+    Job* steal();
+
+private:
+    // Padded rather than aligned, deques are heap allocated and C++14 new ignores alignas
+    std::atomic<int64_t> top{ 0 };
+    char topPadding[64 - sizeof(int64_t)];
+    std::atomic<int64_t> bottom{ 0 };
+    char bottomPadding[64 - sizeof(int64_t)];
+    std::atomic<Job*> buffer[CAPACITY];
+};
+
+// Worker Utilization
+// Fraction of the wall time since the previous sample that a worker spent
+// running jobs.
+struct WorkerUtilization
+{
+    float busy = 0.0f;
+    uint64_t jobs = 0;
+    uint64_t steals = 0;
+};
+
+// Job System
+// A fixed pool of worker threads, each with its own work-stealing deque. Jobs
+// go onto the deque of the thread that starts them; idle workers steal from the
+// other deques and sleep once there is nothing left to steal. Threads other
+// than the workers (the main and simulation threads) call registerThread to get
+// a deque of their own. On any other thread run executes the job right away,
+// so code that uses jobs stays correct wherever it is called from.
+class JobSystem
+{
+public:
+    // workerCount 0 starts one worker per hardware thread minus the caller's
+    explicit JobSystem(size_t workerCount = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    size_t workerCount() const { return workers.size(); }
+
+    // Threads that can run jobs at the same time: the workers and one waiting thread
+    size_t concurrency() const { return workers.size() + 1; }
+
+    // Gives the calling thread a deque, so its jobs can be stolen while it waits.
+    // Slots are never given back, so only long-lived threads should register.
+    void registerThread();
+
+    // Starts function() as a job counted by counter
+    template <typename Function>
+    void run(JobCounter& counter, Function&& function)
+    {
+        Job* job = allocate(counter, std::forward<Function>(function));
+        if (job)
+        {
+            schedule(job);
+        }
+    }
+
+    // Starts function() as a job counted by counter once dependency is done
+    template <typename Function>
+    void runAfter(JobCounter& dependency, JobCounter& counter, Function&& function)
+    {
+        Job* job = allocate(counter, std::forward<Function>(function), &dependency);
+        if (job)
+        {
+            addContinuation(dependency, job);
+        }
+    }
+
+    // Runs other jobs on the calling thread until counter is done
+    void wait(JobCounter& counter);
+
+    // Number of chunks parallelFor splits count items into
+    size_t chunkCount(size_t count, size_t minChunk) const;
+
+    // Calls function(chunk, begin, end) for chunkCount consecutive ranges
+    // covering [0, count), in parallel, and returns once all of them are done.
+    // The calling thread takes the first chunk itself.
+    template <typename Function>
+    void parallelForChunks(size_t count, size_t chunks, const Function& function)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+        chunks = std::max<size_t>(std::min(chunks, count), 1);
+        if (chunks == 1 || !canRun())
+        {
+            size_t chunkSize = (count + chunks - 1) / chunks;
+            for (size_t chunk = 0; chunk * chunkSize < count; ++chunk)
+            {
+                function(chunk, chunk * chunkSize, std::min(count, (chunk + 1) * chunkSize));
+            }
+            return;
+        }
+
+        JobCounter counter;
+        size_t chunkSize = (count + chunks - 1) / chunks;
+        for (size_t chunk = 1; chunk * chunkSize < count; ++chunk)
+        {
+            size_t begin = chunk * chunkSize;
+            size_t end = std::min(count, begin + chunkSize);
+            run(counter, [&function, chunk, begin, end]() { function(chunk, begin, end); });
+        }
+        function(0, 0, std::min(count, chunkSize));
+        wait(counter);
+    }
+
+    // Calls function(begin, end) over [0, count) in ranges of at least minChunk items
+    template <typename Function>
+    void parallelFor(size_t count, size_t minChunk, const Function& function)
+    {
+        parallelForChunks(count, chunkCount(count, minChunk),
+            [&function](size_t, size_t begin, size_t end) { function(begin, end); });
+    }
+
+    // Utilization of every worker since the previous call
+    void sampleUtilization(std::vector<WorkerUtilization>& utilization);
+
+    // Samples the utilization and sends it to the profiler as one counter per worker
+    void publishUtilization();
+
+private:
+    struct Worker
+    {
+        JobDeque deque;
+        Job pool[JOB_POOL_SIZE];
+        size_t nextJob = 0;
+
+        std::atomic<uint64_t> busyNs{ 0 };
+        std::atomic<uint64_t> jobsRun{ 0 };
+        std::atomic<uint64_t> steals{ 0 };
+        uint64_t sampledBusyNs = 0;
+        uint64_t sampledJobs = 0;
+        uint64_t sampledSteals = 0;
+    };
+
+    // Returns nullptr once function has run on the calling thread instead: on threads
+    // without a deque, or when the next slot of the ring still holds an unfinished job
+    template <typename Function>
+    Job* allocate(JobCounter& counter, Function&& function, JobCounter* dependency = nullptr)
+    {
+        typedef typename std::decay<Function>::type Stored;
+        static_assert(sizeof(Stored) <= JOB_STORAGE_SIZE, "Job captures too much, capture a pointer instead");
+        static_assert(alignof(Stored) <= 16, "Job captures an over-aligned type");
+
+        Worker* worker = currentWorker();
+        if (!worker)
+        {
+            function();
+            return nullptr;
+        }
+
+        Job* job = &worker->pool[worker->nextJob & (JOB_POOL_SIZE - 1)];
+        if (job->busy.load(std::memory_order_acquire))
+        {
+            assert(!"More than JOB_POOL_SIZE jobs outstanding on one thread");
+            if (dependency)
+            {
+                wait(*dependency);
+            }
+            function();
+            return nullptr;
+        }
+        ++worker->nextJob;
+        job->busy.store(true, std::memory_order_relaxed);
+        new (job->storage) Stored(std::forward<Function>(function));
+        job->invoke = [](Job& job)
+        {
+            Stored* stored = reinterpret_cast<Stored*>(job.storage);
+            (*stored)();
+            stored->~Stored();
+        };
+        job->counter = &counter;
+        job->nextContinuation = nullptr;
+        counter.pending.fetch_add(1, std::memory_order_relaxed);
+        return job;
+    }
+
+    bool canRun() const { return currentWorker() != nullptr; }
+    Worker* currentWorker() const;
+
+    void schedule(Job* job);
+    void addContinuation(JobCounter& dependency, Job* job);
+    void scheduleContinuations(JobCounter& counter);
+    void execute(Job* job, Worker& worker);
+    Job* findJob(Worker& worker);
+    void workerMain(size_t index);
+
+    std::vector<std::thread> workers;
+
+    // Workers first, then registered threads; never shrinks, so thieves can read it without locking
+    std::atomic<Worker*> slots[JOB_MAX_THREADS];
+    std::atomic<size_t> slotCount{ 0 };
+    std::atomic<bool> running{ true };
+
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::atomic<uint32_t> sleeping{ 0 };
+
+    uint64_t sampledAtNs = 0;
+};
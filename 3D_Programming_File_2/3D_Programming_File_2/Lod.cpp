@@ -0,0 +1,126 @@
+#include "Lod.h"
+#include "JobSystem.h"
+#include <algorithm>
+
+// Marks entities that have not been selected yet
+static const uint8_t NO_HISTORY = 0xFF;
+
+// Instances per selection job
+static const size_t LOD_CHUNK = 4096;
+
+void LodSelector::setLevels(int levelCount, const float* minPixels)
+{
+    levels = std::max(1, std::min(levelCount, MAX_LOD_LEVELS));
+    for (int level = 0; level < MAX_LOD_LEVELS; ++level)
+    {
+        this->minPixels[level] = level < levels - 1 ? minPixels[level] : 0.0f;
+    }
+    history.clear();
+}
+
+void LodSelector::beginFrame(const glm::mat4& view, const glm::mat4& projection, float viewportHeight)
+{
+    // The camera looks down -z, so depth is minus the view-space z
+    depthRow = -glm::vec4(view[0][2], view[1][2], view[2][2], view[3][2]);
+
+    // projection[1][1] is cot(fov / 2), a sphere of radius r at depth d covers r * cot(fov / 2) / d of half the viewport
+    pixelsPerUnit = projection[1][1] * viewportHeight * 0.5f;
+}
+
+float LodSelector::projectedDiameter(const glm::vec3& center, float radius) const
+{
+    float depth = glm::dot(depthRow, glm::vec4(center, 1.0f));
+    if (depth <= radius)
+    {
+        // The camera is inside or right next to the sphere
+        return 1.0e9f;
+    }
+    return 2.0f * radius * pixelsPerUnit / depth;
+}
+
+int LodSelector::select(EntityId id, const glm::vec3& center, float radius)
+{
+    float size = projectedDiameter(center, radius);
+    if (id >= history.size())
+    {
+        history.resize(id + 1, NO_HISTORY);
+    }
+
+    int level = 0;
+    if (history[id] == NO_HISTORY)
+    {
+        while (level < levels - 1 && size < minPixels[level])
+        {
+            ++level;
+        }
+    }
+    else
+    {
+        level = std::min<int>(history[id], levels - 1);
+        while (level > 0 && size >= minPixels[level - 1] * (1.0f + hysteresis))
+        {
+            --level;
+        }
+        while (level < levels - 1 && size < minPixels[level] * (1.0f - hysteresis))
+        {
+            ++level;
+        }
+    }
+
+    history[id] = static_cast<uint8_t>(level);
+    return level;
+}
+
+void LodSelector::bucket(const EntityStore& store, const std::vector<uint32_t>& visible, float meshRadius, LodBuckets& buckets,
+    JobSystem* jobs)
+{
+    // The history is grown up front, so select never resizes it from a job
+    EntityId maxId = 0;
+    for (uint32_t index : visible)
+    {
+        maxId = std::max(maxId, store.ids[index]);
+    }
+    if (!visible.empty() && maxId >= history.size())
+    {
+        history.resize(maxId + 1, NO_HISTORY);
+    }
+
+    // Select into a scratch list first, then counting-sort the instances by level
+    selected.resize(visible.size());
+    auto selectRange = [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            uint32_t index = visible[i];
+            selected[i] = static_cast<uint8_t>(select(store.ids[index], store.position[index], meshRadius * store.scale[index]));
+        }
+    };
+    if (jobs)
+    {
+        jobs->parallelFor(visible.size(), LOD_CHUNK, selectRange);
+    }
+    else
+    {
+        selectRange(0, visible.size());
+    }
+
+    size_t counts[MAX_LOD_LEVELS] = {};
+    for (uint8_t level : selected)
+    {
+        ++counts[level];
+    }
+
+    buckets.offsets[0] = 0;
+    for (int level = 0; level < MAX_LOD_LEVELS; ++level)
+    {
+        buckets.offsets[level + 1] = buckets.offsets[level] + counts[level];
+    }
+
+    size_t cursor[MAX_LOD_LEVELS];
+    std::copy(buckets.offsets, buckets.offsets + MAX_LOD_LEVELS, cursor);
+    buckets.order.resize(visible.size());
+    for (size_t i = 0; i < visible.size(); ++i)
+    {
+        buckets.order[cursor[selected[i]]++] = visible[i];
+    }
+}
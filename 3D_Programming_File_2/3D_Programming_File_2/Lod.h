@@ -0,0 +1,68 @@
+#pragma once
+
+#include <glm.hpp>
+#include <cstdint>
+#include <vector>
+#include "EntityStore.h"
+
+class JobSystem;
+
+const int MAX_LOD_LEVELS = 4;
+
+// LOD Buckets
+// Visible instances grouped by level: the store indices of level l are
+// order[offsets[l]] .. order[offsets[l + 1] - 1], so each level can be uploaded
+// as one contiguous range and drawn with one instanced call.
+struct LodBuckets
+{
+    std::vector<uint32_t> order;
+    size_t offsets[MAX_LOD_LEVELS + 1] = {};
+
+    size_t count(int level) const { return offsets[level + 1] - offsets[level]; }
+};
+
+// LOD Selector
+// Picks a mesh level per instance from the diameter its bounding sphere
+// covers on screen, using the camera projection and the viewport height.
+// Level l is used while the projected diameter is at least minPixels[l]. The
+// level each entity had last frame is remembered, and an entity only changes
+// level once it is a hysteresis fraction past the threshold, so instances
+// sitting on a boundary do not pop back and forth. Entity handles are per
+// store, so use one selector per store.
+class LodSelector
+{
+public:
+    void setLevels(int levelCount, const float* minPixels);
+    int levelCount() const { return levels; }
+
+    // Fraction of a threshold an instance has to move past it before switching
+    float hysteresis = 0.15f;
+
+    // Call once per frame before selecting
+    void beginFrame(const glm::mat4& view, const glm::mat4& projection, float viewportHeight);
+
+    float projectedDiameter(const glm::vec3& center, float radius) const;
+
+    // Level for one entity, updating its history
+    int select(EntityId id, const glm::vec3& center, float radius);
+
+    // Selects a level for every visible instance of a store, whose mesh has the
+    // given local radius. With jobs the selection is split over the workers; each
+    // entity only touches its own history, so the levels come out the same.
+    void bucket(const EntityStore& store, const std::vector<uint32_t>& visible, float meshRadius, LodBuckets& buckets,
+        JobSystem* jobs = nullptr);
+
+    // Drops the per-entity history, e.g. after the store was cleared
+    void reset() { history.clear(); }
+
+private:
+    int levels = 1;
+    float minPixels[MAX_LOD_LEVELS] = {};
+
+    // View-space depth is dot(depthRow, (position, 1))
+    glm::vec4 depthRow = glm::vec4(0.0f, 0.0f, 1.0f, 0.0f);
+    float pixelsPerUnit = 1.0f;
+
+    std::vector<uint8_t> history;
+    std::vector<uint8_t> selected;
+};
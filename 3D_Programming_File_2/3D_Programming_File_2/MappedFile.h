@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Mapped File
+// Read-only memory mapping of a whole file. Pages are loaded by the OS on first
+// touch, so opening is O(1) and reading the data is bounded by I/O rather than
+// by copying it through a stream.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Returns false and prints the reason if the file cannot be mapped
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return bytes != nullptr; }
+    const unsigned char* data() const { return bytes; }
+    size_t size() const { return byteCount; }
+
+private:
+    const unsigned char* bytes = nullptr;
+    size_t byteCount = 0;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+};
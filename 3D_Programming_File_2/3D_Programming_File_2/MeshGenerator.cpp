@@ -0,0 +1,332 @@
+#include "MeshGenerator.h"
+#include <gtc/constants.hpp>
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include <unordered_map>
+
+// Sizes both buffers once and picks the index width from the vertex count
+static void allocateMesh(MeshData& mesh, size_t vertexCount, size_t indexCount)
+{
+    mesh.vertices.resize(vertexCount * 3);
+    mesh.shortIndices.clear();
+    mesh.intIndices.clear();
+    if (vertexCount <= 65536)
+    {
+        mesh.shortIndices.resize(indexCount);
+    }
+    else
+    {
+        mesh.intIndices.resize(indexCount);
+    }
+}
+
+// Calls write with a pointer to whichever index buffer the mesh uses
+template <typename Write>
+static void writeIndices(MeshData& mesh, Write write)
+{
+    if (mesh.usesShortIndices())
+    {
+        write(mesh.shortIndices.data());
+    }
+    else
+    {
+        write(mesh.intIndices.data());
+    }
+}
+
+// UV Sphere
+// Rows of sectors + 1 vertices (the seam is duplicated) from pole to pole. The
+// first and last row of quads touch a pole, so one triangle of each is
+// degenerate and is left out.
+static void buildUvSphere(MeshData& mesh, float radius, int sectors, int stacks)
+{
+    size_t vertexCount = static_cast<size_t>(stacks + 1) * (sectors + 1);
+    size_t indexCount = static_cast<size_t>(sectors) * (stacks > 1 ? stacks - 1 : 1) * 6;
+    allocateMesh(mesh, vertexCount, indexCount);
+
+    float* vertex = mesh.vertices.data();
+    for (int i = 0; i <= stacks; ++i)
+    {
+        float stackAngle = glm::pi<float>() * static_cast<float>(i) / stacks;
+        float stackRadius = radius * std::sin(stackAngle);
+        float stackHeight = radius * std::cos(stackAngle);
+        for (int j = 0; j <= sectors; ++j)
+        {
+            float sectorAngle = 2 * glm::pi<float>() * static_cast<float>(j) / sectors;
+            *vertex++ = stackRadius * std::sin(sectorAngle);
+            *vertex++ = stackHeight;
+            *vertex++ = stackRadius * std::cos(sectorAngle);
+        }
+    }
+
+    writeIndices(mesh, [&](auto* index)
+    {
+        typedef typename std::remove_pointer<decltype(index)>::type Index;
+        for (int i = 0; i < stacks; ++i)
+        {
+            for (int j = 0; j < sectors; ++j)
+            {
+                Index k0 = static_cast<Index>(i * (sectors + 1) + j);
+                Index k1 = static_cast<Index>(k0 + 1);
+                Index k2 = static_cast<Index>((i + 1) * (sectors + 1) + j + 1);
+                Index k3 = static_cast<Index>(k2 - 1);
+                if (i != 0 || stacks == 1)
+                {
+                    *index++ = k0;
+                    *index++ = k1;
+                    *index++ = k2;
+                }
+                if (i != stacks - 1 || stacks == 1)
+                {
+                    *index++ = k0;
+                    *index++ = k2;
+                    *index++ = k3;
+                }
+            }
+        }
+    });
+}
+
+MeshLods generateUvSphereLods(float radius, int sectors, int stacks, int levels)
+{
+    MeshLods lods(std::max(levels, 1));
+    for (size_t level = 0; level < lods.size(); ++level)
+    {
+        buildUvSphere(lods[level], radius, std::max(sectors >> level, 6), std::max(stacks >> level, 3));
+    }
+    return lods;
+}
+
+MeshData generateUvSphere(float radius, int sectors, int stacks)
+{
+    MeshData mesh;
+    buildUvSphere(mesh, radius, sectors, stacks);
+    return mesh;
+}
+
+// Icosphere
+// Every subdivision splits each triangle into four. New vertices are only ever
+// appended, so the vertices of a coarser level are a prefix of the finer one and
+// all levels can be taken from a single run of subdivisions.
+MeshLods generateIcosphereLods(float radius, int subdivisions, int levels)
+{
+    subdivisions = std::max(subdivisions, 0);
+    levels = std::max(1, std::min(levels, subdivisions + 1));
+
+    // Sizes of the finest level: 10 * 4^n + 2 vertices and 20 * 4^n triangles
+    size_t finestVertices = 10 * (size_t(1) << (2 * subdivisions)) + 2;
+    size_t finestTriangles = 20 * (size_t(1) << (2 * subdivisions));
+
+    std::vector<glm::vec3> positions;
+    positions.reserve(finestVertices);
+    const float t = (1.0f + std::sqrt(5.0f)) * 0.5f;
+    const glm::vec3 corners[12] =
+    {
+        glm::vec3(-1, t, 0), glm::vec3(1, t, 0), glm::vec3(-1, -t, 0), glm::vec3(1, -t, 0),
+        glm::vec3(0, -1, t), glm::vec3(0, 1, t), glm::vec3(0, -1, -t), glm::vec3(0, 1, -t),
+        glm::vec3(t, 0, -1), glm::vec3(t, 0, 1), glm::vec3(-t, 0, -1), glm::vec3(-t, 0, 1)
+    };
+    for (const glm::vec3& corner : corners)
+    {
+        positions.push_back(glm::normalize(corner));
+    }
+
+    std::vector<uint32_t> triangles =
+    {
+        0, 11, 5, 0, 5, 1, 0, 1, 7, 0, 7, 10, 0, 10, 11,
+        1, 5, 9, 5, 11, 4, 11, 10, 2, 10, 7, 6, 7, 1, 8,
+        3, 9, 4, 3, 4, 2, 3, 2, 6, 3, 6, 8, 3, 8, 9,
+        4, 9, 5, 2, 4, 11, 6, 2, 10, 8, 6, 7, 9, 8, 1
+    };
+    triangles.reserve(finestTriangles * 3);
+    std::vector<uint32_t> subdivided;
+    subdivided.reserve(finestTriangles * 3);
+    std::unordered_map<uint64_t, uint32_t> midpoints;
+    midpoints.reserve(finestVertices);
+
+    MeshLods lods(levels);
+    for (int subdivision = 0; subdivision <= subdivisions; ++subdivision)
+    {
+        // Levels are stored finest first
+        int level = subdivisions - subdivision;
+        if (level < levels)
+        {
+            MeshData& mesh = lods[level];
+            allocateMesh(mesh, positions.size(), triangles.size());
+            for (size_t i = 0; i < positions.size(); ++i)
+            {
+                mesh.vertices[i * 3] = positions[i].x * radius;
+                mesh.vertices[i * 3 + 1] = positions[i].y * radius;
+                mesh.vertices[i * 3 + 2] = positions[i].z * radius;
+            }
+            writeIndices(mesh, [&](auto* index)
+            {
+                typedef typename std::remove_pointer<decltype(index)>::type Index;
+                for (uint32_t vertex : triangles)
+                {
+                    *index++ = static_cast<Index>(vertex);
+                }
+            });
+        }
+        if (subdivision == subdivisions)
+        {
+            break;
+        }
+
+        auto midpoint = [&](uint32_t a, uint32_t b)
+        {
+            uint64_t key = (static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
+            auto found = midpoints.find(key);
+            if (found != midpoints.end())
+            {
+                return found->second;
+            }
+            uint32_t index = static_cast<uint32_t>(positions.size());
+            positions.push_back(glm::normalize(positions[a] + positions[b]));
+            midpoints.emplace(key, index);
+            return index;
+        };
+
+        subdivided.clear();
+        for (size_t i = 0; i < triangles.size(); i += 3)
+        {
+            uint32_t a = triangles[i];
+            uint32_t b = triangles[i + 1];
+            uint32_t c = triangles[i + 2];
+            uint32_t ab = midpoint(a, b);
+            uint32_t bc = midpoint(b, c);
+            uint32_t ca = midpoint(c, a);
+            const uint32_t split[12] = { a, ab, ca, b, bc, ab, c, ca, bc, ab, bc, ca };
+            subdivided.insert(subdivided.end(), split, split + 12);
+        }
+        triangles.swap(subdivided);
+        midpoints.clear();
+    }
+    return lods;
+}
+
+MeshData generateIcosphere(float radius, int subdivisions)
+{
+    return generateIcosphereLods(radius, subdivisions, 1)[0];
+}
+
+// Box
+MeshData generateBox(const glm::vec3& halfExtents)
+{
+    static const float corners[8][3] =
+    {
+        { -1, -1, 1 }, { 1, -1, 1 }, { 1, 1, 1 }, { -1, 1, 1 },
+        { -1, -1, -1 }, { 1, -1, -1 }, { 1, 1, -1 }, { -1, 1, -1 }
+    };
+    static const uint16_t indices[36] =
+    {
+        0, 1, 2, 2, 3, 0,
+        4, 5, 6, 6, 7, 4,
+        4, 0, 3, 3, 7, 4,
+        1, 5, 6, 6, 2, 1,
+        3, 2, 6, 6, 7, 3,
+        0, 1, 5, 5, 4, 0
+    };
+
+    MeshData mesh;
+    allocateMesh(mesh, 8, 36);
+    for (int i = 0; i < 8; ++i)
+    {
+        mesh.vertices[i * 3] = corners[i][0] * halfExtents.x;
+        mesh.vertices[i * 3 + 1] = corners[i][1] * halfExtents.y;
+        mesh.vertices[i * 3 + 2] = corners[i][2] * halfExtents.z;
+    }
+    std::copy(indices, indices + 36, mesh.shortIndices.begin());
+    return mesh;
+}
+
+// Plane
+MeshData generatePlane(float width, float depth, int segmentsX, int segmentsZ)
+{
+    segmentsX = std::max(segmentsX, 1);
+    segmentsZ = std::max(segmentsZ, 1);
+
+    MeshData mesh;
+    allocateMesh(mesh, static_cast<size_t>(segmentsX + 1) * (segmentsZ + 1), static_cast<size_t>(segmentsX) * segmentsZ * 6);
+
+    float* vertex = mesh.vertices.data();
+    for (int z = 0; z <= segmentsZ; ++z)
+    {
+        for (int x = 0; x <= segmentsX; ++x)
+        {
+            *vertex++ = (static_cast<float>(x) / segmentsX - 0.5f) * width;
+            *vertex++ = 0.0f;
+            *vertex++ = (static_cast<float>(z) / segmentsZ - 0.5f) * depth;
+        }
+    }
+
+    writeIndices(mesh, [&](auto* index)
+    {
+        typedef typename std::remove_pointer<decltype(index)>::type Index;
+        for (int z = 0; z < segmentsZ; ++z)
+        {
+            for (int x = 0; x < segmentsX; ++x)
+            {
+                Index k0 = static_cast<Index>(z * (segmentsX + 1) + x);
+                Index k1 = static_cast<Index>(k0 + 1);
+                Index k2 = static_cast<Index>(k0 + segmentsX + 2);
+                Index k3 = static_cast<Index>(k0 + segmentsX + 1);
+                *index++ = k0;
+                *index++ = k1;
+                *index++ = k2;
+                *index++ = k2;
+                *index++ = k3;
+                *index++ = k0;
+            }
+        }
+    });
+    return mesh;
+}
+
+// Mesh Cache
+template <typename Generate>
+const MeshLods& MeshGenerator::findOrGenerate(const Key& key, Generate generate)
+{
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    auto found = cache.find(key);
+    if (found != cache.end())
+    {
+        ++hits;
+        return found->second;
+    }
+    ++misses;
+    return cache.emplace(key, generate()).first->second;
+}
+
+const MeshLods& MeshGenerator::uvSphere(float radius, int sectors, int stacks, int levels)
+{
+    return findOrGenerate(Key(SHAPE_UV_SPHERE, radius, 0.0f, 0.0f, sectors, stacks, levels),
+        [&]() { return generateUvSphereLods(radius, sectors, stacks, levels); });
+}
+
+const MeshLods& MeshGenerator::icosphere(float radius, int subdivisions, int levels)
+{
+    return findOrGenerate(Key(SHAPE_ICOSPHERE, radius, 0.0f, 0.0f, subdivisions, levels, 0),
+        [&]() { return generateIcosphereLods(radius, subdivisions, levels); });
+}
+
+const MeshLods& MeshGenerator::box(const glm::vec3& halfExtents)
+{
+    return findOrGenerate(Key(SHAPE_BOX, halfExtents.x, halfExtents.y, halfExtents.z, 0, 0, 0),
+        [&]() { return MeshLods(1, generateBox(halfExtents)); });
+}
+
+const MeshLods& MeshGenerator::plane(float width, float depth, int segmentsX, int segmentsZ)
+{
+    return findOrGenerate(Key(SHAPE_PLANE, width, depth, 0.0f, segmentsX, segmentsZ, 0),
+        [&]() { return MeshLods(1, generatePlane(width, depth, segmentsX, segmentsZ)); });
+}
+
+void MeshGenerator::clear()
+{
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    cache.clear();
+    hits = 0;
+    misses = 0;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+// Generated Mesh
+// Tightly packed xyz positions plus an index list. Meshes with at most 65536
+// vertices are indexed with 16-bit indices, anything larger with 32-bit ones;
+// exactly one of the two index vectors is filled.
+struct MeshData
+{
+    std::vector<float> vertices;
+    std::vector<uint16_t> shortIndices;
+    std::vector<uint32_t> intIndices;
+
+    size_t vertexCount() const { return vertices.size() / 3; }
+    size_t indexCount() const { return usesShortIndices() ? shortIndices.size() : intIndices.size(); }
+    bool usesShortIndices() const { return intIndices.empty(); }
+    size_t triangleCount() const { return indexCount() / 3; }
+};
+
+// LOD chain, level 0 is the most detailed
+typedef std::vector<MeshData> MeshLods;
+
+// Mesh Generation
+// Every generator computes the exact vertex and index counts first and writes
+// into buffers sized once, so generation never reallocates. The LOD versions
+// build all levels in one call.
+
+// Latitude/longitude sphere, each LOD halves sectors and stacks down to 6 x 3
+MeshLods generateUvSphereLods(float radius, int sectors, int stacks, int levels);
+MeshData generateUvSphere(float radius, int sectors, int stacks);
+
+// Subdivided icosahedron, each LOD is one subdivision less than the previous one
+MeshLods generateIcosphereLods(float radius, int subdivisions, int levels);
+MeshData generateIcosphere(float radius, int subdivisions);
+
+// Axis-aligned box centred on the origin, 8 shared corners
+MeshData generateBox(const glm::vec3& halfExtents);
+
+// Grid in the XZ plane centred on the origin
+MeshData generatePlane(float width, float depth, int segmentsX, int segmentsZ);
+
+// Mesh Generator
+// Caches generated meshes by shape and parameters, so asking for the same mesh
+// twice returns the first result. References stay valid for the generator's
+// lifetime, and requests may come from several threads.
+class MeshGenerator
+{
+public:
+    const MeshLods& uvSphere(float radius, int sectors, int stacks, int levels = 1);
+    const MeshLods& icosphere(float radius, int subdivisions, int levels = 1);
+    const MeshLods& box(const glm::vec3& halfExtents);
+    const MeshLods& plane(float width, float depth, int segmentsX, int segmentsZ);
+
+    size_t cacheHits() const { return hits; }
+    size_t cacheMisses() const { return misses; }
+    void clear();
+
+private:
+    enum Shape { SHAPE_UV_SPHERE, SHAPE_ICOSPHERE, SHAPE_BOX, SHAPE_PLANE };
+    typedef std::tuple<int, float, float, float, int, int, int> Key;
+
+    template <typename Generate>
+    const MeshLods& findOrGenerate(const Key& key, Generate generate);
+
+    std::map<Key, MeshLods> cache;
+    std::mutex cacheMutex;
+    size_t hits = 0;
+    size_t misses = 0;
+};
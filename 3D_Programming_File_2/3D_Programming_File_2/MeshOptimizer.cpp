@@ -0,0 +1,331 @@
+#include "MeshOptimizer.h"
+#include <glm.hpp>
+#include <algorithm>
+#include <cmath>
+
+static const uint32_t UNUSED_VERTEX = 0xFFFFFFFFu;
+
+VertexCacheStats analyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, size_t cacheSize)
+{
+    VertexCacheStats stats;
+    if (indexCount < 3)
+    {
+        return stats;
+    }
+
+    // A vertex is cached if fewer than cacheSize misses happened since it was loaded
+    std::vector<size_t> loadedAt(vertexCount, 0);
+    std::vector<bool> referenced(vertexCount, false);
+    size_t misses = 0;
+    size_t referencedCount = 0;
+    for (size_t i = 0; i < indexCount; ++i)
+    {
+        uint32_t vertex = indices[i];
+        if (!referenced[vertex])
+        {
+            referenced[vertex] = true;
+            ++referencedCount;
+        }
+        if (loadedAt[vertex] == 0 || misses - loadedAt[vertex] >= cacheSize)
+        {
+            ++misses;
+            loadedAt[vertex] = misses;
+        }
+    }
+
+    stats.acmr = static_cast<float>(misses) / (indexCount / 3);
+    stats.atvr = static_cast<float>(misses) / referencedCount;
+    return stats;
+}
+
+// Vertex Cache Optimization
+// Every vertex is scored by its position in a simulated LRU cache and by how
+// many of its triangles are still waiting, favouring vertices that are about to
+// be finished. The next triangle is the best scoring one touching the cache.
+static const int FORSYTH_CACHE_SIZE = 32;
+
+static float forsythVertexScore(int cachePosition, uint32_t remainingTriangles)
+{
+    if (remainingTriangles == 0)
+    {
+        return -1.0f;
+    }
+
+    float score = 0.0f;
+    if (cachePosition >= 0)
+    {
+        // The last triangle's vertices get a fixed score so the next one does not just reuse its edge
+        if (cachePosition < 3)
+        {
+            score = 0.75f;
+        }
+        else
+        {
+            float scaler = 1.0f - static_cast<float>(cachePosition - 3) / (FORSYTH_CACHE_SIZE - 3);
+            score = std::pow(scaler, 1.5f);
+        }
+    }
+    return score + 2.0f / std::sqrt(static_cast<float>(remainingTriangles));
+}
+
+void optimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount)
+{
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount < 2)
+    {
+        return;
+    }
+
+    // Vertex -> triangles adjacency
+    std::vector<uint32_t> remaining(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; ++i)
+    {
+        ++remaining[indices[i]];
+    }
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        offsets[vertex + 1] = offsets[vertex] + remaining[vertex];
+    }
+    std::vector<uint32_t> adjacency(triangleCount * 3);
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < triangleCount * 3; ++i)
+    {
+        adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount);
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        vertexScore[vertex] = forsythVertexScore(-1, remaining[vertex]);
+    }
+
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    int best = 0;
+    for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+    {
+        const uint32_t* corner = indices + triangle * 3;
+        triangleScore[triangle] = vertexScore[corner[0]] + vertexScore[corner[1]] + vertexScore[corner[2]];
+        if (triangleScore[triangle] > triangleScore[best])
+        {
+            best = static_cast<int>(triangle);
+        }
+    }
+
+    std::vector<uint32_t> output(triangleCount * 3);
+    std::vector<uint32_t> cache;
+    std::vector<uint32_t> nextCache;
+    cache.reserve(FORSYTH_CACHE_SIZE + 3);
+    nextCache.reserve(FORSYTH_CACHE_SIZE + 3);
+    size_t deadEndCursor = 0;
+
+    for (size_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount)
+    {
+        // Nothing in the cache has triangles left, continue with the next triangle in input order
+        if (best < 0)
+        {
+            while (emitted[deadEndCursor])
+            {
+                ++deadEndCursor;
+            }
+            best = static_cast<int>(deadEndCursor);
+        }
+
+        const uint32_t* corner = indices + best * 3;
+        std::copy(corner, corner + 3, output.begin() + emittedCount * 3);
+        emitted[best] = true;
+
+        // Emitted vertices move to the front of the LRU cache
+        nextCache.clear();
+        for (int i = 0; i < 3; ++i)
+        {
+            --remaining[corner[i]];
+            nextCache.push_back(corner[i]);
+        }
+        for (uint32_t vertex : cache)
+        {
+            if (vertex != corner[0] && vertex != corner[1] && vertex != corner[2])
+            {
+                nextCache.push_back(vertex);
+            }
+        }
+
+        // Rescore everything that was or is in the cache, evicted vertices drop to position -1
+        for (size_t i = 0; i < nextCache.size(); ++i)
+        {
+            uint32_t vertex = nextCache[i];
+            cachePosition[vertex] = i < FORSYTH_CACHE_SIZE ? static_cast<int>(i) : -1;
+            vertexScore[vertex] = forsythVertexScore(cachePosition[vertex], remaining[vertex]);
+        }
+
+        best = -1;
+        float bestScore = -1.0f;
+        for (uint32_t vertex : nextCache)
+        {
+            for (uint32_t a = offsets[vertex]; a < offsets[vertex + 1]; ++a)
+            {
+                uint32_t triangle = adjacency[a];
+                if (emitted[triangle])
+                {
+                    continue;
+                }
+                const uint32_t* other = indices + triangle * 3;
+                float score = vertexScore[other[0]] + vertexScore[other[1]] + vertexScore[other[2]];
+                triangleScore[triangle] = score;
+                if (score > bestScore)
+                {
+                    bestScore = score;
+                    best = static_cast<int>(triangle);
+                }
+            }
+        }
+
+        if (nextCache.size() > FORSYTH_CACHE_SIZE)
+        {
+            nextCache.resize(FORSYTH_CACHE_SIZE);
+        }
+        cache.swap(nextCache);
+    }
+
+    std::copy(output.begin(), output.end(), indices);
+}
+
+// Overdraw Optimization
+// Cache-optimized orders start a new cluster wherever a triangle misses the
+// cache with all three vertices, so reordering whole clusters keeps the ACMR
+// close to what the cache pass produced.
+void optimizeOverdraw(const float* vertices, uint32_t* indices, size_t indexCount, size_t vertexCount, size_t cacheSize)
+{
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount < 2)
+    {
+        return;
+    }
+
+    std::vector<size_t> clusterStarts;
+    std::vector<size_t> loadedAt(vertexCount, 0);
+    size_t misses = 0;
+    for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+    {
+        int triangleMisses = 0;
+        for (int i = 0; i < 3; ++i)
+        {
+            uint32_t vertex = indices[triangle * 3 + i];
+            if (loadedAt[vertex] == 0 || misses - loadedAt[vertex] >= cacheSize)
+            {
+                ++misses;
+                loadedAt[vertex] = misses;
+                ++triangleMisses;
+            }
+        }
+        if (triangle == 0 || triangleMisses == 3)
+        {
+            clusterStarts.push_back(triangle);
+        }
+    }
+    if (clusterStarts.size() < 2)
+    {
+        return;
+    }
+    clusterStarts.push_back(triangleCount);
+
+    // Area-weighted centroid and normal per cluster
+    size_t clusterCount = clusterStarts.size() - 1;
+    std::vector<glm::vec3> clusterCentroid(clusterCount, glm::vec3(0.0f));
+    std::vector<glm::vec3> clusterNormal(clusterCount, glm::vec3(0.0f));
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    for (size_t cluster = 0; cluster < clusterCount; ++cluster)
+    {
+        float clusterArea = 0.0f;
+        for (size_t triangle = clusterStarts[cluster]; triangle < clusterStarts[cluster + 1]; ++triangle)
+        {
+            const uint32_t* corner = indices + triangle * 3;
+            glm::vec3 a(vertices[corner[0] * 3], vertices[corner[0] * 3 + 1], vertices[corner[0] * 3 + 2]);
+            glm::vec3 b(vertices[corner[1] * 3], vertices[corner[1] * 3 + 1], vertices[corner[1] * 3 + 2]);
+            glm::vec3 c(vertices[corner[2] * 3], vertices[corner[2] * 3 + 1], vertices[corner[2] * 3 + 2]);
+            glm::vec3 normal = glm::cross(b - a, c - a);
+            float area = glm::length(normal);
+            clusterCentroid[cluster] += (a + b + c) * (area / 3.0f);
+            clusterNormal[cluster] += normal;
+            clusterArea += area;
+        }
+        meshCentroid += clusterCentroid[cluster];
+        meshArea += clusterArea;
+        clusterCentroid[cluster] = clusterArea > 0.0f ? clusterCentroid[cluster] / clusterArea : glm::vec3(0.0f);
+    }
+    meshCentroid = meshArea > 0.0f ? meshCentroid / meshArea : glm::vec3(0.0f);
+
+    std::vector<float> sortKey(clusterCount);
+    std::vector<size_t> order(clusterCount);
+    for (size_t cluster = 0; cluster < clusterCount; ++cluster)
+    {
+        float normalLength = glm::length(clusterNormal[cluster]);
+        glm::vec3 normal = normalLength > 0.0f ? clusterNormal[cluster] / normalLength : glm::vec3(0.0f);
+        sortKey[cluster] = glm::dot(clusterCentroid[cluster] - meshCentroid, normal);
+        order[cluster] = cluster;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sortKey[a] > sortKey[b]; });
+
+    std::vector<uint32_t> output;
+    output.reserve(triangleCount * 3);
+    for (size_t cluster : order)
+    {
+        output.insert(output.end(), indices + clusterStarts[cluster] * 3, indices + clusterStarts[cluster + 1] * 3);
+    }
+    std::copy(output.begin(), output.end(), indices);
+}
+
+void optimizeVertexFetch(std::vector<float>& vertices, std::vector<uint32_t>& indices)
+{
+    size_t vertexCount = vertices.size() / 3;
+    std::vector<uint32_t> remap(vertexCount, UNUSED_VERTEX);
+    uint32_t next = 0;
+    for (uint32_t& index : indices)
+    {
+        if (remap[index] == UNUSED_VERTEX)
+        {
+            remap[index] = next++;
+        }
+        index = remap[index];
+    }
+    for (uint32_t& target : remap)
+    {
+        if (target == UNUSED_VERTEX)
+        {
+            target = next++;
+        }
+    }
+
+    std::vector<float> reordered(vertices.size());
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        std::copy(vertices.begin() + vertex * 3, vertices.begin() + vertex * 3 + 3, reordered.begin() + remap[vertex] * 3);
+    }
+    vertices.swap(reordered);
+}
+
+MeshOptimizeReport optimizeMesh(std::vector<float>& vertices, std::vector<uint32_t>& indices, const std::vector<size_t>& sectionEnds)
+{
+    size_t vertexCount = vertices.size() / 3;
+    MeshOptimizeReport report;
+    report.before = analyzeVertexCache(indices.data(), indices.size(), vertexCount);
+
+    size_t sectionStart = 0;
+    for (size_t i = 0; i <= sectionEnds.size(); ++i)
+    {
+        size_t sectionEnd = i < sectionEnds.size() ? std::min(sectionEnds[i], indices.size()) : indices.size();
+        if (sectionEnd > sectionStart)
+        {
+            optimizeVertexCache(indices.data() + sectionStart, sectionEnd - sectionStart, vertexCount);
+            optimizeOverdraw(vertices.data(), indices.data() + sectionStart, sectionEnd - sectionStart, vertexCount);
+            sectionStart = sectionEnd;
+        }
+    }
+    optimizeVertexFetch(vertices, indices);
+
+    report.after = analyzeVertexCache(indices.data(), indices.size(), vertexCount);
+    return report;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Mesh Optimizer
+// Load-time reordering of indexed triangle lists (tightly packed xyz vertices,
+// 32-bit indices) for the GPU's post-transform vertex cache, for overdraw and
+// for vertex fetch locality. None of the passes changes what is drawn.
+
+// Vertex Cache Stats
+// ACMR: vertex shader runs per triangle (0.5 is ideal for large grids, 3 is worst).
+// ATVR: vertex shader runs per referenced vertex (1 is ideal).
+struct VertexCacheStats
+{
+    float acmr = 0.0f;
+    float atvr = 0.0f;
+};
+
+// Simulates a FIFO post-transform cache of the given size
+VertexCacheStats analyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, size_t cacheSize = 16);
+
+// Forsyth's linear-speed vertex cache optimization, reorders the triangles in place
+void optimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount);
+
+// Splits the triangles into clusters at cache restarts and orders the clusters so
+// outward-facing ones are drawn first, which draws convex parts front to back
+void optimizeOverdraw(const float* vertices, uint32_t* indices, size_t indexCount, size_t vertexCount, size_t cacheSize = 16);
+
+// Renumbers vertices in the order the index buffer first uses them, unused vertices go last
+void optimizeVertexFetch(std::vector<float>& vertices, std::vector<uint32_t>& indices);
+
+// Optimize Report
+struct MeshOptimizeReport
+{
+    VertexCacheStats before;
+    VertexCacheStats after;
+};
+
+// Runs all passes. Triangles are only reordered within sections, which end at
+// each entry of sectionEnds and at the end of the index list, so ranges a
+// submesh refers to stay intact.
+MeshOptimizeReport optimizeMesh(std::vector<float>& vertices, std::vector<uint32_t>& indices,
+    const std::vector<size_t>& sectionEnds = std::vector<size_t>());
@@ -0,0 +1,479 @@
+#include "MeshRegistry.h"
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+static size_t alignUp(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+static size_t indexSize(GLenum indexType)
+{
+    return indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+}
+
+void MeshRegistry::create(size_t vertexCapacity, size_t indexCapacity)
+{
+    vertexByteCapacity = std::max<size_t>(vertexCapacity, 1) * vertexFormatSize(VERTEX_FLOAT3);
+    indexByteCapacity = std::max<size_t>(indexCapacity, 1) * sizeof(GLuint);
+    vertexBytes = 0;
+    indexBytes = 0;
+    meshes.clear();
+    meshBounds.clear();
+    reports.clear();
+    quantization.clear();
+    vertexRanges.clear();
+    indexRanges.clear();
+    live.clear();
+    freeHandles.clear();
+    freeVertexRanges.clear();
+    freeIndexRanges.clear();
+
+    glGenVertexArrays(VERTEX_FORMAT_COUNT, vaos);
+    glGenBuffers(1, &vbo);
+    glGenBuffers(1, &ebo);
+
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, vertexByteCapacity, nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, ebo);
+    glBufferData(GL_COPY_WRITE_BUFFER, indexByteCapacity, nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    setVertexFormats();
+}
+
+void MeshRegistry::destroy()
+{
+    glDeleteVertexArrays(VERTEX_FORMAT_COUNT, vaos);
+    glDeleteBuffers(1, &vbo);
+    glDeleteBuffers(1, &ebo);
+    std::fill(vaos, vaos + VERTEX_FORMAT_COUNT, 0);
+    vbo = ebo = 0;
+    meshes.clear();
+    meshBounds.clear();
+    reports.clear();
+    quantization.clear();
+    vertexRanges.clear();
+    indexRanges.clear();
+    live.clear();
+    freeHandles.clear();
+    freeVertexRanges.clear();
+    freeIndexRanges.clear();
+}
+
+// Points attribute 0 of every format's VAO at the shared buffers
+void MeshRegistry::setVertexFormats() const
+{
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    for (uint32_t format = 0; format < VERTEX_FORMAT_COUNT; ++format)
+    {
+        GLsizei stride = static_cast<GLsizei>(vertexFormatSize(static_cast<VertexFormat>(format)));
+        glBindVertexArray(vaos[format]);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+        switch (format)
+        {
+        case VERTEX_SNORM16:
+            glVertexAttribPointer(0, 4, GL_SHORT, GL_TRUE, stride, (void*)0);
+            break;
+        case VERTEX_HALF:
+            glVertexAttribPointer(0, 4, GL_HALF_FLOAT, GL_FALSE, stride, (void*)0);
+            break;
+        case VERTEX_SNORM10:
+            glVertexAttribPointer(0, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (void*)0);
+            break;
+        default:
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+            break;
+        }
+        glEnableVertexAttribArray(0);
+    }
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    boundFormat = VERTEX_FORMAT_COUNT;
+}
+
+// Prepared Meshes
+size_t PreparedMesh::byteSize() const
+{
+    return vertices.data.size() + indexCount() * (indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint));
+}
+
+// Optimizes on a 32-bit copy of the mesh, quantizes the vertices, then narrows
+// the indices to 16 bits if every index fits
+PreparedMesh prepareMesh(std::vector<GLfloat> vertices, std::vector<GLuint> indices, VertexFormat format, bool optimize,
+    const std::vector<size_t>& sectionEnds)
+{
+    PreparedMesh mesh;
+    mesh.vertexCount = vertices.size() / 3;
+    mesh.vertexFormat = format;
+    if (optimize)
+    {
+        mesh.report = optimizeMesh(vertices, indices, sectionEnds);
+    }
+    else
+    {
+        mesh.report.before = mesh.report.after = analyzeVertexCache(indices.data(), indices.size(), mesh.vertexCount);
+    }
+
+    mesh.vertices = quantizeVertices(vertices.data(), mesh.vertexCount, format);
+    mesh.bounds = computeBoundingSphere(vertices.data(), mesh.vertexCount);
+    mesh.bounds.radius += mesh.vertices.bounds.maxError;
+
+    if (mesh.vertexCount > 65536)
+    {
+        mesh.indexType = GL_UNSIGNED_INT;
+        mesh.intIndices = std::move(indices);
+    }
+    else
+    {
+        mesh.indexType = GL_UNSIGNED_SHORT;
+        mesh.shortIndices.assign(indices.begin(), indices.end());
+    }
+    return mesh;
+}
+
+PreparedMesh prepareMesh(const MeshData& mesh, VertexFormat format, bool optimize, const std::vector<size_t>& sectionEnds)
+{
+    std::vector<GLuint> indices;
+    if (mesh.usesShortIndices())
+    {
+        indices.assign(mesh.shortIndices.begin(), mesh.shortIndices.end());
+    }
+    else
+    {
+        indices = mesh.intIndices;
+    }
+    return prepareMesh(mesh.vertices, std::move(indices), format, optimize, sectionEnds);
+}
+
+MeshHandle MeshRegistry::add(const GLfloat* vertices, size_t vertexCount, const GLuint* indices, size_t indexCount,
+    const std::vector<size_t>& sectionEnds)
+{
+    std::vector<GLfloat> vertexData(vertices, vertices + vertexCount * 3);
+    std::vector<GLuint> indexData(indices, indices + indexCount);
+    return add(prepareMesh(std::move(vertexData), std::move(indexData), vertexFormat, optimizeMeshes, sectionEnds));
+}
+
+MeshHandle MeshRegistry::add(const GLfloat* vertices, size_t vertexCount, const GLushort* indices, size_t indexCount)
+{
+    std::vector<GLfloat> vertexData(vertices, vertices + vertexCount * 3);
+    std::vector<GLuint> indexData(indices, indices + indexCount);
+    return add(prepareMesh(std::move(vertexData), std::move(indexData), vertexFormat, optimizeMeshes));
+}
+
+MeshHandle MeshRegistry::add(const MeshData& mesh)
+{
+    return add(prepareMesh(mesh, vertexFormat, optimizeMeshes));
+}
+
+MeshHandle MeshRegistry::add(const PreparedMesh& mesh)
+{
+    // baseVertex counts in whole vertices of the mesh's format, and 32-bit indices
+    // have to start on a 4-byte boundary after a run of 16-bit ones
+    size_t stride = vertexFormatSize(mesh.vertexFormat);
+    size_t size = indexSize(mesh.indexType);
+    size_t indexCount = mesh.indexCount();
+    size_t indexByteCount = indexCount * size;
+    size_t vertexOffset, indexOffset;
+    allocate(mesh.vertices.data.size(), stride, indexByteCount, size, vertexOffset, indexOffset);
+
+    MeshRange range;
+    range.baseVertex = static_cast<GLint>(vertexOffset / stride);
+    range.vertexCount = static_cast<GLuint>(mesh.vertexCount);
+    range.indexOffset = static_cast<GLuint>(indexOffset);
+    range.indexCount = static_cast<GLsizei>(indexCount);
+    range.indexType = mesh.indexType;
+    range.vertexFormat = mesh.vertexFormat;
+
+    const void* indices = mesh.indexType == GL_UNSIGNED_SHORT ? static_cast<const void*>(mesh.shortIndices.data()) : mesh.intIndices.data();
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferSubData(GL_ARRAY_BUFFER, vertexOffset, mesh.vertices.data.size(), mesh.vertices.data.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, ebo);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, indexOffset, indexByteCount, indices);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    ArenaRange vertexRange = { vertexOffset, mesh.vertices.data.size() };
+    ArenaRange indexRange = { indexOffset, indexByteCount };
+    return store(range, mesh.bounds, mesh.report, mesh.vertices.bounds, vertexRange, indexRange);
+}
+
+void MeshRegistry::addScene(const SceneFile& scene, std::vector<MeshHandle>& handles)
+{
+    size_t vertexOffset, indexOffset;
+    allocate(scene.vertexDataSize(), SCENE_VERTEX_ALIGNMENT, scene.indexDataSize(), sizeof(GLuint), vertexOffset, indexOffset);
+
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferSubData(GL_ARRAY_BUFFER, vertexOffset, scene.vertexDataSize(), scene.vertexData());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, ebo);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, indexOffset, scene.indexDataSize(), scene.indexData());
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    handles.clear();
+    for (size_t i = 0; i < scene.meshCount(); ++i)
+    {
+        const SceneMesh& sceneMesh = scene.mesh(i);
+        VertexFormat format = static_cast<VertexFormat>(sceneMesh.vertexFormat);
+
+        MeshRange mesh;
+        mesh.baseVertex = static_cast<GLint>((vertexOffset + sceneMesh.vertexOffset) / vertexFormatSize(format));
+        mesh.vertexCount = sceneMesh.vertexCount;
+        mesh.indexOffset = static_cast<GLuint>(indexOffset + sceneMesh.indexOffset);
+        mesh.indexCount = static_cast<GLsizei>(sceneMesh.indexCount);
+        mesh.indexType = sceneMesh.indexSize == sizeof(GLushort) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+        mesh.vertexFormat = format;
+
+        BoundingSphere sphere;
+        sphere.center = glm::vec3(sceneMesh.boundsCenter[0], sceneMesh.boundsCenter[1], sceneMesh.boundsCenter[2]);
+        sphere.radius = sceneMesh.boundsRadius;
+
+        MeshOptimizeReport report;
+        report.before.acmr = sceneMesh.acmrBefore;
+        report.before.atvr = sceneMesh.atvrBefore;
+        report.after.acmr = sceneMesh.acmrAfter;
+        report.after.atvr = sceneMesh.atvrAfter;
+
+        QuantizationBounds bounds;
+        bounds.offset = glm::vec3(sceneMesh.quantizationOffset[0], sceneMesh.quantizationOffset[1], sceneMesh.quantizationOffset[2]);
+        bounds.scale = glm::vec3(sceneMesh.quantizationScale[0], sceneMesh.quantizationScale[1], sceneMesh.quantizationScale[2]);
+        bounds.maxError = sceneMesh.quantizationError;
+
+        handles.push_back(store(mesh, sphere, report, bounds, ArenaRange(), ArenaRange()));
+    }
+}
+
+// Submeshes keep the parent's bounds, which is conservative but avoids keeping vertices on the CPU
+MeshHandle MeshRegistry::addSubmesh(MeshHandle parent, size_t firstIndex, size_t indexCount)
+{
+    MeshRange mesh = meshes[parent];
+    mesh.indexOffset += static_cast<GLuint>(firstIndex * indexSize(mesh.indexType));
+    mesh.indexCount = static_cast<GLsizei>(indexCount);
+    return store(mesh, meshBounds[parent], reports[parent], quantization[parent], ArenaRange(), ArenaRange());
+}
+
+MeshHandle MeshRegistry::store(const MeshRange& range, const BoundingSphere& sphere, const MeshOptimizeReport& report,
+    const QuantizationBounds& bounds, const ArenaRange& vertexRange, const ArenaRange& indexRange)
+{
+    if (!freeHandles.empty())
+    {
+        MeshHandle handle = freeHandles.back();
+        freeHandles.pop_back();
+        meshes[handle] = range;
+        meshBounds[handle] = sphere;
+        reports[handle] = report;
+        quantization[handle] = bounds;
+        vertexRanges[handle] = vertexRange;
+        indexRanges[handle] = indexRange;
+        live[handle] = 1;
+        return handle;
+    }
+
+    meshes.push_back(range);
+    meshBounds.push_back(sphere);
+    reports.push_back(report);
+    quantization.push_back(bounds);
+    vertexRanges.push_back(vertexRange);
+    indexRanges.push_back(indexRange);
+    live.push_back(1);
+    return static_cast<MeshHandle>(meshes.size() - 1);
+}
+
+// Free Lists
+// First fit, keeping whatever is left on either side of the aligned block
+static bool takeFreeRange(std::vector<ArenaRange>& ranges, size_t size, size_t alignment, size_t& offset)
+{
+    for (size_t i = 0; i < ranges.size(); ++i)
+    {
+        size_t start = alignUp(ranges[i].offset, alignment);
+        size_t end = ranges[i].offset + ranges[i].size;
+        if (start + size > end)
+        {
+            continue;
+        }
+
+        ArenaRange before = { ranges[i].offset, start - ranges[i].offset };
+        ArenaRange after = { start + size, end - start - size };
+        ranges.erase(ranges.begin() + i);
+        if (after.size > 0)
+        {
+            ranges.insert(ranges.begin() + i, after);
+        }
+        if (before.size > 0)
+        {
+            ranges.insert(ranges.begin() + i, before);
+        }
+        offset = start;
+        return true;
+    }
+    return false;
+}
+
+static void releaseRange(std::vector<ArenaRange>& ranges, ArenaRange range, size_t& usedBytes)
+{
+    if (range.size == 0)
+    {
+        return;
+    }
+
+    auto next = std::lower_bound(ranges.begin(), ranges.end(), range.offset,
+        [](const ArenaRange& free, size_t offset) { return free.offset < offset; });
+    if (next != ranges.end() && range.offset + range.size == next->offset)
+    {
+        range.size += next->size;
+        next = ranges.erase(next);
+    }
+    if (next != ranges.begin() && (next - 1)->offset + (next - 1)->size == range.offset)
+    {
+        (next - 1)->size += range.size;
+    }
+    else
+    {
+        ranges.insert(next, range);
+    }
+
+    // Free space at the end goes back to the arena, so appends can use it again
+    if (ranges.back().offset + ranges.back().size == usedBytes)
+    {
+        usedBytes = ranges.back().offset;
+        ranges.pop_back();
+    }
+}
+
+void MeshRegistry::allocate(size_t vertexSize, size_t vertexAlignment, size_t indexSize, size_t indexAlignment,
+    size_t& vertexOffset, size_t& indexOffset)
+{
+    bool vertexFree = takeFreeRange(freeVertexRanges, vertexSize, vertexAlignment, vertexOffset);
+    bool indexFree = takeFreeRange(freeIndexRanges, indexSize, indexAlignment, indexOffset);
+    size_t vertexEnd = vertexFree ? vertexBytes : alignUp(vertexBytes, vertexAlignment) + vertexSize;
+    size_t indexEnd = indexFree ? indexBytes : alignUp(indexBytes, indexAlignment) + indexSize;
+    if (vertexEnd > vertexByteCapacity || indexEnd > indexByteCapacity)
+    {
+        grow(std::max(vertexEnd, vertexByteCapacity), std::max(indexEnd, indexByteCapacity));
+    }
+
+    // Alignment padding before an appended block is free space like any other
+    if (!vertexFree)
+    {
+        ArenaRange padding = { vertexBytes, alignUp(vertexBytes, vertexAlignment) - vertexBytes };
+        vertexOffset = padding.offset + padding.size;
+        vertexBytes = vertexEnd;
+        releaseRange(freeVertexRanges, padding, vertexBytes);
+    }
+    if (!indexFree)
+    {
+        ArenaRange padding = { indexBytes, alignUp(indexBytes, indexAlignment) - indexBytes };
+        indexOffset = padding.offset + padding.size;
+        indexBytes = indexEnd;
+        releaseRange(freeIndexRanges, padding, indexBytes);
+    }
+}
+
+void MeshRegistry::remove(MeshHandle mesh)
+{
+    if (!isLive(mesh))
+    {
+        return;
+    }
+    releaseRange(freeVertexRanges, vertexRanges[mesh], vertexBytes);
+    releaseRange(freeIndexRanges, indexRanges[mesh], indexBytes);
+    vertexRanges[mesh] = ArenaRange();
+    indexRanges[mesh] = ArenaRange();
+    live[mesh] = 0;
+    freeHandles.push_back(mesh);
+    if (quantizationMesh == mesh)
+    {
+        quantizationMesh = INVALID_MESH;
+    }
+}
+
+size_t MeshRegistry::residentBytes() const
+{
+    size_t bytes = vertexBytes + indexBytes;
+    for (const ArenaRange& range : freeVertexRanges)
+    {
+        bytes -= range.size;
+    }
+    for (const ArenaRange& range : freeIndexRanges)
+    {
+        bytes -= range.size;
+    }
+    return bytes;
+}
+
+void MeshRegistry::bind() const
+{
+    glBindVertexArray(vaos[VERTEX_FLOAT3]);
+    boundFormat = VERTEX_FLOAT3;
+    quantizationMesh = INVALID_MESH;
+}
+
+// Binds the mesh's VAO and sets its dequantization constants, skipping whatever is already current
+void MeshRegistry::prepareDraw(MeshHandle mesh) const
+{
+    const MeshRange& range = meshes[mesh];
+    if (boundFormat != range.vertexFormat)
+    {
+        glBindVertexArray(vaos[range.vertexFormat]);
+        boundFormat = range.vertexFormat;
+    }
+    if (quantizationMesh == INVALID_MESH || quantizationMesh >= quantization.size() ||
+        quantization[quantizationMesh].offset != quantization[mesh].offset ||
+        quantization[quantizationMesh].scale != quantization[mesh].scale)
+    {
+        const QuantizationBounds& bounds = quantization[mesh];
+        glVertexAttrib4f(QUANTIZATION_OFFSET_ATTRIBUTE, bounds.offset.x, bounds.offset.y, bounds.offset.z, 0.0f);
+        glVertexAttrib4f(QUANTIZATION_SCALE_ATTRIBUTE, bounds.scale.x, bounds.scale.y, bounds.scale.z, 1.0f);
+    }
+    quantizationMesh = mesh;
+}
+
+void MeshRegistry::draw(MeshHandle mesh) const
+{
+    prepareDraw(mesh);
+    const MeshRange& range = meshes[mesh];
+    glDrawElementsBaseVertex(GL_TRIANGLES, range.indexCount, range.indexType,
+        (void*)static_cast<uintptr_t>(range.indexOffset), range.baseVertex);
+}
+
+void MeshRegistry::drawInstanced(MeshHandle mesh, GLsizei instanceCount) const
+{
+    prepareDraw(mesh);
+    const MeshRange& range = meshes[mesh];
+    glDrawElementsInstancedBaseVertex(GL_TRIANGLES, range.indexCount, range.indexType,
+        (void*)static_cast<uintptr_t>(range.indexOffset), instanceCount, range.baseVertex);
+}
+
+// Grow
+// Allocates larger buffers, copies the existing contents on the GPU and re-points the VAOs
+void MeshRegistry::grow(size_t minVertexBytes, size_t minIndexBytes)
+{
+    size_t newVertexByteCapacity = std::max(minVertexBytes, vertexByteCapacity * 2);
+    size_t newIndexByteCapacity = std::max(minIndexBytes, indexByteCapacity * 2);
+
+    GLuint newVbo, newEbo;
+    glGenBuffers(1, &newVbo);
+    glGenBuffers(1, &newEbo);
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, newVbo);
+    glBufferData(GL_COPY_WRITE_BUFFER, newVertexByteCapacity, nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_READ_BUFFER, vbo);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, vertexBytes);
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, newEbo);
+    glBufferData(GL_COPY_WRITE_BUFFER, newIndexByteCapacity, nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_READ_BUFFER, ebo);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, indexBytes);
+
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glDeleteBuffers(1, &vbo);
+    glDeleteBuffers(1, &ebo);
+    vbo = newVbo;
+    ebo = newEbo;
+    vertexByteCapacity = newVertexByteCapacity;
+    indexByteCapacity = newIndexByteCapacity;
+
+    setVertexFormats();
+}
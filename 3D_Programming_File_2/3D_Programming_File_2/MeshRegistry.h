@@ -0,0 +1,173 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Bounds.h"
+#include "MeshGenerator.h"
+#include "MeshOptimizer.h"
+#include "VertexQuantization.h"
+#include "SceneFile.h"
+
+// Mesh Handle
+typedef uint32_t MeshHandle;
+const MeshHandle INVALID_MESH = 0xFFFFFFFFu;
+
+// Mesh Range
+// Where a mesh lives inside the shared vertex and index buffers. Meshes with 16
+// and 32-bit indices share the index buffer, so the offset is in bytes.
+struct MeshRange
+{
+    GLint baseVertex = 0;
+    GLuint vertexCount = 0;
+    GLuint indexOffset = 0;
+    GLsizei indexCount = 0;
+    GLenum indexType = GL_UNSIGNED_INT;
+    VertexFormat vertexFormat = VERTEX_FLOAT3;
+};
+
+// Prepared Mesh
+// A mesh that is optimized, quantized and has its indices narrowed, ready to be
+// copied into the arena. prepareMesh only works on the CPU, so it can run on
+// any thread; the upload in MeshRegistry::add has to happen on the GL thread.
+struct PreparedMesh
+{
+    QuantizedVertices vertices;
+    size_t vertexCount = 0;
+    VertexFormat vertexFormat = VERTEX_FLOAT3;
+    GLenum indexType = GL_UNSIGNED_SHORT;
+    std::vector<GLushort> shortIndices;
+    std::vector<GLuint> intIndices;
+    BoundingSphere bounds;
+    MeshOptimizeReport report;
+
+    size_t indexCount() const { return indexType == GL_UNSIGNED_SHORT ? shortIndices.size() : intIndices.size(); }
+
+    // Vertex and index bytes the mesh takes in the arena
+    size_t byteSize() const;
+};
+
+// Triangles are only reordered within sections ending at sectionEnds
+PreparedMesh prepareMesh(std::vector<GLfloat> vertices, std::vector<GLuint> indices, VertexFormat format, bool optimize,
+    const std::vector<size_t>& sectionEnds = std::vector<size_t>());
+PreparedMesh prepareMesh(const MeshData& mesh, VertexFormat format, bool optimize,
+    const std::vector<size_t>& sectionEnds = std::vector<size_t>());
+
+// Quantization Attributes
+// Quantized positions are decoded in the vertex shader as offset + aPos * scale.
+// Both come from generic attribute values rather than arrays, so the registry
+// can set them per draw without knowing which program is bound.
+const GLuint QUANTIZATION_OFFSET_ATTRIBUTE = 6;
+const GLuint QUANTIZATION_SCALE_ATTRIBUTE = 7;
+
+// Arena Range
+// Bytes of the registry's vertex or index buffer, either owned by a mesh or free
+struct ArenaRange
+{
+    size_t offset = 0;
+    size_t size = 0;
+};
+
+// Mesh Registry
+// Geometry arena for static meshes: one vertex buffer, one index buffer and one
+// VAO per vertex format shared by every mesh. Each mesh gets a sub-range of both
+// buffers, and draws address it with an index offset plus baseVertex, so
+// switching between meshes of the same format never rebinds a VAO. Positions
+// are attribute 0, either tightly packed floats or one of the quantized formats.
+// Indices are stored as GL_UNSIGNED_SHORT whenever the mesh has few enough
+// vertices, which halves the index memory of every small mesh. Unless turned
+// off, every mesh is run through the mesh optimizer before it is uploaded.
+// A local-space bounding sphere is kept per mesh for culling.
+// Removed meshes return their byte ranges to free lists that later meshes are
+// placed in first, and their handles are reused, so streamed geometry can come
+// and go without the arena growing every time.
+class MeshRegistry
+{
+public:
+    void create(size_t vertexCapacity, size_t indexCapacity);
+    void destroy();
+
+    // Copies the mesh into the arena, growing the buffers if they are full. Triangles
+    // are only reordered within sections ending at sectionEnds, so submeshes added
+    // on those boundaries stay valid.
+    MeshHandle add(const GLfloat* vertices, size_t vertexCount, const GLuint* indices, size_t indexCount,
+        const std::vector<size_t>& sectionEnds = std::vector<size_t>());
+    MeshHandle add(const GLfloat* vertices, size_t vertexCount, const GLushort* indices, size_t indexCount);
+    MeshHandle add(const MeshData& mesh);
+    MeshHandle add(const PreparedMesh& mesh);
+
+    // Uploads every mesh of a scene file with one copy per buffer straight from the
+    // mapping; the file's meshes are already optimized and quantized. handles[i] is
+    // the handle of the scene's mesh i.
+    void addScene(const SceneFile& scene, std::vector<MeshHandle>& handles);
+
+    // Vertex cache, overdraw and vertex fetch optimization of newly added meshes
+    bool optimizeMeshes = true;
+    const MeshOptimizeReport& optimizeReport(MeshHandle mesh) const { return reports[mesh]; }
+
+    // Vertex format of newly added meshes
+    VertexFormat vertexFormat = VERTEX_FLOAT3;
+
+    // Largest position error the mesh's vertex format introduced, in mesh units
+    float quantizationError(MeshHandle mesh) const { return quantization[mesh].maxError; }
+
+    // A slice of another mesh's indices that shares its vertices (e.g. the door inside the house)
+    MeshHandle addSubmesh(MeshHandle parent, size_t firstIndex, size_t indexCount);
+
+    // Frees a mesh added with add. Submeshes own no storage, remove them along
+    // with their parent; scene meshes stay until destroy.
+    void remove(MeshHandle mesh);
+
+    const MeshRange& range(MeshHandle mesh) const { return meshes[mesh]; }
+    const BoundingSphere& bounds(MeshHandle mesh) const { return meshBounds[mesh]; }
+
+    // Handles below meshCount, some of which may have been removed
+    size_t meshCount() const { return meshes.size(); }
+    bool isLive(MeshHandle mesh) const { return mesh < live.size() && live[mesh]; }
+
+    // Bytes of the vertex and index buffers held by live meshes, and the buffers' size
+    size_t residentBytes() const;
+    size_t capacityBytes() const { return vertexByteCapacity + indexByteCapacity; }
+    GLuint vertexArray(VertexFormat format = VERTEX_FLOAT3) const { return vaos[format]; }
+
+    // Binds the float VAO and forgets which format and quantization were last set
+    void bind() const;
+    void draw(MeshHandle mesh) const;
+    void drawInstanced(MeshHandle mesh, GLsizei instanceCount) const;
+
+private:
+    MeshHandle store(const MeshRange& range, const BoundingSphere& sphere, const MeshOptimizeReport& report,
+        const QuantizationBounds& bounds, const ArenaRange& vertexRange, const ArenaRange& indexRange);
+    void allocate(size_t vertexSize, size_t vertexAlignment, size_t indexSize, size_t indexAlignment,
+        size_t& vertexOffset, size_t& indexOffset);
+    void prepareDraw(MeshHandle mesh) const;
+    void setVertexFormats() const;
+    void grow(size_t minVertexBytes, size_t minIndexBytes);
+
+    GLuint vaos[VERTEX_FORMAT_COUNT] = {};
+    GLuint vbo = 0;
+    GLuint ebo = 0;
+    size_t vertexByteCapacity = 0;
+    size_t indexByteCapacity = 0;
+    size_t vertexBytes = 0;
+    size_t indexBytes = 0;
+    std::vector<MeshRange> meshes;
+    std::vector<BoundingSphere> meshBounds;
+    std::vector<MeshOptimizeReport> reports;
+    std::vector<QuantizationBounds> quantization;
+
+    // Storage each mesh owns, empty for submeshes and scene meshes
+    std::vector<ArenaRange> vertexRanges;
+    std::vector<ArenaRange> indexRanges;
+    std::vector<uint8_t> live;
+    std::vector<MeshHandle> freeHandles;
+
+    // Sorted by offset, neighbours merged; space freed at the end shrinks the used bytes instead
+    std::vector<ArenaRange> freeVertexRanges;
+    std::vector<ArenaRange> freeIndexRanges;
+
+    // Draw state, to skip redundant VAO binds and attribute updates
+    mutable VertexFormat boundFormat = VERTEX_FORMAT_COUNT;
+    mutable MeshHandle quantizationMesh = INVALID_MESH;
+};
@@ -0,0 +1,502 @@
+#include "NavGraph.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <limits>
+
+// Marks a node that has left the open set
+static const uint32_t CLOSED = 0xFFFFFFFFu;
+
+// Requests per job in PathPlanner::findBatch
+static const size_t PATH_REQUEST_CHUNK = 16;
+
+// Navigation Graph
+uint32_t NavGraph::addNode(const glm::vec3& position)
+{
+    positions.push_back(position);
+    return static_cast<uint32_t>(positions.size() - 1);
+}
+
+void NavGraph::addEdge(uint32_t a, uint32_t b)
+{
+    if (a != b)
+    {
+        edgeList.emplace_back(a, b);
+    }
+}
+
+void NavGraph::build()
+{
+    // Count both directions of every edge, then turn the counts into offsets
+    edgeOffsets.assign(positions.size() + 1, 0);
+    for (const std::pair<uint32_t, uint32_t>& edge : edgeList)
+    {
+        ++edgeOffsets[edge.first + 1];
+        ++edgeOffsets[edge.second + 1];
+    }
+    for (size_t i = 1; i < edgeOffsets.size(); ++i)
+    {
+        edgeOffsets[i] += edgeOffsets[i - 1];
+    }
+
+    targets.resize(edgeList.size() * 2);
+    costs.resize(edgeList.size() * 2);
+    std::vector<uint32_t> next(edgeOffsets.begin(), edgeOffsets.end() - 1);
+    for (const std::pair<uint32_t, uint32_t>& edge : edgeList)
+    {
+        float cost = glm::distance(positions[edge.first], positions[edge.second]);
+
+        uint32_t forward = next[edge.first]++;
+        targets[forward] = edge.second;
+        costs[forward] = cost;
+
+        uint32_t backward = next[edge.second]++;
+        targets[backward] = edge.first;
+        costs[backward] = cost;
+    }
+}
+
+void NavGraph::clear()
+{
+    positions.clear();
+    edgeOffsets.clear();
+    targets.clear();
+    costs.clear();
+    edgeList.clear();
+}
+
+uint32_t NavGraph::nearestNode(const glm::vec3& position) const
+{
+    uint32_t nearest = NO_NAV_NODE;
+    float nearestDistance = std::numeric_limits<float>::max();
+    for (uint32_t node = 0; node < positions.size(); ++node)
+    {
+        if (edgeBegin(node) == edgeEnd(node))
+        {
+            continue;
+        }
+        glm::vec3 offset = positions[node] - position;
+        float distance = glm::dot(offset, offset);
+        if (distance < nearestDistance)
+        {
+            nearestDistance = distance;
+            nearest = node;
+        }
+    }
+    return nearest;
+}
+
+// Grid Graph
+void buildGridGraph(NavGraph& graph, const glm::vec3& origin, float spacing, size_t columns, size_t rows,
+    const std::vector<uint8_t>* blocked)
+{
+    graph.clear();
+    for (size_t row = 0; row < rows; ++row)
+    {
+        for (size_t column = 0; column < columns; ++column)
+        {
+            graph.addNode(origin + glm::vec3(column * spacing, 0.0f, row * spacing));
+        }
+    }
+
+    auto open = [&](size_t column, size_t row)
+    {
+        return !blocked || !(*blocked)[row * columns + column];
+    };
+    auto node = [&](size_t column, size_t row)
+    {
+        return static_cast<uint32_t>(row * columns + column);
+    };
+
+    // Each cell links to its neighbours to the right and in the next row, which covers every pair once
+    for (size_t row = 0; row < rows; ++row)
+    {
+        for (size_t column = 0; column < columns; ++column)
+        {
+            if (!open(column, row))
+            {
+                continue;
+            }
+            bool right = column + 1 < columns && open(column + 1, row);
+            bool below = row + 1 < rows && open(column, row + 1);
+            bool left = column > 0 && open(column - 1, row);
+
+            if (right)
+            {
+                graph.addEdge(node(column, row), node(column + 1, row));
+            }
+            if (below)
+            {
+                graph.addEdge(node(column, row), node(column, row + 1));
+            }
+            if (right && below && open(column + 1, row + 1))
+            {
+                graph.addEdge(node(column, row), node(column + 1, row + 1));
+            }
+            if (left && below && open(column - 1, row + 1))
+            {
+                graph.addEdge(node(column, row), node(column - 1, row + 1));
+            }
+        }
+    }
+    graph.build();
+}
+
+void appendPathWaypoints(const NavGraph& graph, const std::vector<uint32_t>& path, std::vector<glm::vec3>& waypoints)
+{
+    for (size_t i = 0; i < path.size(); ++i)
+    {
+        const glm::vec3& position = graph.position(path[i]);
+        if (i > 0 && i + 1 < path.size())
+        {
+            glm::vec3 in = position - graph.position(path[i - 1]);
+            glm::vec3 out = graph.position(path[i + 1]) - position;
+            float turn = glm::length(glm::cross(in, out));
+            if (glm::dot(in, out) > 0.0f && turn <= 1e-4f * glm::length(in) * glm::length(out))
+            {
+                continue;
+            }
+        }
+        waypoints.push_back(position);
+    }
+}
+
+// A* Search
+PathSolver::PathSolver(const NavGraph& graph)
+    : graph(graph)
+    , visitedIn(graph.nodeCount(), 0)
+    , g(graph.nodeCount())
+    , f(graph.nodeCount())
+    , parent(graph.nodeCount())
+    , heapSlot(graph.nodeCount())
+    , heap(graph.nodeCount())
+{
+}
+
+// Ties go to the node further from the start, which is usually closer to the goal
+static bool before(const std::vector<float>& f, const std::vector<float>& g, uint32_t a, uint32_t b)
+{
+    return f[a] < f[b] || (f[a] == f[b] && g[a] > g[b]);
+}
+
+void PathSolver::push(uint32_t node)
+{
+    heap[heapSize] = node;
+    heapSlot[node] = static_cast<uint32_t>(heapSize);
+    moveUp(static_cast<uint32_t>(heapSize++));
+}
+
+void PathSolver::moveUp(uint32_t slot)
+{
+    uint32_t node = heap[slot];
+    while (slot > 0)
+    {
+        uint32_t up = (slot - 1) / 2;
+        if (!before(f, g, node, heap[up]))
+        {
+            break;
+        }
+        heap[slot] = heap[up];
+        heapSlot[heap[slot]] = slot;
+        slot = up;
+    }
+    heap[slot] = node;
+    heapSlot[node] = slot;
+}
+
+uint32_t PathSolver::popMin()
+{
+    uint32_t top = heap[0];
+    heapSlot[top] = CLOSED;
+    if (--heapSize == 0)
+    {
+        return top;
+    }
+
+    // Sink the last node from the root
+    uint32_t node = heap[heapSize];
+    size_t slot = 0;
+    for (;;)
+    {
+        size_t child = slot * 2 + 1;
+        if (child >= heapSize)
+        {
+            break;
+        }
+        if (child + 1 < heapSize && before(f, g, heap[child + 1], heap[child]))
+        {
+            ++child;
+        }
+        if (!before(f, g, heap[child], node))
+        {
+            break;
+        }
+        heap[slot] = heap[child];
+        heapSlot[heap[slot]] = static_cast<uint32_t>(slot);
+        slot = child;
+    }
+    heap[slot] = node;
+    heapSlot[node] = static_cast<uint32_t>(slot);
+    return top;
+}
+
+bool PathSolver::find(uint32_t start, uint32_t goal, std::vector<uint32_t>& path)
+{
+    path.clear();
+    lastCost = 0.0f;
+    lastExpanded = 0;
+    if (start >= graph.nodeCount() || goal >= graph.nodeCount())
+    {
+        return false;
+    }
+
+    // A new search number leaves every node unvisited, clear them only when it wraps
+    if (++search == 0)
+    {
+        std::fill(visitedIn.begin(), visitedIn.end(), 0);
+        search = 1;
+    }
+
+    const glm::vec3 target = graph.position(goal);
+    heapSize = 0;
+    visitedIn[start] = search;
+    g[start] = 0.0f;
+    f[start] = glm::distance(graph.position(start), target);
+    parent[start] = NO_NAV_NODE;
+    push(start);
+
+    while (heapSize > 0)
+    {
+        uint32_t node = popMin();
+        ++lastExpanded;
+        if (node == goal)
+        {
+            for (uint32_t step = goal; step != NO_NAV_NODE; step = parent[step])
+            {
+                path.push_back(step);
+            }
+            std::reverse(path.begin(), path.end());
+            lastCost = g[goal];
+            return true;
+        }
+
+        // Edges cost their length, so the heuristic is consistent and closed nodes stay closed
+        for (uint32_t edge = graph.edgeBegin(node); edge < graph.edgeEnd(node); ++edge)
+        {
+            uint32_t next = graph.edgeTarget(edge);
+            float cost = g[node] + graph.edgeCost(edge);
+            if (visitedIn[next] != search)
+            {
+                visitedIn[next] = search;
+                g[next] = cost;
+                f[next] = cost + glm::distance(graph.position(next), target);
+                parent[next] = node;
+                push(next);
+            }
+            else if (heapSlot[next] != CLOSED && cost < g[next])
+            {
+                f[next] -= g[next] - cost;
+                g[next] = cost;
+                parent[next] = node;
+                moveUp(heapSlot[next]);
+            }
+        }
+    }
+    return false;
+}
+
+// Path Cache
+PathCache::PathCache(size_t capacity)
+    : entries(std::max<size_t>(capacity, 1))
+{
+    lookup.reserve(entries.size());
+}
+
+void PathCache::unlink(uint32_t entry)
+{
+    Entry& e = entries[entry];
+    if (e.previous != NO_NAV_NODE)
+    {
+        entries[e.previous].next = e.next;
+    }
+    else
+    {
+        head = e.next;
+    }
+    if (e.next != NO_NAV_NODE)
+    {
+        entries[e.next].previous = e.previous;
+    }
+    else
+    {
+        tail = e.previous;
+    }
+    e.previous = NO_NAV_NODE;
+    e.next = NO_NAV_NODE;
+}
+
+void PathCache::pushFront(uint32_t entry)
+{
+    Entry& e = entries[entry];
+    e.previous = NO_NAV_NODE;
+    e.next = head;
+    if (head != NO_NAV_NODE)
+    {
+        entries[head].previous = entry;
+    }
+    head = entry;
+    if (tail == NO_NAV_NODE)
+    {
+        tail = entry;
+    }
+}
+
+bool PathCache::get(uint32_t start, uint32_t goal, std::vector<uint32_t>& path)
+{
+    auto found = lookup.find(key(start, goal));
+    if (found == lookup.end())
+    {
+        return false;
+    }
+    uint32_t entry = found->second;
+    if (entry != head)
+    {
+        unlink(entry);
+        pushFront(entry);
+    }
+    path = entries[entry].path;
+    return true;
+}
+
+void PathCache::put(uint32_t start, uint32_t goal, const std::vector<uint32_t>& path)
+{
+    uint64_t k = key(start, goal);
+    auto found = lookup.find(k);
+    uint32_t entry;
+    if (found != lookup.end())
+    {
+        entry = found->second;
+        unlink(entry);
+    }
+    else
+    {
+        if (used < entries.size())
+        {
+            entry = used++;
+        }
+        else
+        {
+            entry = tail;
+            unlink(entry);
+            lookup.erase(entries[entry].key);
+        }
+        entries[entry].key = k;
+        lookup.emplace(k, entry);
+    }
+
+    // assign keeps the vector's storage when it is large enough
+    entries[entry].path.assign(path.begin(), path.end());
+    pushFront(entry);
+}
+
+void PathCache::clear()
+{
+    lookup.clear();
+    for (Entry& entry : entries)
+    {
+        entry.previous = NO_NAV_NODE;
+        entry.next = NO_NAV_NODE;
+        entry.path.clear();
+    }
+    head = NO_NAV_NODE;
+    tail = NO_NAV_NODE;
+    used = 0;
+}
+
+// Path Planner
+PathPlanner::PathPlanner(const NavGraph& graph, size_t cacheCapacity)
+    : graph(graph)
+    , cache(cacheCapacity)
+{
+}
+
+std::unique_ptr<PathSolver> PathPlanner::acquireSolver()
+{
+    {
+        std::lock_guard<std::mutex> lock(solverMutex);
+        if (!solvers.empty())
+        {
+            std::unique_ptr<PathSolver> solver = std::move(solvers.back());
+            solvers.pop_back();
+            return solver;
+        }
+    }
+    return std::unique_ptr<PathSolver>(new PathSolver(graph));
+}
+
+void PathPlanner::releaseSolver(std::unique_ptr<PathSolver> solver)
+{
+    std::lock_guard<std::mutex> lock(solverMutex);
+    solvers.push_back(std::move(solver));
+}
+
+bool PathPlanner::find(uint32_t start, uint32_t goal, std::vector<uint32_t>& path)
+{
+    bool cached;
+    return find(start, goal, path, cached);
+}
+
+bool PathPlanner::find(uint32_t start, uint32_t goal, std::vector<uint32_t>& path, bool& cached)
+{
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        ++totals.requests;
+        cached = cache.get(start, goal, path);
+        if (cached)
+        {
+            ++totals.cacheHits;
+            return true;
+        }
+    }
+
+    // Two threads missing on the same pair both search, the second put just refreshes the entry
+    std::unique_ptr<PathSolver> solver = acquireSolver();
+    bool found = solver->find(start, goal, path);
+    size_t expanded = solver->expanded();
+    releaseSolver(std::move(solver));
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    totals.expanded += expanded;
+    if (found)
+    {
+        cache.put(start, goal, path);
+    }
+    return found;
+}
+
+void PathPlanner::findBatch(const std::vector<PathRequest>& requests, std::vector<PathResult>& results, JobSystem* jobs)
+{
+    results.resize(requests.size());
+    auto solve = [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            PathResult& result = results[i];
+            result.found = find(requests[i].start, requests[i].goal, result.path, result.cached);
+        }
+    };
+
+    if (jobs)
+    {
+        jobs->parallelFor(requests.size(), PATH_REQUEST_CHUNK, solve);
+    }
+    else
+    {
+        solve(0, requests.size());
+    }
+}
+
+PathPlannerStats PathPlanner::stats() const
+{
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    return totals;
+}
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class JobSystem;
+
+const uint32_t NO_NAV_NODE = 0xFFFFFFFFu;
+
+// Navigation Graph
+// Waypoints connected by undirected edges that cost their length. Edges are
+// collected with addEdge and packed by build into compressed rows: the edges
+// of node n are edgeOffsets[n] .. edgeOffsets[n + 1] - 1, so a search walks
+// them as one contiguous range.
+class NavGraph
+{
+public:
+    uint32_t addNode(const glm::vec3& position);
+    void addEdge(uint32_t a, uint32_t b);
+
+    // Packs every edge added so far, must be called before searching
+    void build();
+    void clear();
+
+    size_t nodeCount() const { return positions.size(); }
+    size_t edgeCount() const { return targets.size(); }
+    const glm::vec3& position(uint32_t node) const { return positions[node]; }
+
+    uint32_t edgeBegin(uint32_t node) const { return edgeOffsets[node]; }
+    uint32_t edgeEnd(uint32_t node) const { return edgeOffsets[node + 1]; }
+    uint32_t edgeTarget(uint32_t edge) const { return targets[edge]; }
+    float edgeCost(uint32_t edge) const { return costs[edge]; }
+
+    // Closest node that has at least one edge, NO_NAV_NODE if there is none. Linear scan.
+    uint32_t nearestNode(const glm::vec3& position) const;
+
+private:
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> edgeOffsets;
+    std::vector<uint32_t> targets;
+    std::vector<float> costs;
+    std::vector<std::pair<uint32_t, uint32_t>> edgeList;
+};
+
+// Grid Graph
+// Replaces the graph with columns x rows nodes spaced along X and Z from
+// origin, node index row * columns + column. Neighbours are connected in eight
+// directions; diagonals are only added when both cells they pass are open, so
+// paths don't cut corners.
+// Blocked cells, if given (one flag per node), get a node but no edges.
+void buildGridGraph(NavGraph& graph, const glm::vec3& origin, float spacing, size_t columns, size_t rows,
+    const std::vector<uint8_t>* blocked = nullptr);
+
+// Appends the positions along a path, leaving out nodes that lie on the straight
+// line between their neighbours, which is most of a path on a grid
+void appendPathWaypoints(const NavGraph& graph, const std::vector<uint32_t>& path, std::vector<glm::vec3>& waypoints);
+
+// A* Search
+// Finds the cheapest path with a straight-line distance heuristic. Every array
+// is sized to the graph once, so searches don't allocate; per-node state is
+// tagged with a search number instead of being cleared. The open set is a
+// binary min-heap of node ids with each node's heap slot tracked, so a cheaper
+// route to an open node moves it up in place. Not thread safe, use one solver
+// per thread.
+class PathSolver
+{
+public:
+    explicit PathSolver(const NavGraph& graph);
+
+    // Writes the nodes from start to goal into path, returns false if goal is unreachable
+    bool find(uint32_t start, uint32_t goal, std::vector<uint32_t>& path);
+
+    // Of the last search
+    float cost() const { return lastCost; }
+    size_t expanded() const { return lastExpanded; }
+
+private:
+    void push(uint32_t node);
+    void moveUp(uint32_t slot);
+    uint32_t popMin();
+
+    const NavGraph& graph;
+    uint32_t search = 0;
+    std::vector<uint32_t> visitedIn;
+    std::vector<float> g;
+    std::vector<float> f;
+    std::vector<uint32_t> parent;
+    std::vector<uint32_t> heapSlot; // CLOSED once expanded
+    std::vector<uint32_t> heap;
+    size_t heapSize = 0;
+
+    float lastCost = 0.0f;
+    size_t lastExpanded = 0;
+};
+
+// Path Cache
+// Least recently used solved paths keyed by (start, goal). Entries live in a
+// fixed array linked into a recency list by index, and an evicted entry's node
+// vector is reused for the path that replaces it.
+class PathCache
+{
+public:
+    explicit PathCache(size_t capacity);
+
+    // Copies the cached path into path and marks it most recently used
+    bool get(uint32_t start, uint32_t goal, std::vector<uint32_t>& path);
+    void put(uint32_t start, uint32_t goal, const std::vector<uint32_t>& path);
+    void clear();
+
+    size_t size() const { return lookup.size(); }
+    size_t capacity() const { return entries.size(); }
+
+private:
+    static uint64_t key(uint32_t start, uint32_t goal) { return (uint64_t(start) << 32) | goal; }
+    void unlink(uint32_t entry);
+    void pushFront(uint32_t entry);
+
+    struct Entry
+    {
+        uint64_t key = 0;
+        uint32_t previous = NO_NAV_NODE;
+        uint32_t next = NO_NAV_NODE;
+        std::vector<uint32_t> path;
+    };
+
+    std::vector<Entry> entries;
+    std::unordered_map<uint64_t, uint32_t> lookup;
+    uint32_t head = NO_NAV_NODE; // Most recently used
+    uint32_t tail = NO_NAV_NODE;
+    uint32_t used = 0;
+};
+
+struct PathRequest
+{
+    uint32_t start;
+    uint32_t goal;
+};
+
+struct PathResult
+{
+    std::vector<uint32_t> path;
+    bool found = false;
+    bool cached = false;
+};
+
+struct PathPlannerStats
+{
+    size_t requests = 0;
+    size_t cacheHits = 0;
+    size_t expanded = 0;
+};
+
+// Path Planner
+// Answers path requests from the cache and solves the misses with A*. Batches
+// are split over the job system; each job borrows a solver from a pool that
+// grows to the number of threads that search at once. Failed searches are not
+// cached. Thread safe.
+class PathPlanner
+{
+public:
+    PathPlanner(const NavGraph& graph, size_t cacheCapacity);
+
+    bool find(uint32_t start, uint32_t goal, std::vector<uint32_t>& path);
+
+    // Solves requests[i] into results[i], in parallel when jobs is given
+    void findBatch(const std::vector<PathRequest>& requests, std::vector<PathResult>& results, JobSystem* jobs = nullptr);
+
+    PathPlannerStats stats() const;
+
+private:
+    bool find(uint32_t start, uint32_t goal, std::vector<uint32_t>& path, bool& cached);
+    std::unique_ptr<PathSolver> acquireSolver();
+    void releaseSolver(std::unique_ptr<PathSolver> solver);
+
+    const NavGraph& graph;
+
+    mutable std::mutex cacheMutex;
+    PathCache cache;
+    PathPlannerStats totals;
+
+    std::mutex solverMutex;
+    std::vector<std::unique_ptr<PathSolver>> solvers;
+};
@@ -0,0 +1,310 @@
+#include "PointTable.h"
+#include "JobSystem.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+// Text per parse job, large enough that splitting costs nothing next to parsing
+static const size_t MIN_CHUNK_BYTES = 1 << 20;
+
+static const size_t NO_ERROR = ~size_t(0);
+
+void PointTable::clear()
+{
+    columnCount = 0;
+    rowCount = 0;
+    values.clear();
+}
+
+// Point Parsing
+struct ParsedChunk
+{
+    const char* begin;
+    const char* end;
+    size_t rows = 0; // Lines with anything but blanks on them
+    size_t firstRow = 0;
+    const char* error = nullptr;
+};
+
+static bool isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Values on the first line that has any, 0 for text without values or if the line doesn't parse
+static size_t countColumns(const char* p, const char* end)
+{
+    size_t columns = 0;
+    while (p < end)
+    {
+        while (p < end && isBlank(*p))
+        {
+            ++p;
+        }
+        if (p == end || *p == '\n')
+        {
+            if (columns > 0)
+            {
+                break;
+            }
+            if (p < end)
+            {
+                ++p;
+            }
+            continue;
+        }
+        float value;
+        std::from_chars_result result = std::from_chars(p, end, value);
+        if (result.ec != std::errc())
+        {
+            return 0;
+        }
+        p = result.ptr;
+        ++columns;
+    }
+    return columns;
+}
+
+// Counting only looks for the line ends and the first character of each line
+static void countRows(ParsedChunk& chunk)
+{
+    const char* p = chunk.begin;
+    const char* end = chunk.end;
+    while (p < end)
+    {
+        while (p < end && isBlank(*p))
+        {
+            ++p;
+        }
+        if (p == end)
+        {
+            break;
+        }
+        chunk.rows += *p != '\n' ? 1 : 0;
+        const char* newline = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        p = newline ? newline + 1 : end;
+    }
+}
+
+// Writes each value straight into its column, row firstRow onwards. A line
+// counts as a row here exactly when countRows counted it, so the rows fit.
+static void parseChunk(ParsedChunk& chunk, size_t columns, float* values, size_t rowCount)
+{
+    const char* p = chunk.begin;
+    const char* end = chunk.end;
+    float* row = values + chunk.firstRow;
+    while (p < end)
+    {
+        const char* line = p;
+        size_t found = 0;
+        for (;;)
+        {
+            while (p < end && isBlank(*p))
+            {
+                ++p;
+            }
+            if (p == end || *p == '\n')
+            {
+                break;
+            }
+            float value;
+            std::from_chars_result result = std::from_chars(p, end, value);
+            if (result.ec != std::errc() || found == columns || (result.ptr < end && !isBlank(*result.ptr) && *result.ptr != '\n'))
+            {
+                chunk.error = line;
+                return;
+            }
+            row[found * rowCount] = value;
+            p = result.ptr;
+            ++found;
+        }
+        if (found != 0 && found != columns)
+        {
+            chunk.error = line;
+            return;
+        }
+        row += found != 0 ? 1 : 0;
+        p += p < end ? 1 : 0;
+    }
+}
+
+bool parsePointText(const char* text, size_t size, PointTable& table, JobSystem* jobs, const std::string& name)
+{
+    table.clear();
+    const char* end = text + size;
+    size_t columns = countColumns(text, end);
+    if (columns == 0)
+    {
+        std::cerr << name << ": no values on the first line" << std::endl;
+        return false;
+    }
+
+    // Cut at the line end after each even split, so a row is never shared
+    size_t chunkCount = jobs ? jobs->chunkCount(size, MIN_CHUNK_BYTES) : 1;
+    std::vector<ParsedChunk> chunks(chunkCount);
+    const char* begin = text;
+    for (size_t i = 0; i < chunkCount; ++i)
+    {
+        const char* cut = i + 1 == chunkCount ? end : std::max(begin, text + size * (i + 1) / chunkCount);
+        const char* newline = cut < end ? static_cast<const char*>(std::memchr(cut, '\n', end - cut)) : nullptr;
+        cut = newline ? newline + 1 : end;
+        chunks[i].begin = begin;
+        chunks[i].end = cut;
+        begin = cut;
+    }
+
+    auto runChunks = [jobs, chunkCount](const auto& body)
+    {
+        if (jobs)
+        {
+            jobs->parallelForChunks(chunkCount, chunkCount, body);
+        }
+        else
+        {
+            body(0, 0, chunkCount);
+        }
+    };
+
+    // Row counts first, so every chunk knows where its rows start in the columns
+    runChunks([&chunks](size_t, size_t first, size_t last)
+    {
+        for (size_t i = first; i < last; ++i)
+        {
+            countRows(chunks[i]);
+        }
+    });
+    size_t rows = 0;
+    for (ParsedChunk& chunk : chunks)
+    {
+        chunk.firstRow = rows;
+        rows += chunk.rows;
+    }
+
+    table.columnCount = columns;
+    table.rowCount = rows;
+    table.values.resize(columns * rows);
+    runChunks([&chunks, &table, columns, rows](size_t, size_t first, size_t last)
+    {
+        for (size_t i = first; i < last; ++i)
+        {
+            parseChunk(chunks[i], columns, table.values.data(), rows);
+        }
+    });
+
+    for (const ParsedChunk& chunk : chunks)
+    {
+        if (chunk.error)
+        {
+            size_t line = 1 + std::count(text, chunk.error, '\n');
+            std::cerr << name << ":" << line << ": expected " << columns << " numbers" << std::endl;
+            table.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool readPointFile(const std::string& path, PointTable& table, JobSystem* jobs)
+{
+    MappedFile file;
+    if (!file.open(path))
+    {
+        return false;
+    }
+    return parsePointText(reinterpret_cast<const char*>(file.data()), file.size(), table, jobs, path);
+}
+
+// Point Cache
+struct PointCacheHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t columnCount;
+    uint64_t rowCount;
+    uint64_t sourceSize;
+    int64_t sourceTime;
+};
+
+std::string pointCachePath(const std::string& path)
+{
+    return path + ".cols";
+}
+
+bool writePointCache(const std::string& cachePath, const PointTable& table, uint64_t sourceSize, int64_t sourceTime)
+{
+    PointCacheHeader header = {};
+    std::memcpy(header.magic, POINT_CACHE_MAGIC, sizeof(header.magic));
+    header.version = POINT_CACHE_VERSION;
+    header.columnCount = table.columnCount;
+    header.rowCount = table.rowCount;
+    header.sourceSize = sourceSize;
+    header.sourceTime = sourceTime;
+
+    std::ofstream file(cachePath, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(table.values.data()), table.values.size() * sizeof(float));
+    if (!file)
+    {
+        std::cerr << "Failed to write point cache: " << cachePath << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool readPointCache(const std::string& cachePath, PointTable& table, uint64_t sourceSize, int64_t sourceTime)
+{
+    std::ifstream file(cachePath, std::ios::binary);
+    PointCacheHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))
+        || std::memcmp(header.magic, POINT_CACHE_MAGIC, sizeof(header.magic)) != 0
+        || header.version != POINT_CACHE_VERSION || header.sourceSize != sourceSize || header.sourceTime != sourceTime)
+    {
+        return false;
+    }
+
+    table.columnCount = static_cast<size_t>(header.columnCount);
+    table.rowCount = static_cast<size_t>(header.rowCount);
+    table.values.resize(table.columnCount * table.rowCount);
+    if (!file.read(reinterpret_cast<char*>(table.values.data()), table.values.size() * sizeof(float)))
+    {
+        table.clear();
+        return false;
+    }
+    return true;
+}
+
+bool loadPointFile(const std::string& path, PointTable& table, JobSystem* jobs, bool* fromCache)
+{
+    std::error_code error;
+    uint64_t sourceSize = std::filesystem::file_size(path, error);
+    int64_t sourceTime = error ? 0 : static_cast<int64_t>(std::filesystem::last_write_time(path, error).time_since_epoch().count());
+    if (error)
+    {
+        std::cerr << "Failed to open file: " << path << std::endl;
+        return false;
+    }
+
+    std::string cachePath = pointCachePath(path);
+    bool cached = readPointCache(cachePath, table, sourceSize, sourceTime);
+    if (fromCache)
+    {
+        *fromCache = cached;
+    }
+    if (cached)
+    {
+        return true;
+    }
+
+    if (!readPointFile(path, table, jobs))
+    {
+        return false;
+    }
+
+    // A cache that can't be written only costs the next load a parse
+    writePointCache(cachePath, table, sourceSize, sourceTime);
+    return true;
+}
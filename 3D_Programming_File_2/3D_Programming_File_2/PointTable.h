@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class JobSystem;
+
+const char POINT_CACHE_MAGIC[4] = { 'P', 'T', 'S', 'C' };
+const uint32_t POINT_CACHE_VERSION = 1;
+
+// Point Table
+// Rows of floats from a whitespace separated text file such as
+// interpolated_points.txt, stored by column: column c is values[c * rowCount]
+// .. values[(c + 1) * rowCount - 1].
+struct PointTable
+{
+    size_t columnCount = 0;
+    size_t rowCount = 0;
+    std::vector<float> values;
+
+    const float* column(size_t c) const { return values.data() + c * rowCount; }
+    float* column(size_t c) { return values.data() + c * rowCount; }
+    void clear();
+};
+
+// Point Parsing
+// One row per line, blank lines skipped, and every row needs as many values as
+// the first. The text is cut into chunks at line ends. A first pass counts the
+// rows of each chunk with memchr, which gives every chunk its first row, and a
+// second parses each chunk with std::from_chars straight into the columns.
+// Both passes run in parallel when jobs is given. Returns false and prints the
+// line of the first error.
+bool parsePointText(const char* text, size_t size, PointTable& table, JobSystem* jobs = nullptr,
+    const std::string& name = "points");
+
+// Maps the file and parses it in place, without copying the text
+bool readPointFile(const std::string& path, PointTable& table, JobSystem* jobs = nullptr);
+
+// Point Cache
+// Binary sidecar holding the columns as they are in memory, tagged with the
+// size and modification time of the text it was parsed from. loadPointFile
+// reads the sidecar while both still match and otherwise parses the text and
+// rewrites it.
+std::string pointCachePath(const std::string& path);
+bool writePointCache(const std::string& cachePath, const PointTable& table, uint64_t sourceSize, int64_t sourceTime);
+
+// Returns false without printing if the cache is missing or stale
+bool readPointCache(const std::string& cachePath, PointTable& table, uint64_t sourceSize, int64_t sourceTime);
+
+bool loadPointFile(const std::string& path, PointTable& table, JobSystem* jobs = nullptr, bool* fromCache = nullptr);
@@ -0,0 +1,170 @@
+#include "Profiler.h"
+
+#ifdef ENABLE_PROFILER
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+
+// Ring Buffer
+// Writers claim a slot with one fetch_add and publish it by storing the slot's
+// sequence number, so recording never takes a lock. When the buffer is full the
+// oldest events are overwritten.
+static const uint64_t RING_CAPACITY = 1u << 18;
+static const uint64_t RING_MASK = RING_CAPACITY - 1;
+
+// GPU sections are shown as their own row in the trace
+static const uint32_t GPU_THREAD_ID = 1000;
+
+struct ProfileSlot
+{
+    std::atomic<uint64_t> sequence;
+    ProfileEvent event;
+};
+
+static ProfileSlot* ring()
+{
+    static ProfileSlot* slots = new ProfileSlot[RING_CAPACITY]();
+    return slots;
+}
+
+static std::atomic<uint64_t> writeIndex(0);
+static std::atomic<uint32_t> nextThreadId(0);
+
+static std::mutex threadNameMutex;
+static std::map<uint32_t, std::string> threadNames;
+
+uint64_t profilerNowNs()
+{
+    static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+uint32_t profilerThreadId()
+{
+    static thread_local uint32_t id = nextThreadId.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
+
+void profilerSetThreadName(const char* name)
+{
+    std::lock_guard<std::mutex> lock(threadNameMutex);
+    threadNames[profilerThreadId()] = name;
+}
+
+void profilerRecord(const char* name, uint64_t startNs, uint64_t durationNs, ProfileEventType type)
+{
+    uint64_t index = writeIndex.fetch_add(1, std::memory_order_relaxed);
+    ProfileSlot& slot = ring()[index & RING_MASK];
+
+    // Mark the slot as being written so a concurrent dump skips it
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.event.name = name;
+    slot.event.startNs = startNs;
+    slot.event.durationNs = durationNs;
+    slot.event.value = 0.0;
+    slot.event.threadId = type == PROFILE_GPU ? GPU_THREAD_ID : profilerThreadId();
+    slot.event.type = type;
+
+    slot.sequence.store(index + 1, std::memory_order_release);
+}
+
+void profilerCounter(const char* name, double value)
+{
+    uint64_t index = writeIndex.fetch_add(1, std::memory_order_relaxed);
+    ProfileSlot& slot = ring()[index & RING_MASK];
+
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.event.name = name;
+    slot.event.startNs = profilerNowNs();
+    slot.event.durationNs = 0;
+    slot.event.value = value;
+    slot.event.threadId = profilerThreadId();
+    slot.event.type = PROFILE_COUNTER;
+
+    slot.sequence.store(index + 1, std::memory_order_release);
+}
+
+static void writeJsonString(std::ostream& out, const char* text)
+{
+    out << '"';
+    for (const char* c = text; *c; ++c)
+    {
+        if (*c == '"' || *c == '\\')
+        {
+            out << '\\';
+        }
+        out << *c;
+    }
+    out << '"';
+}
+
+bool profilerWriteChromeTrace(const std::string& path)
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        std::cerr << "Failed to write profile: " << path << std::endl;
+        return false;
+    }
+
+    uint64_t end = writeIndex.load(std::memory_order_acquire);
+    uint64_t begin = end > RING_CAPACITY ? end - RING_CAPACITY : 0;
+
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << GPU_THREAD_ID << ",\"args\":{\"name\":\"GPU\"}}";
+    {
+        std::lock_guard<std::mutex> lock(threadNameMutex);
+        for (const auto& thread : threadNames)
+        {
+            file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread.first << ",\"args\":{\"name\":";
+            writeJsonString(file, thread.second.c_str());
+            file << "}}";
+        }
+    }
+
+    size_t written = 0;
+    for (uint64_t index = begin; index < end; ++index)
+    {
+        const ProfileSlot& slot = ring()[index & RING_MASK];
+        if (slot.sequence.load(std::memory_order_acquire) != index + 1)
+        {
+            continue;
+        }
+        ProfileEvent event = slot.event;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != index + 1)
+        {
+            continue;
+        }
+
+        file << ",\n{\"name\":";
+        writeJsonString(file, event.name);
+        if (event.type == PROFILE_COUNTER)
+        {
+            file << ",\"ph\":\"C\",\"ts\":" << event.startNs / 1000.0
+                 << ",\"pid\":1,\"tid\":" << event.threadId
+                 << ",\"args\":{\"value\":" << event.value << "}}";
+        }
+        else
+        {
+            file << ",\"ph\":\"X\",\"ts\":" << event.startNs / 1000.0
+                 << ",\"dur\":" << event.durationNs / 1000.0
+                 << ",\"pid\":1,\"tid\":" << event.threadId << "}";
+        }
+        ++written;
+    }
+    file << "\n]}\n";
+
+    std::cout << "Wrote " << written << " profile events to " << path << std::endl;
+    return true;
+}
+
+#endif
@@ -0,0 +1,71 @@
+#pragma once
+
+// Frame Profiler
+// CPU scopes, counters and GPU sections are pushed into a fixed-size lock-free
+// ring buffer and can be written out as a Chrome trace (chrome://tracing or
+// https://ui.perfetto.dev). Everything here compiles to nothing unless
+// ENABLE_PROFILER is defined.
+
+#include <cstdint>
+#include <string>
+
+#ifdef ENABLE_PROFILER
+
+enum ProfileEventType : uint32_t
+{
+    PROFILE_CPU,
+    PROFILE_GPU,
+    PROFILE_COUNTER
+};
+
+// Profile Event
+// For counters, durationNs is unused and value holds the sample
+struct ProfileEvent
+{
+    const char* name;
+    uint64_t startNs;
+    uint64_t durationNs;
+    double value;
+    uint32_t threadId;
+    ProfileEventType type;
+};
+
+// Nanoseconds since the profiler was first used
+uint64_t profilerNowNs();
+
+// Small, stable id for the calling thread
+uint32_t profilerThreadId();
+
+// Name shown for a thread in the trace, e.g. "Main"
+void profilerSetThreadName(const char* name);
+
+// Names must be string literals or otherwise outlive the profiler
+void profilerRecord(const char* name, uint64_t startNs, uint64_t durationNs, ProfileEventType type);
+void profilerCounter(const char* name, double value);
+
+// Writes every event still in the ring buffer, returns false if the file could not be written
+bool profilerWriteChromeTrace(const std::string& path);
+
+// Profile Scope
+struct ProfileScope
+{
+    const char* name;
+    uint64_t startNs;
+
+    explicit ProfileScope(const char* name) : name(name), startNs(profilerNowNs()) {}
+    ~ProfileScope() { profilerRecord(name, startNs, profilerNowNs() - startNs, PROFILE_CPU); }
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_COUNTER(name, value) profilerCounter(name, static_cast<double>(value))
+#define PROFILE_THREAD_NAME(name) profilerSetThreadName(name)
+
+#else
+
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_COUNTER(name, value) ((void)0)
+#define PROFILE_THREAD_NAME(name) ((void)0)
+
+#endif
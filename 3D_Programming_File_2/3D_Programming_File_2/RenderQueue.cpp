@@ -0,0 +1,198 @@
+#include "RenderQueue.h"
+#include "TransformBatch.h"
+#include <algorithm>
+#include <cstring>
+
+static const uint32_t DEPTH_BITS = 22;
+static const uint32_t DEPTH_MAX = (1u << DEPTH_BITS) - 1;
+
+uint64_t makeSortKey(RenderPass pass, uint32_t program, uint32_t vertexFormat, uint32_t mesh, uint16_t material, float depth)
+{
+    depth = std::min(std::max(depth, 0.0f), 1.0f);
+
+    // Transparent draws blend over what is behind them, so they go back to front
+    if (pass == RENDER_PASS_TRANSPARENT)
+    {
+        depth = 1.0f - depth;
+    }
+    uint32_t band = std::min(static_cast<uint32_t>(depth * RENDER_DEPTH_BANDS), static_cast<uint32_t>(RENDER_DEPTH_BANDS - 1));
+    uint32_t fineDepth = static_cast<uint32_t>(depth * DEPTH_MAX);
+
+    return (uint64_t(pass & 0x3u) << 62)
+        | (uint64_t(program & 0x7u) << 59)
+        | (uint64_t(band) << 56)
+        | (uint64_t(vertexFormat & 0x3u) << 54)
+        | (uint64_t(mesh & 0xFFFFu) << 38)
+        | (uint64_t(material) << 22)
+        | uint64_t(fineDepth);
+}
+
+StateChangeCounts countStateChanges(const uint64_t* keys, size_t count)
+{
+    StateChangeCounts changes;
+    for (size_t i = 0; i < count; ++i)
+    {
+        uint64_t key = keys[i];
+        bool first = i == 0;
+        uint64_t previous = first ? 0 : keys[i - 1];
+        bool programChanged = first || sortKeyProgram(key) != sortKeyProgram(previous);
+
+        changes.program += programChanged ? 1 : 0;
+        changes.vertexFormat += first || sortKeyVertexFormat(key) != sortKeyVertexFormat(previous) ? 1 : 0;
+        changes.mesh += first || sortKeyMesh(key) != sortKeyMesh(previous) ? 1 : 0;
+
+        // Uniforms belong to the program, so a new program needs its material set again.
+        // Overflow draws set their color every time.
+        uint16_t material = sortKeyMaterial(key);
+        if (material != RENDER_NO_MATERIAL && (programChanged || material == RENDER_OVERFLOW_MATERIAL || material != sortKeyMaterial(previous)))
+        {
+            ++changes.material;
+        }
+    }
+    return changes;
+}
+
+void radixSortKeys(std::vector<uint64_t>& keys, std::vector<uint32_t>& values,
+    std::vector<uint64_t>& scratchKeys, std::vector<uint32_t>& scratchValues)
+{
+    size_t count = keys.size();
+    scratchKeys.resize(count);
+    scratchValues.resize(count);
+
+    // One pass over the keys builds the histograms of all eight bytes
+    uint32_t histograms[8][256] = {};
+    for (uint64_t key : keys)
+    {
+        for (int byte = 0; byte < 8; ++byte)
+        {
+            ++histograms[byte][(key >> (byte * 8)) & 0xFF];
+        }
+    }
+
+    for (int byte = 0; byte < 8; ++byte)
+    {
+        uint32_t* histogram = histograms[byte];
+        if (count == 0 || histogram[(keys[0] >> (byte * 8)) & 0xFF] == count)
+        {
+            continue;
+        }
+
+        uint32_t offset = 0;
+        for (int digit = 0; digit < 256; ++digit)
+        {
+            uint32_t digitCount = histogram[digit];
+            histogram[digit] = offset;
+            offset += digitCount;
+        }
+
+        int shift = byte * 8;
+        for (size_t i = 0; i < count; ++i)
+        {
+            uint32_t slot = histogram[(keys[i] >> shift) & 0xFF]++;
+            scratchKeys[slot] = keys[i];
+            scratchValues[slot] = values[i];
+        }
+        keys.swap(scratchKeys);
+        values.swap(scratchValues);
+    }
+}
+
+void RenderQueue::begin(const glm::mat4& view, float farDistance)
+{
+    depthRow = -glm::vec4(view[0][2], view[1][2], view[2][2], view[3][2]);
+    inverseFar = 1.0f / farDistance;
+    materialIds.clear();
+    lastMaterial = RENDER_NO_MATERIAL;
+    commands.clear();
+    models.clear();
+    colors.clear();
+    keys.clear();
+    order.clear();
+}
+
+// Material Table
+bool RenderQueue::MaterialKey::operator==(const MaterialKey& other) const
+{
+    return bits[0] == other.bits[0] && bits[1] == other.bits[1] && bits[2] == other.bits[2] && bits[3] == other.bits[3];
+}
+
+size_t RenderQueue::MaterialKeyHash::operator()(const MaterialKey& key) const
+{
+    uint64_t low = (uint64_t(key.bits[1]) << 32) | key.bits[0];
+    uint64_t high = (uint64_t(key.bits[3]) << 32) | key.bits[2];
+    uint64_t hash = (low ^ (high * 0x9E3779B97F4A7C15ull)) * 0xFF51AFD7ED558CCDull;
+    return static_cast<size_t>(hash ^ (hash >> 32));
+}
+
+// Draws of one color tend to be recorded together, so the last id is checked before the table
+uint16_t RenderQueue::material(const glm::vec4& color)
+{
+    MaterialKey key;
+    std::memcpy(key.bits, &color[0], sizeof(key.bits));
+    if (lastMaterial != RENDER_NO_MATERIAL && key == lastMaterialKey)
+    {
+        return lastMaterial;
+    }
+
+    auto found = materialIds.find(key);
+    uint16_t id;
+    if (found != materialIds.end())
+    {
+        id = found->second;
+    }
+    else if (materialIds.size() < RENDER_MAX_MATERIALS)
+    {
+        id = static_cast<uint16_t>(materialIds.size());
+        materialIds.emplace(key, id);
+    }
+    else
+    {
+        id = RENDER_OVERFLOW_MATERIAL;
+    }
+    lastMaterialKey = key;
+    lastMaterial = id;
+    return id;
+}
+
+void RenderQueue::draw(RenderPass pass, uint32_t program, uint32_t vertexFormat, uint32_t mesh, const glm::vec4& color, const glm::mat4& model)
+{
+    DrawCommand command;
+    command.mesh = mesh;
+    command.firstInstance = 0;
+    command.instanceCount = 0;
+    command.matrix = static_cast<uint32_t>(models.size());
+    models.push_back(model);
+    colors.push_back(color);
+    add(pass, program, vertexFormat, mesh, material(color), glm::dot(depthRow, model[3]), command);
+}
+
+void RenderQueue::drawInstanced(RenderPass pass, uint32_t program, uint32_t vertexFormat, uint32_t mesh, uint16_t material,
+    const glm::vec3& center, uint32_t firstInstance, uint32_t instanceCount)
+{
+    DrawCommand command;
+    command.mesh = mesh;
+    command.firstInstance = firstInstance;
+    command.instanceCount = instanceCount;
+    command.matrix = 0;
+    add(pass, program, vertexFormat, mesh, material, glm::dot(depthRow, glm::vec4(center, 1.0f)), command);
+}
+
+void RenderQueue::add(RenderPass pass, uint32_t program, uint32_t vertexFormat, uint32_t mesh, uint16_t material, float viewDepth, const DrawCommand& command)
+{
+    keys.push_back(makeSortKey(pass, program, vertexFormat, mesh, material, viewDepth * inverseFar));
+    order.push_back(static_cast<uint32_t>(commands.size()));
+    commands.push_back(command);
+}
+
+void RenderQueue::sort()
+{
+    recorded = countStateChanges(keys.data(), keys.size());
+    radixSortKeys(keys, order, scratchKeys, scratchOrder);
+    sorted = countStateChanges(keys.data(), keys.size());
+}
+
+void RenderQueue::computeMvps(const glm::mat4& viewProjection)
+{
+    mvps.resize(models.size());
+    multiplyMatrices(viewProjection, models.data(), mvps.data(), models.size());
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Render Passes, drawn in this order
+enum RenderPass : uint32_t
+{
+    RENDER_PASS_OPAQUE,
+    RENDER_PASS_TRANSPARENT
+};
+
+// Sort Key
+// 64 bits, most significant first:
+//   63-62  pass
+//   61-59  program
+//   58-56  depth band     front to back for opaque, back to front for transparent
+//   55-54  vertex format
+//   53-38  mesh
+//   37-22  material
+//   21-0   depth          same direction as the band
+// Sorting by key groups draws by program, then splits them into a few coarse
+// depth bands so opaque geometry is drawn roughly front to back for early-Z,
+// and within a band groups them by VAO, mesh and material so those only
+// change when the key does.
+const int RENDER_DEPTH_BANDS = 8;
+const uint32_t RENDER_MAX_PROGRAMS = 8;
+const uint32_t RENDER_MAX_MESHES = 1u << 16;
+
+// Draws that take their color from somewhere else, e.g. the instance buffer
+const uint16_t RENDER_NO_MATERIAL = 0xFFFF;
+
+// Draws recorded once every material id of the frame is taken; they set
+// their own color with every draw
+const uint16_t RENDER_OVERFLOW_MATERIAL = 0xFFFE;
+const uint32_t RENDER_MAX_MATERIALS = RENDER_OVERFLOW_MATERIAL;
+
+// depth is the view depth divided by the far distance, clamped to [0, 1]
+uint64_t makeSortKey(RenderPass pass, uint32_t program, uint32_t vertexFormat, uint32_t mesh, uint16_t material, float depth);
+
+// Key fields, for submission and statistics
+inline uint32_t sortKeyProgram(uint64_t key) { return static_cast<uint32_t>(key >> 59) & 0x7u; }
+inline uint32_t sortKeyVertexFormat(uint64_t key) { return static_cast<uint32_t>(key >> 54) & 0x3u; }
+inline uint32_t sortKeyMesh(uint64_t key) { return static_cast<uint32_t>(key >> 38) & 0xFFFFu; }
+inline uint16_t sortKeyMaterial(uint64_t key) { return static_cast<uint16_t>(key >> 22); }
+
+// Draw Command
+// instanceCount 0 is a plain draw with its own model matrix and color,
+// models[matrix] and colors[matrix] in the queue; instanced draws take both
+// from the instance buffer
+struct DrawCommand
+{
+    uint32_t mesh;
+    uint32_t firstInstance;
+    uint32_t instanceCount;
+    uint32_t matrix;
+};
+
+// State Changes
+// How often each piece of state would change when drawing in a given order
+struct StateChangeCounts
+{
+    size_t program = 0;
+    size_t vertexFormat = 0;
+    size_t mesh = 0;
+    size_t material = 0;
+
+    size_t total() const { return program + vertexFormat + mesh + material; }
+};
+
+StateChangeCounts countStateChanges(const uint64_t* keys, size_t count);
+
+// Sorts keys and carries each key's 32-bit value along, LSD radix sort on bytes.
+// Byte positions where every key has the same value are skipped, so keys that
+// only use a few fields cost a few passes.
+void radixSortKeys(std::vector<uint64_t>& keys, std::vector<uint32_t>& values,
+    std::vector<uint64_t>& scratchKeys, std::vector<uint32_t>& scratchValues);
+
+// Render Queue
+// Draws are recorded in any order during the frame, sorted once and then
+// submitted in key order, so the submitter only touches GL state for the key
+// fields that differ from the previous command.
+class RenderQueue
+{
+public:
+    // Clears last frame's commands; depth is measured along the view direction up to farDistance
+    void begin(const glm::mat4& view, float farDistance);
+
+    // Plain draws get a material id per distinct color, so draws of one color sort together
+    void draw(RenderPass pass, uint32_t program, uint32_t vertexFormat, uint32_t mesh, const glm::vec4& color, const glm::mat4& model);
+    void drawInstanced(RenderPass pass, uint32_t program, uint32_t vertexFormat, uint32_t mesh, uint16_t material,
+        const glm::vec3& center, uint32_t firstInstance, uint32_t instanceCount);
+
+    // Sorts the recorded commands and counts state changes in both orders
+    void sort();
+
+    // Model-view-projection of every plain draw, in one batch over the
+    // recorded models; call once recording is done and before submitting
+    void computeMvps(const glm::mat4& viewProjection);
+    const glm::mat4& mvp(const DrawCommand& command) const { return mvps[command.matrix]; }
+    const glm::vec4& color(const DrawCommand& command) const { return colors[command.matrix]; }
+    size_t materialCount() const { return materialIds.size(); }
+
+    size_t size() const { return keys.size(); }
+    uint64_t key(size_t index) const { return keys[index]; }
+    const DrawCommand& command(size_t index) const { return commands[order[index]]; }
+
+    // State changes in the order draws were recorded and after sorting
+    const StateChangeCounts& recordedChanges() const { return recorded; }
+    const StateChangeCounts& sortedChanges() const { return sorted; }
+
+private:
+    // Colors compare by their bits, so the table needs no float equality
+    struct MaterialKey
+    {
+        uint32_t bits[4];
+        bool operator==(const MaterialKey& other) const;
+    };
+    struct MaterialKeyHash
+    {
+        size_t operator()(const MaterialKey& key) const;
+    };
+
+    // Material id for a color, reusing the id of an identical earlier color this
+    // frame; RENDER_OVERFLOW_MATERIAL once RENDER_MAX_MATERIALS are in use
+    uint16_t material(const glm::vec4& color);
+
+    void add(RenderPass pass, uint32_t program, uint32_t vertexFormat, uint32_t mesh, uint16_t material, float viewDepth, const DrawCommand& command);
+
+    // Dot with (position, 1) gives the view depth, the negated third row of the view matrix
+    glm::vec4 depthRow = glm::vec4(0.0f, 0.0f, -1.0f, 0.0f);
+    float inverseFar = 0.01f;
+
+    std::unordered_map<MaterialKey, uint16_t, MaterialKeyHash> materialIds;
+    MaterialKey lastMaterialKey = {};
+    uint16_t lastMaterial = RENDER_NO_MATERIAL;
+    std::vector<DrawCommand> commands;
+    std::vector<glm::mat4> models;
+    std::vector<glm::vec4> colors;
+    std::vector<glm::mat4> mvps;
+    std::vector<uint64_t> keys;
+    std::vector<uint32_t> order;
+    std::vector<uint64_t> scratchKeys;
+    std::vector<uint32_t> scratchOrder;
+
+    StateChangeCounts recorded;
+    StateChangeCounts sorted;
+};
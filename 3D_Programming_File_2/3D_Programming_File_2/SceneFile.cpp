@@ -0,0 +1,456 @@
+#include "SceneFile.h"
+#include "Bounds.h"
+#include "MeshGenerator.h"
+#include "MeshOptimizer.h"
+#include "World.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+static size_t alignUp(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// Scene File Reader
+static bool rangeInside(uint64_t offset, uint64_t size, uint64_t limit)
+{
+    return offset <= limit && size <= limit - offset;
+}
+
+bool SceneFile::open(const std::string& path)
+{
+    close();
+    if (!file.open(path))
+    {
+        return false;
+    }
+
+    const SceneHeader* candidate = reinterpret_cast<const SceneHeader*>(file.data());
+    if (file.size() < sizeof(SceneHeader) || std::memcmp(candidate->magic, SCENE_MAGIC, sizeof(SCENE_MAGIC)) != 0)
+    {
+        std::cerr << "Not a scene file: " << path << std::endl;
+        close();
+        return false;
+    }
+    if (candidate->version != SCENE_VERSION)
+    {
+        std::cerr << "Scene file " << path << " is version " << candidate->version << ", expected " << SCENE_VERSION << std::endl;
+        close();
+        return false;
+    }
+
+    uint64_t size = file.size();
+    bool valid = candidate->fileSize == size
+        && rangeInside(candidate->meshTableOffset, uint64_t(candidate->meshCount) * sizeof(SceneMesh), size)
+        && rangeInside(candidate->entityTableOffset, uint64_t(candidate->entityCount) * sizeof(SceneEntity), size)
+        && rangeInside(candidate->vertexDataOffset, candidate->vertexDataSize, size)
+        && rangeInside(candidate->indexDataOffset, candidate->indexDataSize, size)
+        && candidate->meshTableOffset % SCENE_ALIGNMENT == 0
+        && candidate->entityTableOffset % SCENE_ALIGNMENT == 0
+        && candidate->vertexDataOffset % SCENE_ALIGNMENT == 0
+        && candidate->indexDataOffset % SCENE_ALIGNMENT == 0;
+
+    const SceneMesh* meshTable = reinterpret_cast<const SceneMesh*>(file.data() + candidate->meshTableOffset);
+    for (uint32_t i = 0; valid && i < candidate->meshCount; ++i)
+    {
+        const SceneMesh& mesh = meshTable[i];
+        if (mesh.vertexFormat >= VERTEX_FORMAT_COUNT || (mesh.indexSize != 2 && mesh.indexSize != 4)
+            || std::memchr(mesh.name, 0, SCENE_NAME_LENGTH) == nullptr)
+        {
+            valid = false;
+            break;
+        }
+        size_t stride = vertexFormatSize(static_cast<VertexFormat>(mesh.vertexFormat));
+        valid = mesh.vertexOffset % stride == 0 && mesh.indexOffset % mesh.indexSize == 0
+            && rangeInside(mesh.vertexOffset, uint64_t(mesh.vertexCount) * stride, candidate->vertexDataSize)
+            && rangeInside(mesh.indexOffset, uint64_t(mesh.indexCount) * mesh.indexSize, candidate->indexDataSize);
+    }
+    if (!valid)
+    {
+        std::cerr << "Scene file is truncated or corrupt: " << path << std::endl;
+        close();
+        return false;
+    }
+
+    header = candidate;
+    meshes = meshTable;
+    entities = reinterpret_cast<const SceneEntity*>(file.data() + header->entityTableOffset);
+    return true;
+}
+
+void SceneFile::close()
+{
+    file.close();
+    header = nullptr;
+    meshes = nullptr;
+    entities = nullptr;
+}
+
+uint32_t SceneFile::findMesh(const char* name) const
+{
+    for (uint32_t i = 0; i < header->meshCount; ++i)
+    {
+        if (std::strcmp(meshes[i].name, name) == 0)
+        {
+            return i;
+        }
+    }
+    return SCENE_NO_MESH;
+}
+
+// Scene Builder
+static void copyName(char* destination, const std::string& name)
+{
+    std::memset(destination, 0, SCENE_NAME_LENGTH);
+    std::memcpy(destination, name.c_str(), std::min(name.size(), SCENE_NAME_LENGTH - 1));
+}
+
+uint32_t SceneBuilder::addMesh(const std::string& name, const std::vector<float>& vertices, const std::vector<uint32_t>& indices,
+    VertexFormat format, const std::vector<size_t>& sectionEnds)
+{
+    std::vector<float> optimizedVertices(vertices);
+    std::vector<uint32_t> optimizedIndices(indices);
+    size_t vertexCount = vertices.size() / 3;
+    MeshOptimizeReport report;
+    if (optimizeMeshes)
+    {
+        report = optimizeMesh(optimizedVertices, optimizedIndices, sectionEnds);
+    }
+
+    QuantizedVertices quantized = quantizeVertices(optimizedVertices.data(), vertexCount, format);
+    BoundingSphere bounds = computeBoundingSphere(optimizedVertices.data(), vertexCount);
+
+    SceneMesh mesh = {};
+    copyName(mesh.name, name);
+    mesh.vertexFormat = format;
+    mesh.indexSize = vertexCount > 65536 ? 4 : 2;
+    mesh.vertexOffset = alignUp(vertexData.size(), vertexFormatSize(format));
+    mesh.indexOffset = alignUp(indexData.size(), mesh.indexSize);
+    mesh.vertexCount = static_cast<uint32_t>(vertexCount);
+    mesh.indexCount = static_cast<uint32_t>(optimizedIndices.size());
+    mesh.boundsCenter[0] = bounds.center.x;
+    mesh.boundsCenter[1] = bounds.center.y;
+    mesh.boundsCenter[2] = bounds.center.z;
+    mesh.boundsRadius = bounds.radius + quantized.bounds.maxError;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        mesh.quantizationOffset[axis] = quantized.bounds.offset[axis];
+        mesh.quantizationScale[axis] = quantized.bounds.scale[axis];
+    }
+    mesh.quantizationError = quantized.bounds.maxError;
+    mesh.acmrBefore = report.before.acmr;
+    mesh.acmrAfter = report.after.acmr;
+    mesh.atvrBefore = report.before.atvr;
+    mesh.atvrAfter = report.after.atvr;
+
+    vertexData.resize(mesh.vertexOffset);
+    vertexData.insert(vertexData.end(), quantized.data.begin(), quantized.data.end());
+
+    indexData.resize(mesh.indexOffset + optimizedIndices.size() * mesh.indexSize);
+    uint8_t* destination = indexData.data() + mesh.indexOffset;
+    if (mesh.indexSize == 2)
+    {
+        for (size_t i = 0; i < optimizedIndices.size(); ++i)
+        {
+            uint16_t index = static_cast<uint16_t>(optimizedIndices[i]);
+            std::memcpy(destination + i * 2, &index, 2);
+        }
+    }
+    else if (!optimizedIndices.empty())
+    {
+        std::memcpy(destination, optimizedIndices.data(), optimizedIndices.size() * 4);
+    }
+
+    meshes.push_back(mesh);
+    return static_cast<uint32_t>(meshes.size() - 1);
+}
+
+uint32_t SceneBuilder::addSubmesh(const std::string& name, uint32_t parent, size_t firstIndex, size_t indexCount)
+{
+    SceneMesh mesh = meshes[parent];
+    copyName(mesh.name, name);
+    mesh.indexOffset += firstIndex * mesh.indexSize;
+    mesh.indexCount = static_cast<uint32_t>(indexCount);
+    meshes.push_back(mesh);
+    return static_cast<uint32_t>(meshes.size() - 1);
+}
+
+static void writePadding(std::ofstream& file, size_t& offset, size_t alignment)
+{
+    static const char zeros[SCENE_VERTEX_ALIGNMENT] = {};
+    size_t aligned = alignUp(offset, alignment);
+    file.write(zeros, aligned - offset);
+    offset = aligned;
+}
+
+static void writeBytes(std::ofstream& file, size_t& offset, const void* data, size_t size)
+{
+    if (size > 0)
+    {
+        file.write(static_cast<const char*>(data), size);
+    }
+    offset += size;
+}
+
+bool SceneBuilder::write(const std::string& path) const
+{
+    SceneHeader header = {};
+    std::memcpy(header.magic, SCENE_MAGIC, sizeof(SCENE_MAGIC));
+    header.version = SCENE_VERSION;
+    header.meshCount = static_cast<uint32_t>(meshes.size());
+    header.entityCount = static_cast<uint32_t>(entities.size());
+    header.meshTableOffset = alignUp(sizeof(SceneHeader), SCENE_ALIGNMENT);
+    header.entityTableOffset = alignUp(header.meshTableOffset + meshes.size() * sizeof(SceneMesh), SCENE_ALIGNMENT);
+    header.vertexDataOffset = alignUp(header.entityTableOffset + entities.size() * sizeof(SceneEntity), SCENE_ALIGNMENT);
+    header.vertexDataSize = vertexData.size();
+    header.indexDataOffset = alignUp(header.vertexDataOffset + vertexData.size(), SCENE_ALIGNMENT);
+    header.indexDataSize = indexData.size();
+    header.fileSize = header.indexDataOffset + indexData.size();
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+    {
+        std::cerr << "Failed to write scene file: " << path << std::endl;
+        return false;
+    }
+
+    size_t offset = 0;
+    writeBytes(file, offset, &header, sizeof(header));
+    writePadding(file, offset, SCENE_ALIGNMENT);
+    writeBytes(file, offset, meshes.data(), meshes.size() * sizeof(SceneMesh));
+    writePadding(file, offset, SCENE_ALIGNMENT);
+    writeBytes(file, offset, entities.data(), entities.size() * sizeof(SceneEntity));
+    writePadding(file, offset, SCENE_ALIGNMENT);
+    writeBytes(file, offset, vertexData.data(), vertexData.size());
+    writePadding(file, offset, SCENE_ALIGNMENT);
+    writeBytes(file, offset, indexData.data(), indexData.size());
+
+    if (!file)
+    {
+        std::cerr << "Failed to write scene file: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Scene Text
+static bool readFormat(std::istringstream& stream, VertexFormat& format)
+{
+    std::string name;
+    if (!(stream >> name))
+    {
+        format = VERTEX_FLOAT3;
+        return true;
+    }
+    return parseVertexFormat(name, format);
+}
+
+static SceneEntity makeEntity(SceneEntityKind kind, const glm::vec3& position, float scale, const glm::vec4& color)
+{
+    SceneEntity entity = {};
+    entity.kind = kind;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        entity.position[axis] = position[axis];
+        entity.target[axis] = position[axis];
+    }
+    entity.scale = scale;
+    for (int channel = 0; channel < 4; ++channel)
+    {
+        entity.color[channel] = color[channel];
+    }
+    return entity;
+}
+
+static std::vector<uint32_t> allIndices(const MeshData& mesh)
+{
+    std::vector<uint32_t> indices(mesh.shortIndices.begin(), mesh.shortIndices.end());
+    indices.insert(indices.end(), mesh.intIndices.begin(), mesh.intIndices.end());
+    return indices;
+}
+
+bool compileSceneText(const std::string& textPath, const std::string& scenePath)
+{
+    std::ifstream file(textPath);
+    if (!file)
+    {
+        std::cerr << "Failed to read scene description: " << textPath << std::endl;
+        return false;
+    }
+
+    struct PendingSubmesh
+    {
+        std::string name;
+        size_t firstTriangle;
+        size_t triangleCount;
+    };
+
+    SceneBuilder builder;
+    bool inMesh = false;
+    std::string meshName;
+    VertexFormat meshFormat = VERTEX_FLOAT3;
+    std::vector<float> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<size_t> sectionEnds;
+    std::vector<PendingSubmesh> submeshes;
+
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(file, line))
+    {
+        ++lineNumber;
+        std::istringstream stream(line);
+        std::string keyword;
+        if (!(stream >> keyword) || keyword[0] == '#')
+        {
+            continue;
+        }
+
+        bool valid = true;
+        if (inMesh)
+        {
+            if (keyword == "v")
+            {
+                float x = 0.0f, y = 0.0f, z = 0.0f;
+                valid = static_cast<bool>(stream >> x >> y >> z);
+                vertices.insert(vertices.end(), { x, y, z });
+            }
+            else if (keyword == "t")
+            {
+                uint32_t a = 0, b = 0, c = 0;
+                valid = static_cast<bool>(stream >> a >> b >> c);
+                indices.insert(indices.end(), { a, b, c });
+            }
+            else if (keyword == "section")
+            {
+                sectionEnds.push_back(indices.size());
+            }
+            else if (keyword == "submesh")
+            {
+                PendingSubmesh submesh;
+                valid = static_cast<bool>(stream >> submesh.name >> submesh.firstTriangle >> submesh.triangleCount);
+                submeshes.push_back(submesh);
+            }
+            else if (keyword == "end")
+            {
+                size_t vertexCount = vertices.size() / 3;
+                valid = std::all_of(indices.begin(), indices.end(), [vertexCount](uint32_t index) { return index < vertexCount; });
+
+                // Submeshes have to cover whole sections, or the optimizer could move triangles out of them
+                std::vector<size_t> boundaries(sectionEnds);
+                boundaries.push_back(0);
+                boundaries.push_back(indices.size());
+                for (const PendingSubmesh& submesh : submeshes)
+                {
+                    size_t first = submesh.firstTriangle * 3;
+                    size_t last = first + submesh.triangleCount * 3;
+                    valid = valid && last <= indices.size()
+                        && std::find(boundaries.begin(), boundaries.end(), first) != boundaries.end()
+                        && std::find(boundaries.begin(), boundaries.end(), last) != boundaries.end();
+                }
+                if (valid)
+                {
+                    uint32_t parent = builder.addMesh(meshName, vertices, indices, meshFormat, sectionEnds);
+                    for (const PendingSubmesh& submesh : submeshes)
+                    {
+                        builder.addSubmesh(submesh.name, parent, submesh.firstTriangle * 3, submesh.triangleCount * 3);
+                    }
+                }
+                inMesh = false;
+            }
+            else
+            {
+                valid = false;
+            }
+        }
+        else if (keyword == "mesh")
+        {
+            valid = static_cast<bool>(stream >> meshName) && readFormat(stream, meshFormat);
+            vertices.clear();
+            indices.clear();
+            sectionEnds.clear();
+            submeshes.clear();
+            inMesh = true;
+        }
+        else if (keyword == "box")
+        {
+            std::string name;
+            VertexFormat format;
+            glm::vec3 halfExtents;
+            std::string formatName;
+            valid = stream >> name >> formatName >> halfExtents.x >> halfExtents.y >> halfExtents.z && parseVertexFormat(formatName, format);
+            if (valid)
+            {
+                MeshData mesh = generateBox(halfExtents);
+                builder.addMesh(name, mesh.vertices, allIndices(mesh), format);
+            }
+        }
+        else if (keyword == "uvsphere")
+        {
+            std::string name;
+            std::string formatName;
+            VertexFormat format;
+            float radius;
+            int sectors, stacks;
+            valid = stream >> name >> formatName >> radius >> sectors >> stacks && parseVertexFormat(formatName, format)
+                && sectors >= 3 && stacks >= 2;
+            if (valid)
+            {
+                MeshData mesh = generateUvSphere(radius, sectors, stacks);
+                builder.addMesh(name, mesh.vertices, allIndices(mesh), format);
+            }
+        }
+        else if (keyword == "player" || keyword == "npc" || keyword == "pickup")
+        {
+            glm::vec3 position;
+            float scale;
+            valid = static_cast<bool>(stream >> position.x >> position.y >> position.z >> scale);
+            if (keyword == "player")
+            {
+                builder.addEntity(makeEntity(SCENE_PLAYER, position, scale, PLAYER_COLOR));
+            }
+            else if (keyword == "npc")
+            {
+                SceneEntity entity = makeEntity(SCENE_NPC, position, scale, NPC_COLOR);
+                valid = valid && stream >> entity.target[0] >> entity.target[1] >> entity.target[2];
+                builder.addEntity(entity);
+            }
+            else
+            {
+                SceneEntity entity = makeEntity(SCENE_PICKUP, position, scale, PICKUP_COLOR);
+                glm::vec4 color;
+                if (stream >> color.r >> color.g >> color.b >> color.a)
+                {
+                    std::memcpy(entity.color, &color[0], sizeof(entity.color));
+                }
+                builder.addEntity(entity);
+            }
+        }
+        else
+        {
+            valid = false;
+        }
+
+        if (!valid)
+        {
+            std::cerr << textPath << ":" << lineNumber << ": malformed line: " << line << std::endl;
+            return false;
+        }
+    }
+
+    if (inMesh)
+    {
+        std::cerr << textPath << ": mesh " << meshName << " has no end line" << std::endl;
+        return false;
+    }
+    if (!builder.write(scenePath))
+    {
+        return false;
+    }
+    std::cout << "Compiled " << textPath << " into " << scenePath << ": " << builder.meshCount() << " meshes, "
+              << builder.entityCount() << " entities" << std::endl;
+    return true;
+}
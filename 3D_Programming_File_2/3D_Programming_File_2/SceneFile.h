@@ -0,0 +1,175 @@
+#pragma once
+
+#include "MappedFile.h"
+#include "VertexQuantization.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Scene File
+// Versioned binary container for static meshes and entity placements, laid out
+// so the file can be memory mapped and used in place:
+//
+//   SceneHeader
+//   SceneMesh[meshCount]        name, ranges, bounds, quantization, cache stats
+//   SceneEntity[entityCount]    kind, position, scale, color, NPC route target
+//   vertex data                 every mesh's vertices, already optimized and quantized
+//   index data                  every mesh's indices, 16 or 32-bit per mesh
+//
+// Every section starts on a SCENE_ALIGNMENT boundary. Inside the vertex data a
+// mesh starts on a multiple of its vertex stride and inside the index data on a
+// multiple of its index size, so the two data sections can be handed to
+// glBufferData as they are and drawn with baseVertex and a byte index offset.
+// Submeshes are meshes that share another mesh's vertex range. All values are
+// little-endian.
+const char SCENE_MAGIC[4] = { 'S', 'C', 'N', 'E' };
+const uint32_t SCENE_VERSION = 1;
+const size_t SCENE_ALIGNMENT = 16;
+
+// Base alignment that keeps every vertex stride (12, 8 and 4 bytes) aligned
+const size_t SCENE_VERTEX_ALIGNMENT = 24;
+
+const size_t SCENE_NAME_LENGTH = 32;
+const uint32_t SCENE_NO_MESH = 0xFFFFFFFFu;
+
+struct SceneHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t meshCount;
+    uint32_t entityCount;
+    uint64_t fileSize;
+    uint64_t meshTableOffset;
+    uint64_t entityTableOffset;
+    uint64_t vertexDataOffset;
+    uint64_t vertexDataSize;
+    uint64_t indexDataOffset;
+    uint64_t indexDataSize;
+};
+
+struct SceneMesh
+{
+    char name[SCENE_NAME_LENGTH]; // Zero terminated
+    uint32_t vertexFormat; // VertexFormat
+    uint32_t indexSize; // 2 or 4 bytes
+    uint64_t vertexOffset; // Bytes into the vertex data
+    uint64_t indexOffset; // Bytes into the index data
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    float boundsCenter[3];
+    float boundsRadius;
+    float quantizationOffset[3];
+    float quantizationScale[3];
+    float quantizationError;
+    float acmrBefore;
+    float acmrAfter;
+    float atvrBefore;
+    float atvrAfter;
+    uint32_t reserved;
+};
+
+enum SceneEntityKind : uint32_t
+{
+    SCENE_PLAYER,
+    SCENE_NPC,
+    SCENE_PICKUP,
+    SCENE_ENTITY_KIND_COUNT
+};
+
+struct SceneEntity
+{
+    uint32_t kind; // SceneEntityKind
+    float position[3];
+    float scale;
+    float color[4];
+    float target[3]; // NPC route end, the route starts at position
+};
+
+static_assert(sizeof(SceneHeader) == 72, "SceneHeader layout changed, bump SCENE_VERSION");
+static_assert(sizeof(SceneMesh) == 128, "SceneMesh layout changed, bump SCENE_VERSION");
+static_assert(sizeof(SceneEntity) == 48, "SceneEntity layout changed, bump SCENE_VERSION");
+
+// Scene File Reader
+// Maps the file and checks that every table and range lies inside it. Nothing
+// is parsed or copied, the accessors point straight into the mapping.
+class SceneFile
+{
+public:
+    // Returns false and prints the reason if the file is missing or malformed
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return header != nullptr; }
+    size_t fileSize() const { return file.size(); }
+
+    size_t meshCount() const { return header->meshCount; }
+    const SceneMesh& mesh(size_t index) const { return meshes[index]; }
+
+    // Index of the mesh with the given name, SCENE_NO_MESH if there is none
+    uint32_t findMesh(const char* name) const;
+
+    size_t entityCount() const { return header->entityCount; }
+    const SceneEntity* entityData() const { return entities; }
+
+    const void* vertexData() const { return file.data() + header->vertexDataOffset; }
+    size_t vertexDataSize() const { return static_cast<size_t>(header->vertexDataSize); }
+    const void* indexData() const { return file.data() + header->indexDataOffset; }
+    size_t indexDataSize() const { return static_cast<size_t>(header->indexDataSize); }
+
+private:
+    MappedFile file;
+    const SceneHeader* header = nullptr;
+    const SceneMesh* meshes = nullptr;
+    const SceneEntity* entities = nullptr;
+};
+
+// Scene Builder
+// Collects meshes and entities and writes them in the layout above. Meshes are
+// run through the mesh optimizer and quantized here, so loading does no work.
+class SceneBuilder
+{
+public:
+    // Triangles are only reordered within sections ending at sectionEnds (in indices),
+    // returns the mesh's index in the scene
+    uint32_t addMesh(const std::string& name, const std::vector<float>& vertices, const std::vector<uint32_t>& indices,
+        VertexFormat format, const std::vector<size_t>& sectionEnds = std::vector<size_t>());
+
+    // A named slice of another mesh's indices, which should start and end on section boundaries
+    uint32_t addSubmesh(const std::string& name, uint32_t parent, size_t firstIndex, size_t indexCount);
+
+    void addEntity(const SceneEntity& entity) { entities.push_back(entity); }
+
+    // Skips the optimizer, e.g. for very large generated scenes
+    bool optimizeMeshes = true;
+
+    size_t meshCount() const { return meshes.size(); }
+    size_t entityCount() const { return entities.size(); }
+
+    bool write(const std::string& path) const;
+
+private:
+    std::vector<SceneMesh> meshes;
+    std::vector<SceneEntity> entities;
+    std::vector<uint8_t> vertexData;
+    std::vector<uint8_t> indexData;
+};
+
+// Scene Text
+// Converts a text description into a scene file:
+//
+//   # comment
+//   mesh <name> [float|snorm16|half|snorm10]
+//     v <x> <y> <z>
+//     t <a> <b> <c>                 triangle, zero-based vertex indices
+//     section                       triangles are not reordered across this line
+//     submesh <name> <firstTriangle> <triangleCount>
+//   end
+//   box <name> <format> <hx> <hy> <hz>
+//   uvsphere <name> <format> <radius> <sectors> <stacks>
+//   player <x> <y> <z> <scale>
+//   npc <x> <y> <z> <scale> <targetX> <targetY> <targetZ>
+//   pickup <x> <y> <z> <scale> [<r> <g> <b> <a>]
+//
+// Returns false and prints the offending line if the description is malformed.
+bool compileSceneText(const std::string& textPath, const std::string& scenePath);
@@ -0,0 +1,129 @@
+#include "Shader.h"
+#include <gtc/type_ptr.hpp>
+#include <iostream>
+#include <vector>
+
+static GLuint compileShader(GLenum type, const char* source)
+{
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+
+    int success;
+    char infoLog[512];
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        glGetShaderInfoLog(shader, 512, NULL, infoLog);
+        std::cerr << "ERROR::SHADER::COMPILATION_FAILED\n" << infoLog << std::endl;
+    }
+    return shader;
+}
+
+bool ShaderProgram::create(const char* vertexSource, const char* fragmentSource)
+{
+    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource);
+    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
+
+    program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    glLinkProgram(program);
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+
+    int success;
+    char infoLog[512];
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        glGetProgramInfoLog(program, 512, NULL, infoLog);
+        std::cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+        return false;
+    }
+
+    reflect();
+    return true;
+}
+
+void ShaderProgram::destroy()
+{
+    glDeleteProgram(program);
+    program = 0;
+    uniforms.clear();
+    uniformBlocks.clear();
+}
+
+// Reflection
+// Uniforms inside blocks report a location of -1 and are only reachable through their block
+void ShaderProgram::reflect()
+{
+    GLint count = 0;
+    GLint maxLength = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+    std::vector<char> name(maxLength > 0 ? maxLength : 1);
+    for (GLint i = 0; i < count; ++i)
+    {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(program, static_cast<GLuint>(i), maxLength, &length, &size, &type, name.data());
+
+        std::string uniformName(name.data(), length);
+        GLint location = glGetUniformLocation(program, uniformName.c_str());
+        if (location < 0)
+        {
+            continue;
+        }
+
+        // Arrays are reported as "name[0]", register them under their plain name as well
+        uniforms[uniformName] = location;
+        size_t bracket = uniformName.find('[');
+        if (bracket != std::string::npos)
+        {
+            uniforms[uniformName.substr(0, bracket)] = location;
+        }
+    }
+
+    count = 0;
+    maxLength = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxLength);
+
+    name.assign(maxLength > 0 ? maxLength : 1, '\0');
+    for (GLint i = 0; i < count; ++i)
+    {
+        GLsizei length = 0;
+        glGetActiveUniformBlockName(program, static_cast<GLuint>(i), maxLength, &length, name.data());
+        uniformBlocks[std::string(name.data(), length)] = static_cast<GLuint>(i);
+    }
+}
+
+GLint ShaderProgram::uniform(const std::string& name) const
+{
+    auto it = uniforms.find(name);
+    return it != uniforms.end() ? it->second : -1;
+}
+
+bool ShaderProgram::bindUniformBlock(const std::string& name, GLuint bindingPoint) const
+{
+    auto it = uniformBlocks.find(name);
+    if (it == uniformBlocks.end())
+    {
+        return false;
+    }
+    glUniformBlockBinding(program, it->second, bindingPoint);
+    return true;
+}
+
+void ShaderProgram::setMat4(GLint location, const glm::mat4& value) const
+{
+    glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
+}
+
+void ShaderProgram::setVec4(GLint location, const glm::vec4& value) const
+{
+    glUniform4fv(location, 1, glm::value_ptr(value));
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm.hpp>
+#include <string>
+#include <unordered_map>
+
+// Shader Program
+// Compiles and links a program, then reflects its active uniforms and uniform
+// blocks once. Look locations up at init time and keep them; the render loop
+// should never need a glGetUniformLocation string lookup.
+class ShaderProgram
+{
+public:
+    bool create(const char* vertexSource, const char* fragmentSource);
+    void destroy();
+
+    void use() const { glUseProgram(program); }
+    GLuint id() const { return program; }
+
+    // Returns -1 if the program has no active uniform with this name
+    GLint uniform(const std::string& name) const;
+
+    // Routes a uniform block to a binding point, returns false if the block is not active
+    bool bindUniformBlock(const std::string& name, GLuint bindingPoint) const;
+
+    void setMat4(GLint location, const glm::mat4& value) const;
+    void setVec4(GLint location, const glm::vec4& value) const;
+
+private:
+    void reflect();
+
+    GLuint program = 0;
+    std::unordered_map<std::string, GLint> uniforms;
+    std::unordered_map<std::string, GLuint> uniformBlocks;
+};
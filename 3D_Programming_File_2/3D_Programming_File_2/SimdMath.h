@@ -0,0 +1,74 @@
+#pragma once
+
+// SIMD Support
+// SIMD_SSE is set wherever SSE is available, which is every x64 build.
+// SIMD_AVX is set when the build targets AVX: the Release|x64 configurations,
+// or "make AVX=1" for the headless runner. Kernels use the widest one and
+// finish the remainder with the narrower ones.
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define SIMD_SSE 1
+#include <xmmintrin.h>
+#endif
+
+#if defined(__AVX__)
+#define SIMD_AVX 1
+#include <immintrin.h>
+#endif
+
+// Widest instruction set this build runs, for benchmark output
+#if SIMD_AVX
+const char* const SIMD_LANES_NAME = "AVX, 8 lanes";
+#elif SIMD_SSE
+const char* const SIMD_LANES_NAME = "SSE, 4 lanes";
+#else
+const char* const SIMD_LANES_NAME = "scalar";
+#endif
+
+#if SIMD_SSE
+
+// Packed vec3 Transposes
+// Four packed vec3s are three registers: x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3
+inline void loadVec3x4(const float* values, __m128& x, __m128& y, __m128& z)
+{
+    __m128 a = _mm_loadu_ps(values);
+    __m128 b = _mm_loadu_ps(values + 4);
+    __m128 c = _mm_loadu_ps(values + 8);
+    x = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+    y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+    z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+}
+
+inline void storeVec3x4(float* values, __m128 x, __m128 y, __m128 z)
+{
+    __m128 xy01 = _mm_unpacklo_ps(x, y);
+    __m128 xy23 = _mm_unpackhi_ps(x, y);
+    __m128 a = _mm_shuffle_ps(xy01, _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 1, 0));
+    __m128 b = _mm_shuffle_ps(_mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1)), xy23, _MM_SHUFFLE(1, 0, 2, 0));
+    __m128 c = _mm_shuffle_ps(_mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2)), _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+    _mm_storeu_ps(values, a);
+    _mm_storeu_ps(values + 4, b);
+    _mm_storeu_ps(values + 8, c);
+}
+
+#endif
+
+#if SIMD_AVX
+
+// Two SSE transposes, AVX shuffles can't cross the 128-bit halves
+inline void loadVec3x8(const float* values, __m256& x, __m256& y, __m256& z)
+{
+    __m128 x0, y0, z0, x1, y1, z1;
+    loadVec3x4(values, x0, y0, z0);
+    loadVec3x4(values + 12, x1, y1, z1);
+    x = _mm256_insertf128_ps(_mm256_castps128_ps256(x0), x1, 1);
+    y = _mm256_insertf128_ps(_mm256_castps128_ps256(y0), y1, 1);
+    z = _mm256_insertf128_ps(_mm256_castps128_ps256(z0), z1, 1);
+}
+
+inline void storeVec3x8(float* values, __m256 x, __m256 y, __m256 z)
+{
+    storeVec3x4(values, _mm256_castps256_ps128(x), _mm256_castps256_ps128(y), _mm256_castps256_ps128(z));
+    storeVec3x4(values + 12, _mm256_extractf128_ps(x, 1), _mm256_extractf128_ps(y, 1), _mm256_extractf128_ps(z, 1));
+}
+
+#endif
@@ -0,0 +1,168 @@
+#include "SimulationThread.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <chrono>
+
+float RenderSnapshot::alpha(double now) const
+{
+    double elapsed = accumulator + std::max(now - publishedAt, 0.0);
+    return static_cast<float>(std::min(elapsed / tickSeconds, 1.0));
+}
+
+double SimulationThread::clockSeconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void SimulationThread::start(World& world, double tickRate, InputRecording* recording)
+{
+    stop();
+    this->world = &world;
+    this->tickRate = tickRate;
+    this->recording = recording;
+    input.writeBuffer() = InputState();
+    input.publish();
+
+    // The first snapshot is published before the thread runs, so the renderer always has one
+    FixedTimestep timestep;
+    timestep.setTickRate(tickRate);
+    publishSnapshot(timestep, clockSeconds());
+
+    running.store(true, std::memory_order_release);
+    thread = std::thread(&SimulationThread::run, this);
+}
+
+void SimulationThread::stop()
+{
+    running.store(false, std::memory_order_release);
+    if (thread.joinable())
+    {
+        thread.join();
+    }
+}
+
+void SimulationThread::submitInput(const InputState& sampled)
+{
+    if (sampled.toggleRoute)
+    {
+        routeToggles.fetch_add(1, std::memory_order_relaxed);
+    }
+    InputState& held = input.writeBuffer();
+    held = sampled;
+    held.toggleRoute = false;
+    input.publish();
+}
+
+const RenderSnapshot& SimulationThread::latestSnapshot()
+{
+    snapshots.update();
+    return snapshots.readBuffer();
+}
+
+SimulationStats SimulationThread::stats() const
+{
+    SimulationStats result;
+    result.ticks = ticksRun.load(std::memory_order_relaxed);
+    result.batches = batchesRun.load(std::memory_order_relaxed);
+    result.simulationMs = simulationNs.load(std::memory_order_relaxed) / 1e6;
+    result.maxBatchGapMs = maxBatchGapNs.load(std::memory_order_relaxed) / 1e6;
+    return result;
+}
+
+// Simulation Loop
+// Runs whole ticks for the real time that passed, publishes, then sleeps until
+// the next tick is due. Sleeping undershoots by a millisecond and yields for
+// the rest, since sleep granularity can be coarser than a tick.
+void SimulationThread::run()
+{
+    PROFILE_THREAD_NAME("Simulation");
+    if (world->jobs)
+    {
+        world->jobs->registerThread();
+    }
+    FixedTimestep timestep;
+    timestep.setTickRate(tickRate);
+    float deltaTime = static_cast<float>(timestep.tickSeconds);
+    uint32_t routeTogglesSeen = routeToggles.load(std::memory_order_relaxed);
+    double last = clockSeconds();
+    double lastBatch = 0.0;
+
+    while (running.load(std::memory_order_acquire))
+    {
+        double now = clockSeconds();
+        int ticks = timestep.advance(now - last);
+        last = now;
+
+        if (ticks > 0)
+        {
+            std::chrono::steady_clock::time_point tickStart = std::chrono::steady_clock::now();
+            if (lastBatch > 0.0)
+            {
+                uint64_t gapNs = static_cast<uint64_t>((now - lastBatch) * 1e9);
+                if (gapNs > maxBatchGapNs.load(std::memory_order_relaxed))
+                {
+                    maxBatchGapNs.store(gapNs, std::memory_order_relaxed);
+                }
+            }
+            lastBatch = now;
+            input.update();
+            for (int tick = 0; tick < ticks; ++tick)
+            {
+                PROFILE_SCOPE("tickWorld");
+                InputState tickInput = input.readBuffer();
+
+                // One pending toggle per tick, like a key press held until a tick consumes it
+                uint32_t toggles = routeToggles.load(std::memory_order_relaxed);
+                tickInput.toggleRoute = toggles != routeTogglesSeen;
+                routeTogglesSeen += tickInput.toggleRoute ? 1 : 0;
+
+                tickWorld(*world, tickInput, deltaTime);
+                if (recording)
+                {
+                    recording->ticks.push_back(tickInput);
+                }
+            }
+            {
+                PROFILE_SCOPE("Publish Snapshot");
+                publishSnapshot(timestep, clockSeconds());
+            }
+            ticksRun.fetch_add(ticks, std::memory_order_relaxed);
+            batchesRun.fetch_add(1, std::memory_order_relaxed);
+            simulationNs.fetch_add(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - tickStart).count()), std::memory_order_relaxed);
+        }
+
+        double untilNextTick = timestep.tickSeconds - timestep.accumulator - (clockSeconds() - last);
+        if (untilNextTick > 0.002)
+        {
+            std::this_thread::sleep_for(std::chrono::duration<double>(untilNextTick - 0.001));
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+// Pickups only change through create and destroy, which bump the store's
+// revision, so an unchanged pickup store is not copied again
+void SimulationThread::publishSnapshot(const FixedTimestep& timestep, double now)
+{
+    RenderSnapshot& snapshot = snapshots.writeBuffer();
+    snapshot.players = world->players;
+    snapshot.npcs = world->npcs;
+    if (snapshot.pickups.revision() != world->pickups.revision() || snapshot.pickups.size() != world->pickups.size())
+    {
+        snapshot.pickups = world->pickups;
+    }
+    snapshot.transforms = world->transforms;
+    snapshot.sceneNodes = world->sceneNodes;
+    snapshot.player = world->player;
+    snapshot.isInHouse = world->isInHouse;
+    snapshot.tick = timestep.tick;
+    snapshot.tickSeconds = timestep.tickSeconds;
+    snapshot.accumulator = timestep.accumulator;
+    snapshot.publishedAt = now;
+    snapshots.publish();
+}
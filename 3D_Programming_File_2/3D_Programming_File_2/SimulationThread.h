@@ -0,0 +1,91 @@
+#pragma once
+
+#include "World.h"
+#include "InputRecording.h"
+#include "FixedTimestep.h"
+#include "TripleBuffer.h"
+#include <atomic>
+#include <thread>
+
+// Render Snapshot
+// Immutable copy of everything the renderer reads from the world after a batch
+// of simulation ticks. Positions keep their previous tick for interpolation.
+struct RenderSnapshot
+{
+    EntityStore players;
+    EntityStore npcs;
+    EntityStore pickups;
+    TransformGraph transforms;
+    SceneNodes sceneNodes;
+    EntityId player = INVALID_ENTITY;
+    bool isInHouse = false;
+
+    uint64_t tick = 0;
+    double tickSeconds = 1.0 / 60.0;
+
+    // Unsimulated time left over when this snapshot was published, and when that was
+    double accumulator = 0.0;
+    double publishedAt = 0.0;
+
+    // Interpolation factor between the last two ticks at the given clock time
+    float alpha(double now) const;
+};
+
+// Simulation Stats, totals since start
+// A batch is the ticks run back to back before one snapshot is published; the
+// gap is the wall time between the starts of two batches.
+struct SimulationStats
+{
+    uint64_t ticks = 0;
+    uint64_t batches = 0;
+    double simulationMs = 0.0;
+    double maxBatchGapMs = 0.0;
+};
+
+// Simulation Thread
+// Runs tickWorld at a fixed rate on its own thread and publishes a
+// RenderSnapshot through a triple buffer after every batch of ticks. The render
+// thread hands input over through a second triple buffer, so neither thread
+// ever blocks on the other and a slow buffer swap no longer delays ticks.
+// The world must not be touched by anyone else between start and stop.
+class SimulationThread
+{
+public:
+    ~SimulationThread() { stop(); }
+
+    // recording, if given, gets the input of every tick and is only safe to read after stop
+    void start(World& world, double tickRate, InputRecording* recording = nullptr);
+    void stop();
+
+    // Render thread: hands over the latest sampled input. Key presses that toggle
+    // something are counted, so none are lost between ticks.
+    void submitInput(const InputState& input);
+
+    // Render thread: the newest published snapshot, never blocks
+    const RenderSnapshot& latestSnapshot();
+
+    SimulationStats stats() const;
+
+    // Seconds on the clock used for RenderSnapshot::publishedAt
+    static double clockSeconds();
+
+private:
+    void run();
+    void publishSnapshot(const FixedTimestep& timestep, double now);
+
+    World* world = nullptr;
+    InputRecording* recording = nullptr;
+    double tickRate = 60.0;
+
+    std::thread thread;
+    std::atomic<bool> running{ false };
+
+    TripleBuffer<InputState> input;
+    std::atomic<uint32_t> routeToggles{ 0 };
+    TripleBuffer<RenderSnapshot> snapshots;
+
+    std::atomic<uint64_t> ticksRun{ 0 };
+    std::atomic<uint64_t> batchesRun{ 0 };
+    std::atomic<uint64_t> simulationNs{ 0 };
+    std::atomic<uint64_t> maxBatchGapNs{ 0 };
+};
@@ -0,0 +1,127 @@
+#include "SpatialHash.h"
+#include <cmath>
+
+void SpatialHash::clear()
+{
+    cellIndex.clear();
+    cells.clear();
+    locations.clear();
+    entryCount = 0;
+}
+
+void SpatialHash::setCellSize(float size)
+{
+    if (entryCount == 0 && size > 0.0f)
+    {
+        clear();
+        cellSize = size;
+        inverseCellSize = 1.0f / size;
+    }
+}
+
+int32_t SpatialHash::cellCoordinate(float value) const
+{
+    return static_cast<int32_t>(std::floor(value * inverseCellSize));
+}
+
+uint64_t SpatialHash::cellKey(int32_t x, int32_t z)
+{
+    return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(z);
+}
+
+void SpatialHash::insert(EntityId id, const glm::vec3& position)
+{
+    if (contains(id))
+    {
+        remove(id);
+    }
+
+    uint64_t key = cellKey(cellCoordinate(position.x), cellCoordinate(position.z));
+    auto found = cellIndex.find(key);
+    uint32_t cell;
+    if (found == cellIndex.end())
+    {
+        cell = static_cast<uint32_t>(cells.size());
+        cells.emplace_back();
+        cellIndex.emplace(key, cell);
+    }
+    else
+    {
+        cell = found->second;
+    }
+
+    if (id >= locations.size())
+    {
+        locations.resize(id + 1);
+    }
+    locations[id].cell = cell;
+    locations[id].slot = static_cast<uint32_t>(cells[cell].ids.size());
+    cells[cell].ids.push_back(id);
+    cells[cell].positions.push_back(position);
+    ++entryCount;
+}
+
+void SpatialHash::remove(EntityId id)
+{
+    if (!contains(id))
+    {
+        return;
+    }
+
+    Location& location = locations[id];
+    Cell& cell = cells[location.cell];
+
+    // Swap And Pop
+    size_t last = cell.ids.size() - 1;
+    if (location.slot != last)
+    {
+        cell.ids[location.slot] = cell.ids[last];
+        cell.positions[location.slot] = cell.positions[last];
+        locations[cell.ids[location.slot]].slot = location.slot;
+    }
+    cell.ids.pop_back();
+    cell.positions.pop_back();
+
+    location.cell = INVALID_CELL;
+    --entryCount;
+}
+
+void SpatialHash::build(const EntityStore& store)
+{
+    clear();
+    for (size_t i = 0; i < store.size(); ++i)
+    {
+        insert(store.ids[i], store.position[i]);
+    }
+}
+
+void SpatialHash::query(const glm::vec3& center, float radius, std::vector<EntityId>& result) const
+{
+    int32_t minX = cellCoordinate(center.x - radius);
+    int32_t maxX = cellCoordinate(center.x + radius);
+    int32_t minZ = cellCoordinate(center.z - radius);
+    int32_t maxZ = cellCoordinate(center.z + radius);
+    float radiusSquared = radius * radius;
+
+    for (int32_t x = minX; x <= maxX; ++x)
+    {
+        for (int32_t z = minZ; z <= maxZ; ++z)
+        {
+            auto found = cellIndex.find(cellKey(x, z));
+            if (found == cellIndex.end())
+            {
+                continue;
+            }
+
+            const Cell& cell = cells[found->second];
+            for (size_t i = 0; i < cell.ids.size(); ++i)
+            {
+                glm::vec3 offset = cell.positions[i] - center;
+                if (glm::dot(offset, offset) <= radiusSquared)
+                {
+                    result.push_back(cell.ids[i]);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "EntityStore.h"
+#include <unordered_map>
+
+// Spatial Hash
+// Uniform grid over the XZ plane that maps entities to the cell their position
+// falls in. Cells are created on first use and looked up through a hash map, so
+// the world can be unbounded. Insert and remove are O(1): every entity keeps
+// its cell and slot, and removal swaps the last entry of the cell into the gap.
+// A radius query only visits the cells overlapping the query circle, so with a
+// cell size close to the query radius that is at most 3x3 cells.
+class SpatialHash
+{
+public:
+    explicit SpatialHash(float cellSize = 0.5f) : cellSize(cellSize), inverseCellSize(1.0f / cellSize) {}
+
+    // Drops every entry, the cell size can only be changed while empty
+    void clear();
+    void setCellSize(float size);
+
+    void insert(EntityId id, const glm::vec3& position);
+    void remove(EntityId id);
+    void build(const EntityStore& store);
+
+    bool contains(EntityId id) const { return id < locations.size() && locations[id].cell != INVALID_CELL; }
+    size_t size() const { return entryCount; }
+
+    // Appends every entity within radius of center (3D distance) to result
+    void query(const glm::vec3& center, float radius, std::vector<EntityId>& result) const;
+
+private:
+    static const uint32_t INVALID_CELL = 0xFFFFFFFFu;
+
+    struct Cell
+    {
+        std::vector<EntityId> ids;
+        std::vector<glm::vec3> positions;
+    };
+
+    struct Location
+    {
+        uint32_t cell = INVALID_CELL;
+        uint32_t slot = 0;
+    };
+
+    int32_t cellCoordinate(float value) const;
+    static uint64_t cellKey(int32_t x, int32_t z);
+
+    float cellSize;
+    float inverseCellSize;
+    std::unordered_map<uint64_t, uint32_t> cellIndex;
+    std::vector<Cell> cells;
+
+    // Entity handle -> cell and slot, handles are small and reused so this stays dense
+    std::vector<Location> locations;
+    size_t entryCount = 0;
+};
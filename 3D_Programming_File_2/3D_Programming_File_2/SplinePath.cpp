@@ -0,0 +1,203 @@
+#define GLM_ENABLE_EXPERIMENTAL
+#include "SplinePath.h"
+#include "PointTable.h"
+#include <gtx/spline.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// Length samples per segment, also the distance steps per segment in the table
+static const size_t SAMPLES_PER_SEGMENT = 32;
+
+// Spline Path
+bool SplinePath::build(const std::vector<glm::vec3>& controlPoints, bool loop, float speed)
+{
+    points.clear();
+    parameterAt.clear();
+    step = 0.0f;
+    totalLength = 0.0f;
+    pathSpeed = speed;
+    this->loop = loop;
+
+    for (const glm::vec3& controlPoint : controlPoints)
+    {
+        if (points.empty() || controlPoint != points.back())
+        {
+            points.push_back(controlPoint);
+        }
+    }
+    if (loop && points.size() > 2 && points.front() == points.back())
+    {
+        points.pop_back();
+    }
+    if (points.size() < 2)
+    {
+        points.clear();
+        return false;
+    }
+
+    // Running length of the curve at evenly spaced parameters
+    size_t segments = loop ? points.size() : points.size() - 1;
+    size_t steps = segments * SAMPLES_PER_SEGMENT;
+    std::vector<float> lengths(steps + 1, 0.0f);
+    glm::vec3 previous = evaluate(0.0f);
+    for (size_t k = 1; k <= steps; ++k)
+    {
+        glm::vec3 current = evaluate(static_cast<float>(k) / SAMPLES_PER_SEGMENT);
+        lengths[k] = lengths[k - 1] + glm::distance(previous, current);
+        previous = current;
+    }
+    totalLength = lengths[steps];
+    if (totalLength <= 0.0f)
+    {
+        points.clear();
+        return false;
+    }
+
+    // Inverted into parameters at evenly spaced distances, both sides only grow so one pass does it
+    step = totalLength / steps;
+    parameterAt.resize(steps + 1);
+    size_t k = 0;
+    for (size_t i = 0; i < steps; ++i)
+    {
+        float distance = i * step;
+        while (k + 1 < steps && lengths[k + 1] < distance)
+        {
+            ++k;
+        }
+        float span = lengths[k + 1] - lengths[k];
+        float fraction = span > 0.0f ? glm::clamp((distance - lengths[k]) / span, 0.0f, 1.0f) : 0.0f;
+        parameterAt[i] = (k + fraction) / SAMPLES_PER_SEGMENT;
+    }
+    parameterAt[steps] = static_cast<float>(segments);
+    return true;
+}
+
+const glm::vec3& SplinePath::point(ptrdiff_t index) const
+{
+    ptrdiff_t count = static_cast<ptrdiff_t>(points.size());
+    if (loop)
+    {
+        return points[((index % count) + count) % count];
+    }
+
+    // Repeating the end points makes the curve start and stop on them
+    return points[glm::clamp<ptrdiff_t>(index, 0, count - 1)];
+}
+
+glm::vec3 SplinePath::evaluate(float parameter) const
+{
+    size_t segments = loop ? points.size() : points.size() - 1;
+    ptrdiff_t segment = static_cast<ptrdiff_t>(std::min(static_cast<size_t>(std::max(parameter, 0.0f)), segments - 1));
+    float t = glm::clamp(parameter - segment, 0.0f, 1.0f);
+    return glm::catmullRom(point(segment - 1), point(segment), point(segment + 1), point(segment + 2), t);
+}
+
+float SplinePath::wrap(float distance) const
+{
+    float lap = travel();
+    if (lap <= 0.0f)
+    {
+        return 0.0f;
+    }
+    distance = std::fmod(distance, lap);
+    return distance < 0.0f ? distance + lap : distance;
+}
+
+glm::vec3 SplinePath::positionAt(float distance) const
+{
+    if (empty())
+    {
+        return glm::vec3(0.0f);
+    }
+
+    distance = wrap(distance);
+    if (distance > totalLength)
+    {
+        distance = 2.0f * totalLength - distance;
+    }
+
+    float steps = distance / step;
+    size_t i = std::min(static_cast<size_t>(steps), parameterAt.size() - 2);
+    float parameter = glm::mix(parameterAt[i], parameterAt[i + 1], steps - i);
+    return evaluate(parameter);
+}
+
+// Point Files
+bool loadSplinePoints(const std::string& path, std::vector<glm::vec3>& points)
+{
+    PointTable table;
+    if (!readPointFile(path, table))
+    {
+        return false;
+    }
+    if (table.columnCount != 2 && table.columnCount != 3)
+    {
+        std::cerr << path << ": expected \"x y\" or \"x y z\" rows, found " << table.columnCount << " columns" << std::endl;
+        return false;
+    }
+
+    points.resize(table.rowCount);
+    const float* x = table.column(0);
+    const float* y = table.column(1);
+    for (size_t i = 0; i < table.rowCount; ++i)
+    {
+        points[i] = table.columnCount == 2 ? glm::vec3(x[i], 0.0f, y[i]) : glm::vec3(x[i], y[i], table.column(2)[i]);
+    }
+    return true;
+}
+
+void placeOnGround(std::vector<glm::vec3>& points, const glm::vec2& min, const glm::vec2& max, float height)
+{
+    if (points.empty())
+    {
+        return;
+    }
+
+    glm::vec2 low(points[0].x, points[0].z);
+    glm::vec2 high = low;
+    for (const glm::vec3& point : points)
+    {
+        low = glm::min(low, glm::vec2(point.x, point.z));
+        high = glm::max(high, glm::vec2(point.x, point.z));
+    }
+
+    glm::vec2 size = glm::max(high - low, glm::vec2(1e-6f));
+    glm::vec2 target = max - min;
+    float scale = std::min(target.x / size.x, target.y / size.y);
+    glm::vec2 offset = (min + max) * 0.5f - (low + high) * 0.5f * scale;
+    for (glm::vec3& point : points)
+    {
+        point = glm::vec3(point.x * scale + offset.x, height, point.z * scale + offset.y);
+    }
+}
+
+// Spline Followers
+void assignSpline(EntityStore& npcs, size_t index, const std::vector<SplinePath>& splines, uint32_t spline)
+{
+    glm::vec3 start = splines[spline].positionAt(0.0f);
+    npcs.route[index] = NO_ROUTE;
+    npcs.spline[index] = spline;
+    npcs.splineDistance[index] = 0.0f;
+    npcs.velocity[index] = glm::vec3(0.0f);
+    npcs.position[index] = start;
+    npcs.previousPosition[index] = start;
+    npcs.waypointFrom[index] = start;
+    npcs.waypointTo[index] = start;
+}
+
+void updateSplineFollowers(EntityStore& npcs, const std::vector<SplinePath>& splines, size_t begin, size_t end, float deltaTime)
+{
+    for (size_t i = begin; i < end; ++i)
+    {
+        uint32_t spline = npcs.spline[i];
+        if (spline == NO_SPLINE)
+        {
+            continue;
+        }
+        const SplinePath& path = splines[spline];
+        float distance = path.wrap(npcs.splineDistance[i] + path.speed() * deltaTime);
+        npcs.splineDistance[i] = distance;
+        npcs.position[i] = path.positionAt(distance);
+    }
+}
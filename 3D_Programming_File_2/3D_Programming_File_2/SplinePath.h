@@ -0,0 +1,59 @@
+#pragma once
+
+#include <glm.hpp>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "EntityStore.h"
+
+// Spline Path
+// Catmull-Rom curve through a list of points, walked by distance instead of
+// by curve parameter. build samples every segment and inverts the running
+// length into a table of parameters at equal distance steps, so finding the
+// point a given distance along the curve is one table read and one curve
+// evaluation. Open paths are walked there and back, closed paths loop.
+class SplinePath
+{
+public:
+    // Needs at least two points. Consecutive duplicate points are dropped.
+    bool build(const std::vector<glm::vec3>& points, bool loop, float speed);
+
+    // Distance is wrapped into [0, travel()), see wrap
+    glm::vec3 positionAt(float distance) const;
+
+    // Keeps a distance walked from the start inside one lap: [0, length) for
+    // a loop, [0, 2 * length) for an open path, the second half coming back
+    float wrap(float distance) const;
+
+    float length() const { return totalLength; }
+    float travel() const { return loop ? totalLength : 2.0f * totalLength; }
+    float speed() const { return pathSpeed; }
+    bool loops() const { return loop; }
+    bool empty() const { return points.size() < 2; }
+
+private:
+    glm::vec3 evaluate(float parameter) const;
+    const glm::vec3& point(ptrdiff_t index) const;
+
+    std::vector<glm::vec3> points;
+    std::vector<float> parameterAt; // Curve parameter at distance i * step, segment + fraction
+    float step = 0.0f;
+    float totalLength = 0.0f;
+    float pathSpeed = 0.0f;
+    bool loop = false;
+};
+
+// Reads one point per line, "x y" or "x y z". Two column points are taken as
+// x and z on the ground plane, so a curve plotted in 2D lies flat in the world.
+bool loadSplinePoints(const std::string& path, std::vector<glm::vec3>& points);
+
+// Scales the points evenly in X and Z to fit the rectangle [min, max] centred,
+// and moves them to the given height
+void placeOnGround(std::vector<glm::vec3>& points, const glm::vec2& min, const glm::vec2& max, float height);
+
+// Puts an entity at the start of a spline, clearing its route
+void assignSpline(EntityStore& npcs, size_t index, const std::vector<SplinePath>& splines, uint32_t spline);
+
+// Moves entities [begin, end) that follow a spline by their spline's speed.
+// Their velocity stays zero, so the crowd update leaves them where this puts them.
+void updateSplineFollowers(EntityStore& npcs, const std::vector<SplinePath>& splines, size_t begin, size_t end, float deltaTime);
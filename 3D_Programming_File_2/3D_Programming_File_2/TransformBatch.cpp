@@ -0,0 +1,106 @@
+#include "TransformBatch.h"
+#include "SimdMath.h"
+
+// Batch MVP
+void multiplyMatricesScalar(const glm::mat4& left, const glm::mat4* right, glm::mat4* out, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        out[i] = left * right[i];
+    }
+}
+
+// Instance MVP
+// The translation column is summed in pairs, the order the SSE version uses
+static glm::vec4 translationColumn(const glm::mat4& viewProjection, const glm::vec3& position)
+{
+    return (viewProjection[0] * position.x + viewProjection[1] * position.y)
+        + (viewProjection[2] * position.z + viewProjection[3]);
+}
+
+void computeInstanceMvpsScalar(const glm::mat4& viewProjection, const glm::vec3* positions, const float* scales,
+    const uint32_t* indices, size_t count, glm::mat4* out)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        size_t index = indices ? indices[i] : i;
+        float scale = scales[index];
+        out[i][0] = viewProjection[0] * scale;
+        out[i][1] = viewProjection[1] * scale;
+        out[i][2] = viewProjection[2] * scale;
+        out[i][3] = translationColumn(viewProjection, positions[index]);
+    }
+}
+
+#if SIMD_SSE
+
+// left * column, broadcasting each component of the column across a register
+static __m128 multiplyColumn(const __m128 left[4], __m128 column)
+{
+    __m128 x = _mm_shuffle_ps(column, column, _MM_SHUFFLE(0, 0, 0, 0));
+    __m128 y = _mm_shuffle_ps(column, column, _MM_SHUFFLE(1, 1, 1, 1));
+    __m128 z = _mm_shuffle_ps(column, column, _MM_SHUFFLE(2, 2, 2, 2));
+    __m128 w = _mm_shuffle_ps(column, column, _MM_SHUFFLE(3, 3, 3, 3));
+    return _mm_add_ps(_mm_add_ps(_mm_mul_ps(left[0], x), _mm_mul_ps(left[1], y)),
+        _mm_add_ps(_mm_mul_ps(left[2], z), _mm_mul_ps(left[3], w)));
+}
+
+void multiplyMatrices(const glm::mat4& left, const glm::mat4* right, glm::mat4* out, size_t count)
+{
+    // glm::mat4 is 16 packed floats, column-major and not necessarily 16-byte aligned
+    __m128 columns[4];
+    for (int c = 0; c < 4; ++c)
+    {
+        columns[c] = _mm_loadu_ps(&left[c][0]);
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const float* source = &right[i][0][0];
+        float* target = &out[i][0][0];
+        _mm_storeu_ps(target, multiplyColumn(columns, _mm_loadu_ps(source)));
+        _mm_storeu_ps(target + 4, multiplyColumn(columns, _mm_loadu_ps(source + 4)));
+        _mm_storeu_ps(target + 8, multiplyColumn(columns, _mm_loadu_ps(source + 8)));
+        _mm_storeu_ps(target + 12, multiplyColumn(columns, _mm_loadu_ps(source + 12)));
+    }
+}
+
+void computeInstanceMvps(const glm::mat4& viewProjection, const glm::vec3* positions, const float* scales,
+    const uint32_t* indices, size_t count, glm::mat4* out)
+{
+    __m128 column0 = _mm_loadu_ps(&viewProjection[0][0]);
+    __m128 column1 = _mm_loadu_ps(&viewProjection[1][0]);
+    __m128 column2 = _mm_loadu_ps(&viewProjection[2][0]);
+    __m128 column3 = _mm_loadu_ps(&viewProjection[3][0]);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        size_t index = indices ? indices[i] : i;
+        const glm::vec3& position = positions[index];
+        __m128 scale = _mm_set1_ps(scales[index]);
+        __m128 translation = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(column0, _mm_set1_ps(position.x)), _mm_mul_ps(column1, _mm_set1_ps(position.y))),
+            _mm_add_ps(_mm_mul_ps(column2, _mm_set1_ps(position.z)), column3));
+
+        float* target = &out[i][0][0];
+        _mm_storeu_ps(target, _mm_mul_ps(column0, scale));
+        _mm_storeu_ps(target + 4, _mm_mul_ps(column1, scale));
+        _mm_storeu_ps(target + 8, _mm_mul_ps(column2, scale));
+        _mm_storeu_ps(target + 12, translation);
+    }
+}
+
+#else
+
+void multiplyMatrices(const glm::mat4& left, const glm::mat4* right, glm::mat4* out, size_t count)
+{
+    multiplyMatricesScalar(left, right, out, count);
+}
+
+void computeInstanceMvps(const glm::mat4& viewProjection, const glm::vec3* positions, const float* scales,
+    const uint32_t* indices, size_t count, glm::mat4* out)
+{
+    computeInstanceMvpsScalar(viewProjection, positions, scales, indices, count, out);
+}
+
+#endif
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <glm.hpp>
+#include <cstddef>
+#include <cstdint>
+
+// Translate-Scale Model
+// glm::scale(glm::translate(glm::mat4(1.0f), position), glm::vec3(scale))
+// written out directly, without the two matrix products
+inline glm::mat4 translateScale(const glm::vec3& position, float scale)
+{
+    return glm::mat4(
+        glm::vec4(scale, 0.0f, 0.0f, 0.0f),
+        glm::vec4(0.0f, scale, 0.0f, 0.0f),
+        glm::vec4(0.0f, 0.0f, scale, 0.0f),
+        glm::vec4(position, 1.0f));
+}
+
+// Batch MVP
+// out[i] = left * right[i] over contiguous arrays, e.g. a view-projection
+// times every model matrix of a frame. The SIMD version keeps left in four
+// SSE registers and builds each column of the product from broadcasts of the
+// right column, the same scheme as glm_mat4_mul in glm/simd/matrix.h. It
+// falls back to multiplyMatricesScalar on targets without SSE.
+void multiplyMatrices(const glm::mat4& left, const glm::mat4* right, glm::mat4* out, size_t count);
+void multiplyMatricesScalar(const glm::mat4& left, const glm::mat4* right, glm::mat4* out, size_t count);
+
+// Instance MVP
+// out[i] = viewProjection * translateScale(positions[j], scales[j]) with
+// j = indices[i], or j = i if indices is null. Only the translation column
+// needs a matrix-vector product, the other three are scaled view-projection
+// columns. Both versions round the same way and match bit for bit.
+void computeInstanceMvps(const glm::mat4& viewProjection, const glm::vec3* positions, const float* scales,
+    const uint32_t* indices, size_t count, glm::mat4* out);
+void computeInstanceMvpsScalar(const glm::mat4& viewProjection, const glm::vec3* positions, const float* scales,
+    const uint32_t* indices, size_t count, glm::mat4* out);
@@ -0,0 +1,77 @@
+#include "TransformGraph.h"
+#include <algorithm>
+
+uint32_t TransformGraph::add(uint32_t parent, const glm::mat4& local)
+{
+    uint32_t node = static_cast<uint32_t>(parents.size());
+    parents.push_back(parent < node ? parent : TRANSFORM_NO_PARENT);
+    locals.push_back(local);
+    worlds.push_back(local);
+    dirty.push_back(1);
+    updatedIn.push_back(0);
+    firstDirty = std::min<size_t>(firstDirty, node);
+    return node;
+}
+
+void TransformGraph::setLocal(uint32_t node, const glm::mat4& local)
+{
+    locals[node] = local;
+    dirty[node] = 1;
+    firstDirty = std::min<size_t>(firstDirty, node);
+}
+
+void TransformGraph::clear()
+{
+    parents.clear();
+    locals.clear();
+    worlds.clear();
+    dirty.clear();
+    updatedIn.clear();
+    pass = 0;
+    firstDirty = 0;
+}
+
+size_t TransformGraph::update()
+{
+    size_t count = parents.size();
+    if (firstDirty >= count)
+    {
+        return 0;
+    }
+
+    // Stamps from an earlier pass could match again once the counter wraps
+    if (++pass == 0)
+    {
+        std::fill(updatedIn.begin(), updatedIn.end(), 0);
+        pass = 1;
+    }
+
+    size_t recomputed = 0;
+    for (size_t i = firstDirty; i < count; ++i)
+    {
+        uint32_t parent = parents[i];
+        bool parentChanged = parent != TRANSFORM_NO_PARENT && updatedIn[parent] == pass;
+        if (!dirty[i] && !parentChanged)
+        {
+            continue;
+        }
+        worlds[i] = parent != TRANSFORM_NO_PARENT ? worlds[parent] * locals[i] : locals[i];
+        dirty[i] = 0;
+        updatedIn[i] = pass;
+        ++recomputed;
+    }
+    firstDirty = count;
+    return recomputed;
+}
+
+void TransformGraph::updateAll()
+{
+    size_t count = parents.size();
+    for (size_t i = 0; i < count; ++i)
+    {
+        uint32_t parent = parents[i];
+        worlds[i] = parent != TRANSFORM_NO_PARENT ? worlds[parent] * locals[i] : locals[i];
+        dirty[i] = 0;
+    }
+    firstDirty = count;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+const uint32_t TRANSFORM_NO_PARENT = 0xFFFFFFFF;
+
+// Transform Graph
+// Parent/child transforms flattened into arrays ordered parents first: a node
+// can only be added under a node that already exists, so every parent comes
+// before its children. setLocal marks a node dirty; update() then walks the
+// array once from the first dirty node and recomputes a world matrix only if
+// the node is dirty or its parent was recomputed in the same pass, which
+// covers exactly the dirty subtrees.
+class TransformGraph
+{
+public:
+    // Returns the new node, parent is TRANSFORM_NO_PARENT for a root
+    uint32_t add(uint32_t parent, const glm::mat4& local);
+    void setLocal(uint32_t node, const glm::mat4& local);
+    void clear();
+
+    size_t size() const { return parents.size(); }
+    uint32_t parent(uint32_t node) const { return parents[node]; }
+    const glm::mat4& local(uint32_t node) const { return locals[node]; }
+
+    // As of the last update
+    const glm::mat4& world(uint32_t node) const { return worlds[node]; }
+    glm::vec3 worldPoint(uint32_t node, const glm::vec3& point) const { return glm::vec3(worlds[node] * glm::vec4(point, 1.0f)); }
+
+    // Returns how many world matrices were recomputed
+    size_t update();
+
+    // Recomputes every world matrix, dirty or not
+    void updateAll();
+
+private:
+    std::vector<uint32_t> parents;
+    std::vector<glm::mat4> locals;
+    std::vector<glm::mat4> worlds;
+    std::vector<uint8_t> dirty;
+
+    // Pass that last recomputed each node, so children can tell their parent changed
+    std::vector<uint32_t> updatedIn;
+    uint32_t pass = 0;
+    size_t firstDirty = 0;
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Triple Buffer
+// Lock-free single producer, single consumer handoff of the latest value. The
+// writer fills its own buffer and publishes it by swapping it with the shared
+// middle one; the reader swaps the middle one for its own buffer whenever a
+// newer value was published. Neither side ever waits for the other, the reader
+// simply keeps its buffer until there is something newer, and buffers are
+// reused so their contents (e.g. vector capacity) survive between rounds.
+template <typename T>
+class TripleBuffer
+{
+public:
+    // Writer side
+    T& writeBuffer() { return buffers[back]; }
+
+    void publish()
+    {
+        uint8_t previous = middle.exchange(static_cast<uint8_t>(back | FRESH), std::memory_order_acq_rel);
+        back = previous & INDEX_MASK;
+    }
+
+    // Reader side, returns true if the read buffer changed
+    bool update()
+    {
+        if ((middle.load(std::memory_order_relaxed) & FRESH) == 0)
+        {
+            return false;
+        }
+        uint8_t previous = middle.exchange(front, std::memory_order_acq_rel);
+        front = previous & INDEX_MASK;
+        return true;
+    }
+
+    const T& readBuffer() const { return buffers[front]; }
+
+private:
+    static const uint8_t INDEX_MASK = 0x3;
+    static const uint8_t FRESH = 0x4;
+
+    T buffers[3];
+
+    // Index of the middle buffer plus FRESH if the reader has not taken it yet
+    alignas(64) std::atomic<uint8_t> middle{ 1 };
+    alignas(64) uint8_t back = 0;
+    alignas(64) uint8_t front = 2;
+};
@@ -0,0 +1,96 @@
+#include "VertexQuantization.h"
+#include <gtc/packing.hpp>
+#include <algorithm>
+#include <cstring>
+
+size_t vertexFormatSize(VertexFormat format)
+{
+    switch (format)
+    {
+    case VERTEX_SNORM16: return sizeof(glm::uint64);
+    case VERTEX_HALF: return sizeof(glm::uint64);
+    case VERTEX_SNORM10: return sizeof(glm::uint32);
+    default: return 3 * sizeof(float);
+    }
+}
+
+const char* vertexFormatName(VertexFormat format)
+{
+    switch (format)
+    {
+    case VERTEX_SNORM16: return "snorm16";
+    case VERTEX_HALF: return "half";
+    case VERTEX_SNORM10: return "snorm10";
+    default: return "float";
+    }
+}
+
+bool parseVertexFormat(const std::string& name, VertexFormat& format)
+{
+    for (uint32_t candidate = 0; candidate < VERTEX_FORMAT_COUNT; ++candidate)
+    {
+        if (name == vertexFormatName(static_cast<VertexFormat>(candidate)))
+        {
+            format = static_cast<VertexFormat>(candidate);
+            return true;
+        }
+    }
+    return false;
+}
+
+QuantizedVertices quantizeVertices(const float* vertices, size_t vertexCount, VertexFormat format)
+{
+    QuantizedVertices result;
+    size_t stride = vertexFormatSize(format);
+    result.data.resize(vertexCount * stride);
+    if (format == VERTEX_FLOAT3 || vertexCount == 0)
+    {
+        if (vertexCount > 0)
+        {
+            std::memcpy(result.data.data(), vertices, result.data.size());
+        }
+        return result;
+    }
+
+    // Map the bounding box onto [-1, 1] on every axis, flat axes keep a tiny extent
+    glm::vec3 min(vertices[0], vertices[1], vertices[2]);
+    glm::vec3 max = min;
+    for (size_t i = 1; i < vertexCount; ++i)
+    {
+        glm::vec3 vertex(vertices[i * 3], vertices[i * 3 + 1], vertices[i * 3 + 2]);
+        min = glm::min(min, vertex);
+        max = glm::max(max, vertex);
+    }
+    result.bounds.offset = (min + max) * 0.5f;
+    result.bounds.scale = glm::max((max - min) * 0.5f, glm::vec3(1.0e-6f));
+
+    uint8_t* output = result.data.data();
+    for (size_t i = 0; i < vertexCount; ++i, output += stride)
+    {
+        glm::vec3 vertex(vertices[i * 3], vertices[i * 3 + 1], vertices[i * 3 + 2]);
+        glm::vec4 normalized(glm::clamp((vertex - result.bounds.offset) / result.bounds.scale, -1.0f, 1.0f), 0.0f);
+
+        glm::vec3 decoded;
+        if (format == VERTEX_SNORM16)
+        {
+            glm::uint64 packed = glm::packSnorm4x16(normalized);
+            std::memcpy(output, &packed, sizeof(packed));
+            decoded = glm::vec3(glm::unpackSnorm4x16(packed));
+        }
+        else if (format == VERTEX_HALF)
+        {
+            glm::uint64 packed = glm::packHalf4x16(normalized);
+            std::memcpy(output, &packed, sizeof(packed));
+            decoded = glm::vec3(glm::unpackHalf4x16(packed));
+        }
+        else
+        {
+            glm::uint32 packed = glm::packSnorm3x10_1x2(normalized);
+            std::memcpy(output, &packed, sizeof(packed));
+            decoded = glm::vec3(glm::unpackSnorm3x10_1x2(packed));
+        }
+
+        result.bounds.maxError = std::max(result.bounds.maxError, glm::length(result.bounds.offset + decoded * result.bounds.scale - vertex));
+    }
+    return result;
+}
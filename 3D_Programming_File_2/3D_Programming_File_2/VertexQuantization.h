@@ -0,0 +1,48 @@
+#pragma once
+
+#include <glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Vertex Formats
+// Positions are either plain floats or quantized to [-1, 1] relative to the
+// mesh's bounding box and packed with glm's gtc/packing functions:
+//   VERTEX_FLOAT3   12 bytes, exact
+//   VERTEX_SNORM16   8 bytes, packSnorm4x16
+//   VERTEX_HALF      8 bytes, packHalf4x16
+//   VERTEX_SNORM10   4 bytes, packSnorm3x10_1x2
+enum VertexFormat : uint32_t
+{
+    VERTEX_FLOAT3,
+    VERTEX_SNORM16,
+    VERTEX_HALF,
+    VERTEX_SNORM10,
+    VERTEX_FORMAT_COUNT
+};
+
+size_t vertexFormatSize(VertexFormat format);
+const char* vertexFormatName(VertexFormat format);
+
+// Looks a format up by the name vertexFormatName gives it, returns false if there is none
+bool parseVertexFormat(const std::string& name, VertexFormat& format);
+
+// Quantization Bounds
+// The original position is offset + decoded * scale, which the vertex shader
+// undoes per mesh. maxError is the largest distance between an original and a
+// decoded position, in mesh units.
+struct QuantizationBounds
+{
+    glm::vec3 offset = glm::vec3(0.0f);
+    glm::vec3 scale = glm::vec3(1.0f);
+    float maxError = 0.0f;
+};
+
+struct QuantizedVertices
+{
+    std::vector<uint8_t> data;
+    QuantizationBounds bounds;
+};
+
+QuantizedVertices quantizeVertices(const float* vertices, size_t vertexCount, VertexFormat format);
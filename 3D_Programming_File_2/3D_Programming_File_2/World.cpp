@@ -0,0 +1,382 @@
+#include "World.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "SceneFile.h"
+#include <gtc/matrix_transform.hpp>
+#include <random>
+
+// NPC Routes
+const glm::vec3 npcPosition1 = glm::vec3(-1.5f, -0.2f, 0.0f);
+const glm::vec3 npcPosition2 = glm::vec3(0.0f, -0.2f, 0.5f);
+const glm::vec3 npcPosition3 = glm::vec3(0.0f, -0.2f, 0.5f);
+const glm::vec3 npcPosition4 = glm::vec3(0.0f, -0.2f, -1.0f);
+const float npcSpeed = 1.0f;
+
+// Scene Transforms
+// The house mesh spans x -0.5 .. 0.5 and z 0 .. 1 around its origin, with its
+// front at z 0. The door mesh is 0.2 wide, its bottom edge at y -0.5.
+const float planeAngle = glm::radians(60.0f);
+const glm::vec3 houseOffset = glm::vec3(1.5f, 0.0f, 0.5f);
+const glm::vec3 doorOffset = glm::vec3(-0.2f, 0.05f, -0.01f); // On the house front, just outside it
+const glm::vec3 houseFootprintMin = glm::vec3(-0.5f, 0.0f, 0.0f);
+const glm::vec3 houseFootprintMax = glm::vec3(0.5f, 0.0f, 1.0f);
+
+// In the door's space: the middle of its bottom edge, and where the player comes out in front of it
+const glm::vec3 doorThreshold = glm::vec3(0.0f, -0.5f, 0.0f);
+const glm::vec3 doorExit = glm::vec3(0.0f, -0.45f, -0.4f);
+
+// The plane's rotation is its own node, so the house doesn't inherit it
+static void buildSceneTransforms(TransformGraph& transforms, SceneNodes& nodes)
+{
+    transforms.clear();
+    nodes.ground = transforms.add(TRANSFORM_NO_PARENT, glm::mat4(1.0f));
+    nodes.plane = transforms.add(nodes.ground, glm::rotate(glm::mat4(1.0f), planeAngle, glm::vec3(0.0f, 1.0f, 0.0f)));
+    nodes.house = transforms.add(nodes.ground, glm::translate(glm::mat4(1.0f), houseOffset));
+    nodes.door = transforms.add(nodes.house, glm::translate(glm::mat4(1.0f), doorOffset));
+    nodes.interior = transforms.add(TRANSFORM_NO_PARENT, glm::mat4(1.0f));
+    transforms.update();
+}
+
+// Navigation Grid, the ground at NPC height with the house footprint blocked
+const glm::vec3 navOrigin = glm::vec3(-2.0f, -0.2f, -2.0f);
+const float navSpacing = 0.25f;
+const size_t navColumns = 21;
+const size_t navRows = 21;
+
+static void buildNavGraph(NavGraph& graph, const TransformGraph& transforms, uint32_t house)
+{
+    glm::vec3 houseMin = transforms.worldPoint(house, houseFootprintMin);
+    glm::vec3 houseMax = transforms.worldPoint(house, houseFootprintMax);
+    std::vector<uint8_t> blocked(navColumns * navRows, 0);
+    for (size_t row = 0; row < navRows; ++row)
+    {
+        for (size_t column = 0; column < navColumns; ++column)
+        {
+            float x = navOrigin.x + column * navSpacing;
+            float z = navOrigin.z + row * navSpacing;
+            blocked[row * navColumns + column] = x >= houseMin.x && x <= houseMax.x && z >= houseMin.z && z <= houseMax.z;
+        }
+    }
+    buildGridGraph(graph, navOrigin, navSpacing, navColumns, navRows, &blocked);
+}
+
+// Patrol routes every NPC switches between on toggleNpcRoutes, the first two in World::npcRoutes
+const uint32_t PATROL_ROUTE_1 = 0;
+const uint32_t PATROL_ROUTE_2 = 1;
+
+// Walks the A* path from one end to the other and back along the same nodes
+static void addPatrolRoute(const NavGraph& graph, CrowdRoutes& routes, const glm::vec3& from, const glm::vec3& to)
+{
+    PathSolver solver(graph);
+    std::vector<uint32_t> path;
+    std::vector<glm::vec3> waypoints;
+    if (solver.find(graph.nearestNode(from), graph.nearestNode(to), path))
+    {
+        appendPathWaypoints(graph, path, waypoints);
+        for (size_t i = waypoints.size() - 1; i-- > 1;)
+        {
+            waypoints.push_back(waypoints[i]);
+        }
+    }
+    else
+    {
+        waypoints = { from, to };
+    }
+    routes.add(waypoints.data(), waypoints.size(), npcSpeed);
+}
+
+static void addPatrolRoutes(const NavGraph& graph, CrowdRoutes& routes)
+{
+    routes.clear();
+    addPatrolRoute(graph, routes, npcPosition1, npcPosition2);
+    addPatrolRoute(graph, routes, npcPosition3, npcPosition4);
+}
+
+// Player Movement Speed in units per second
+const float playerSpeed = 1.0f;
+
+void initWorld(World& world)
+{
+    world.players.clear();
+    world.npcs.clear();
+    world.npcSplines.clear();
+    world.pickups.clear();
+
+    // Player
+    world.player = world.players.create(glm::vec3(1.0f, -0.4f, 2.0f), 0.1f, PLAYER_COLOR, MESH_PLAYER);
+
+    // NPC
+    world.npcOnPath1 = true;
+    buildSceneTransforms(world.transforms, world.sceneNodes);
+    buildNavGraph(world.navGraph, world.transforms, world.sceneNodes.house);
+    addPatrolRoutes(world.navGraph, world.npcRoutes);
+    world.npcs.create(npcPosition1, 0.1f, NPC_COLOR, MESH_NPC);
+    assignRoute(world.npcs, 0, world.npcRoutes, PATROL_ROUTE_1);
+
+    // Sphere Positions
+    world.pickups.create(glm::vec3(-1.5f, -0.4f, 0.0f), 1.0f, PICKUP_COLOR, MESH_SPHERE);
+    world.pickups.create(glm::vec3(0.0f, -0.4f, 0.5f), 1.0f, PICKUP_COLOR, MESH_SPHERE);
+    world.pickups.create(glm::vec3(2.5f, -0.4f, 0.2f), 1.0f, PICKUP_COLOR, MESH_SPHERE);
+    world.pickups.create(glm::vec3(1.5f, -0.4f, 2.0f), 1.0f, PICKUP_COLOR, MESH_SPHERE);
+    world.pickups.create(glm::vec3(0.0f, -0.4f, 2.0f), 1.0f, PICKUP_COLOR, MESH_SPHERE);
+    world.pickups.create(glm::vec3(0.0f, -0.4f, -1.0f), 1.0f, PICKUP_COLOR, MESH_SPHERE);
+    world.pickupIndex.build(world.pickups);
+
+    world.isInHouse = false;
+}
+
+void loadSceneEntities(World& world, const SceneFile& scene)
+{
+    const SceneEntity* entities = scene.entityData();
+    size_t counts[SCENE_ENTITY_KIND_COUNT] = {};
+    for (size_t i = 0; i < scene.entityCount(); ++i)
+    {
+        if (entities[i].kind < SCENE_ENTITY_KIND_COUNT)
+        {
+            ++counts[entities[i].kind];
+        }
+    }
+
+    if (counts[SCENE_PLAYER] > 0)
+    {
+        world.players.clear();
+        world.player = INVALID_ENTITY;
+    }
+    if (counts[SCENE_NPC] > 0)
+    {
+        world.npcs.clear();
+        world.npcs.reserve(counts[SCENE_NPC]);
+        world.npcSplines.clear();
+        world.npcOnPath1 = true;
+        addPatrolRoutes(world.navGraph, world.npcRoutes);
+    }
+    if (counts[SCENE_PICKUP] > 0)
+    {
+        world.pickups.clear();
+        world.pickups.reserve(counts[SCENE_PICKUP]);
+    }
+
+    for (size_t i = 0; i < scene.entityCount(); ++i)
+    {
+        const SceneEntity& entity = entities[i];
+        glm::vec3 position(entity.position[0], entity.position[1], entity.position[2]);
+        glm::vec4 color(entity.color[0], entity.color[1], entity.color[2], entity.color[3]);
+        switch (entity.kind)
+        {
+        case SCENE_PLAYER:
+            // There is only one player, the first placement wins
+            if (world.player == INVALID_ENTITY)
+            {
+                world.player = world.players.create(position, entity.scale, color, MESH_PLAYER);
+            }
+            break;
+        case SCENE_NPC:
+        {
+            size_t index = world.npcs.indexOf(world.npcs.create(position, entity.scale, color, MESH_NPC));
+            setNpcRoute(world.npcs, world.npcRoutes, index, position, glm::vec3(entity.target[0], entity.target[1], entity.target[2]), npcSpeed);
+            break;
+        }
+        case SCENE_PICKUP:
+            world.pickups.create(position, entity.scale, color, MESH_SPHERE);
+            break;
+        default:
+            break;
+        }
+    }
+
+    if (counts[SCENE_PICKUP] > 0)
+    {
+        world.pickupIndex.build(world.pickups);
+    }
+}
+
+glm::vec3& playerPosition(World& world)
+{
+    return world.players.position[world.players.indexOf(world.player)];
+}
+
+glm::vec3 doorThresholdPosition(const TransformGraph& transforms, const SceneNodes& nodes)
+{
+    return transforms.worldPoint(nodes.door, doorThreshold);
+}
+
+// Moves the player without interpolating across the jump
+static void teleportPlayer(World& world, const glm::vec3& position)
+{
+    size_t index = world.players.indexOf(world.player);
+    world.players.position[index] = position;
+    world.players.previousPosition[index] = position;
+}
+
+void tickWorld(World& world, const InputState& input, float deltaTime)
+{
+    world.players.savePreviousPositions();
+    world.npcs.savePreviousPositions();
+
+    // Player Movement
+    float sprintFactor = input.sprint ? 2.0f : 1.0f;
+    glm::vec3& position = playerPosition(world);
+    position.x += input.moveX * playerSpeed * sprintFactor * deltaTime;
+    position.z += input.moveZ * playerSpeed * sprintFactor * deltaTime;
+
+    if (input.collect)
+    {
+        collectPickups(world.pickups, world.pickupIndex, position, COLLECT_RADIUS);
+    }
+
+    if (input.toggleRoute)
+    {
+        toggleNpcRoutes(world);
+    }
+
+    // Door, wherever the house puts it
+    world.transforms.update();
+    uint32_t door = world.sceneNodes.door;
+    if (input.useDoor && isNear(position, doorThresholdPosition(world.transforms, world.sceneNodes), DOOR_USE_RADIUS))
+    {
+        world.isInHouse = !world.isInHouse;
+        if (world.isInHouse)
+        {
+            teleportPlayer(world, glm::vec3(0.0f, -0.4f, 0.0f));
+        }
+        else
+        {
+            teleportPlayer(world, world.transforms.worldPoint(door, doorExit));
+        }
+    }
+
+    updateNpcs(world.npcs, world.npcRoutes, world.npcSplines, deltaTime, world.jobs);
+}
+
+// World Hash
+static uint64_t hashBytes(uint64_t hash, const void* data, size_t size)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+template <typename T>
+static uint64_t hashColumn(uint64_t hash, const std::vector<T>& column)
+{
+    uint64_t count = column.size();
+    hash = hashBytes(hash, &count, sizeof(count));
+    return column.empty() ? hash : hashBytes(hash, column.data(), column.size() * sizeof(T));
+}
+
+static uint64_t hashStore(uint64_t hash, const EntityStore& store)
+{
+    hash = hashColumn(hash, store.position);
+    hash = hashColumn(hash, store.velocity);
+    hash = hashColumn(hash, store.waypointTo);
+    return hashColumn(hash, store.ids);
+}
+
+uint64_t hashWorld(const World& world)
+{
+    uint64_t hash = 14695981039346656037ull;
+    hash = hashStore(hash, world.players);
+    hash = hashStore(hash, world.npcs);
+    hash = hashStore(hash, world.pickups);
+    unsigned char flags = (world.npcOnPath1 ? 1 : 0) | (world.isInHouse ? 2 : 0);
+    return hashBytes(hash, &flags, sizeof(flags));
+}
+
+void setNpcRoute(EntityStore& npcs, CrowdRoutes& routes, size_t index, const glm::vec3& from, const glm::vec3& to, float speed)
+{
+    const glm::vec3 waypoints[] = { from, to };
+    assignRoute(npcs, index, routes, routes.add(waypoints, 2, speed));
+}
+
+void toggleNpcRoutes(World& world)
+{
+    world.npcOnPath1 = !world.npcOnPath1;
+    uint32_t route = world.npcOnPath1 ? PATROL_ROUTE_1 : PATROL_ROUTE_2;
+    for (size_t i = 0; i < world.npcs.size(); ++i)
+    {
+        if (world.npcs.spline[i] == NO_SPLINE)
+        {
+            assignRoute(world.npcs, i, world.npcRoutes, route);
+        }
+    }
+}
+
+// NPCs per job, small enough to spread a few thousand NPCs over the workers
+// and a multiple of the SIMD width
+static const size_t NPC_CHUNK = 1024;
+
+// NPC Movement, see updateCrowd and updateSplineFollowers
+void updateNpcs(EntityStore& npcs, const CrowdRoutes& routes, const std::vector<SplinePath>& splines, float deltaTime,
+    JobSystem* jobs)
+{
+    PROFILE_SCOPE("updateNpcs");
+
+    auto update = [&npcs, &routes, &splines, deltaTime](size_t begin, size_t end)
+    {
+        updateCrowd(npcs, routes, begin, end, deltaTime);
+        if (!splines.empty())
+        {
+            updateSplineFollowers(npcs, splines, begin, end, deltaTime);
+        }
+    };
+    if (!jobs)
+    {
+        update(0, npcs.size());
+        return;
+    }
+    jobs->parallelFor(npcs.size(), NPC_CHUNK, update);
+}
+
+// Ground left of the house that spline NPCs are fitted onto
+const glm::vec2 splineAreaMin = glm::vec2(-1.8f, -1.8f);
+const glm::vec2 splineAreaMax = glm::vec2(0.6f, 2.8f);
+
+bool addSplineNpc(World& world, std::vector<glm::vec3> points)
+{
+    placeOnGround(points, splineAreaMin, splineAreaMax, npcPosition1.y);
+    SplinePath path;
+    if (!path.build(points, false, npcSpeed))
+    {
+        return false;
+    }
+    world.npcSplines.push_back(path);
+
+    size_t index = world.npcs.indexOf(world.npcs.create(path.positionAt(0.0f), 0.1f, NPC_COLOR, MESH_NPC));
+    assignSpline(world.npcs, index, world.npcSplines, static_cast<uint32_t>(world.npcSplines.size() - 1));
+    return true;
+}
+
+void scatterPickups(EntityStore& pickups, SpatialHash& index, size_t count, const glm::vec3& min, const glm::vec3& max, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> x(min.x, max.x);
+    std::uniform_real_distribution<float> y(min.y, max.y);
+    std::uniform_real_distribution<float> z(min.z, max.z);
+
+    pickups.reserve(pickups.size() + count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        glm::vec3 position;
+        position.x = x(rng);
+        position.y = y(rng);
+        position.z = z(rng);
+        index.insert(pickups.create(position, 1.0f, PICKUP_COLOR, MESH_SPHERE), position);
+    }
+}
+
+size_t collectPickups(EntityStore& pickups, SpatialHash& index, const glm::vec3& center, float radius)
+{
+    std::vector<EntityId> nearby;
+    index.query(center, radius, nearby);
+
+    for (EntityId id : nearby)
+    {
+        index.remove(id);
+        pickups.destroy(id);
+    }
+    return nearby.size();
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "EntityStore.h"
+#include "SpatialHash.h"
+#include "Crowd.h"
+#include "NavGraph.h"
+#include "SplinePath.h"
+#include "TransformGraph.h"
+
+class JobSystem;
+class SceneFile;
+
+// Mesh Ids
+enum MeshId : uint32_t
+{
+    MESH_PLANE,
+    MESH_HOUSE,
+    MESH_DOOR,
+    MESH_PLAYER,
+    MESH_NPC,
+    MESH_SPHERE,
+    MESH_INTERIOR,
+    MESH_COUNT
+};
+
+// Entity Colors
+const glm::vec4 PLAYER_COLOR = glm::vec4(0.5f, 0.0f, 0.5f, 1.0f); // RGBA purple
+const glm::vec4 NPC_COLOR = glm::vec4(1.0f, 0.5f, 0.0f, 1.0f); // RGBA orange
+const glm::vec4 PICKUP_COLOR = glm::vec4(1.0f, 0.843f, 0.0f, 1.0f); // RGBA gold
+
+// Simulation Input
+// Everything a simulation tick needs from the keyboard
+struct InputState
+{
+    float moveX = 0.0f; // -1 left, 1 right
+    float moveZ = 0.0f; // -1 forward, 1 back
+    bool sprint = false;
+    bool collect = false;
+    bool toggleRoute = false; // Only set on the tick the key went down
+    bool useDoor = false;
+};
+
+// Scene Nodes
+// The static scene in World::transforms: the ground with the plane mesh and the
+// house under it, the door under the house, and the interior on its own
+struct SceneNodes
+{
+    uint32_t ground = TRANSFORM_NO_PARENT;
+    uint32_t plane = TRANSFORM_NO_PARENT;
+    uint32_t house = TRANSFORM_NO_PARENT;
+    uint32_t door = TRANSFORM_NO_PARENT;
+    uint32_t interior = TRANSFORM_NO_PARENT;
+};
+
+// Pickup Collection Radius, also the cell size of the pickup index
+const float COLLECT_RADIUS = 0.3f;
+
+// World State
+struct World
+{
+    EntityStore players;
+    EntityStore npcs;
+    EntityStore pickups;
+    CrowdRoutes npcRoutes;
+    NavGraph navGraph; // Walkable ground, NPC patrols follow paths through it
+    std::vector<SplinePath> npcSplines;
+    SpatialHash pickupIndex = SpatialHash(COLLECT_RADIUS);
+    TransformGraph transforms; // The door check and the navigation grid read the house and door from here
+    SceneNodes sceneNodes;
+    EntityId player = INVALID_ENTITY;
+    bool npcOnPath1 = true;
+    bool isInHouse = false;
+
+    // Splits per-entity updates into jobs when set; every entity is updated on its own, so results don't change
+    JobSystem* jobs = nullptr;
+};
+
+inline bool isNear(glm::vec3 point1, glm::vec3 point2, float distanceThreshold)
+{
+    glm::vec3 offset = point1 - point2;
+    float distanceSquared = glm::dot(offset, offset);
+    return distanceSquared <= (distanceThreshold * distanceThreshold);
+}
+
+// Spawns the player, the NPC and the starting pickups
+void initWorld(World& world);
+
+// Replaces the player, the NPCs or the pickups with the scene's placements, for
+// each kind the scene has any of. NPCs patrol between their position and target
+// until the routes are toggled.
+void loadSceneEntities(World& world, const SceneFile& scene);
+
+glm::vec3& playerPosition(World& world);
+
+// Where the door is used from, inside or out, as of the transforms' last update
+glm::vec3 doorThresholdPosition(const TransformGraph& transforms, const SceneNodes& nodes);
+const float DOOR_USE_RADIUS = 0.3f;
+
+// Advances the whole simulation by one fixed tick
+void tickWorld(World& world, const InputState& input, float deltaTime);
+
+// FNV-1a hash of the simulation state, used to check that refactors stay deterministic
+uint64_t hashWorld(const World& world);
+
+// NPC Movement
+// setNpcRoute adds a route patrolling between from and to and puts the NPC on it
+void setNpcRoute(EntityStore& npcs, CrowdRoutes& routes, size_t index, const glm::vec3& from, const glm::vec3& to, float speed);
+void toggleNpcRoutes(World& world);
+void updateNpcs(EntityStore& npcs, const CrowdRoutes& routes, const std::vector<SplinePath>& splines, float deltaTime,
+    JobSystem* jobs = nullptr);
+
+// Adds an NPC that walks a spline through points there and back, fitted onto
+// the open ground left of the house. NPCs on splines keep to them when the
+// routes are toggled. Returns false if the points don't make a curve.
+bool addSplineNpc(World& world, std::vector<glm::vec3> points);
+
+// Adds count pickups at uniformly random positions inside [min, max] and indexes them
+void scatterPickups(EntityStore& pickups, SpatialHash& index, size_t count, const glm::vec3& min, const glm::vec3& max, uint32_t seed);
+
+// Removes every pickup near center, returns how many were collected
+size_t collectPickups(EntityStore& pickups, SpatialHash& index, const glm::vec3& center, float radius);
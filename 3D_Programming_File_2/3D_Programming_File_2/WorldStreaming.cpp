@@ -0,0 +1,275 @@
+#include "WorldStreaming.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <limits>
+
+const char* cellName(CellId cell)
+{
+    switch (cell)
+    {
+    case CELL_EXTERIOR: return "exterior";
+    case CELL_HOUSE: return "house";
+    default: return "unknown";
+    }
+}
+
+// Builds and prepares every mesh of a cell, on whichever thread calls it
+static std::vector<PreparedMesh> prepareCell(const CellManifest& manifest, bool optimize)
+{
+    std::vector<PreparedMesh> prepared;
+    prepared.reserve(manifest.meshes.size());
+    for (const CellMeshSource& source : manifest.meshes)
+    {
+        prepared.push_back(prepareMesh(source.build(), source.format, optimize, source.sectionEnds));
+    }
+    return prepared;
+}
+
+CellStreamer::~CellStreamer()
+{
+    for (Cell& cell : cells)
+    {
+        if (cell.load.valid())
+        {
+            cell.load.wait();
+        }
+    }
+}
+
+void CellStreamer::setManifest(CellId cell, const CellManifest& manifest)
+{
+    cells[cell].manifest = manifest;
+}
+
+size_t CellStreamer::addPortal(const CellPortal& portal)
+{
+    portals.push_back(portal);
+    return portals.size() - 1;
+}
+
+void CellStreamer::loadNow(MeshRegistry& registry, CellId cell)
+{
+    Cell& target = cells[cell];
+    target.lastUsed = frame;
+    if (target.state == CELL_RESIDENT)
+    {
+        return;
+    }
+
+    if (target.state == CELL_UNLOADED)
+    {
+        target.loadTimer = BenchmarkTimer();
+        target.prepared = prepareCell(target.manifest, registry.optimizeMeshes);
+        target.state = CELL_UPLOADING;
+    }
+    else if (target.state == CELL_LOADING)
+    {
+        target.prepared = target.load.get();
+        target.state = CELL_UPLOADING;
+    }
+
+    if (target.prepared.empty())
+    {
+        finish(registry, cell);
+    }
+    size_t unlimited = std::numeric_limits<size_t>::max();
+    while (target.state == CELL_UPLOADING)
+    {
+        uploadNext(registry, cell, unlimited);
+    }
+}
+
+void CellStreamer::update(MeshRegistry& registry, CellId displayed, CellId wanted, const glm::vec3& player)
+{
+    ++frame;
+
+    // Cells in use this frame: never evicted, loaded if they are not yet
+    bool pinned[CELL_COUNT] = {};
+    pinned[displayed] = true;
+    pinned[wanted] = true;
+    for (const CellPortal& portal : portals)
+    {
+        if (portal.from == wanted && isNear(player, portal.position, portal.prefetchRadius))
+        {
+            pinned[portal.to] = true;
+        }
+    }
+    for (uint32_t cell = 0; cell < CELL_COUNT; ++cell)
+    {
+        if (pinned[cell])
+        {
+            cells[cell].lastUsed = frame;
+            if (cells[cell].state == CELL_UNLOADED)
+            {
+                request(static_cast<CellId>(cell), registry.optimizeMeshes);
+            }
+        }
+    }
+
+    // Finished loads
+    for (uint32_t cell = 0; cell < CELL_COUNT; ++cell)
+    {
+        Cell& loading = cells[cell];
+        if (loading.state == CELL_LOADING && loading.load.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+        {
+            loading.prepared = loading.load.get();
+            loading.state = CELL_UPLOADING;
+            if (loading.prepared.empty())
+            {
+                finish(registry, static_cast<CellId>(cell));
+            }
+        }
+    }
+
+    // Uploads, the wanted cell first, shared byte limit for the frame
+    size_t bytesLeft = uploadBytesPerFrame;
+    CellId order[CELL_COUNT];
+    order[0] = wanted;
+    for (uint32_t cell = 0, next = 1; cell < CELL_COUNT; ++cell)
+    {
+        if (cell != wanted)
+        {
+            order[next++] = static_cast<CellId>(cell);
+        }
+    }
+    for (CellId cell : order)
+    {
+        while (cells[cell].state == CELL_UPLOADING)
+        {
+            if (!uploadNext(registry, cell, bytesLeft))
+            {
+                break;
+            }
+        }
+    }
+
+    // Eviction, least recently used first
+    while (registry.residentBytes() > budgetBytes)
+    {
+        CellId oldest = CELL_COUNT;
+        for (uint32_t cell = 0; cell < CELL_COUNT; ++cell)
+        {
+            if (!pinned[cell] && cells[cell].state == CELL_RESIDENT && (oldest == CELL_COUNT || cells[cell].lastUsed < cells[oldest].lastUsed))
+            {
+                oldest = static_cast<CellId>(cell);
+            }
+        }
+        if (oldest == CELL_COUNT)
+        {
+            break;
+        }
+        evict(registry, oldest);
+    }
+}
+
+void CellStreamer::resolve(CellId cell, MeshHandle meshes[MESH_COUNT]) const
+{
+    const Cell& source = cells[cell];
+    if (source.state != CELL_RESIDENT)
+    {
+        return;
+    }
+
+    const CellManifest& manifest = source.manifest;
+    for (size_t i = 0; i < manifest.meshes.size(); ++i)
+    {
+        if (manifest.meshes[i].slot != MESH_COUNT)
+        {
+            meshes[manifest.meshes[i].slot] = source.handles[i];
+        }
+    }
+    for (size_t i = 0; i < manifest.submeshes.size(); ++i)
+    {
+        meshes[manifest.submeshes[i].slot] = source.handles[manifest.meshes.size() + i];
+    }
+}
+
+void CellStreamer::unloadAll(MeshRegistry& registry)
+{
+    for (uint32_t cell = 0; cell < CELL_COUNT; ++cell)
+    {
+        if (cells[cell].load.valid())
+        {
+            cells[cell].load.wait();
+        }
+        evict(registry, static_cast<CellId>(cell));
+    }
+}
+
+// The meshes are prepared on a loader thread from a copy of the manifest
+void CellStreamer::request(CellId cell, bool optimize)
+{
+    Cell& target = cells[cell];
+    target.state = CELL_LOADING;
+    target.loadTimer = BenchmarkTimer();
+    target.load = std::async(std::launch::async, [manifest = target.manifest, optimize]()
+    {
+        return prepareCell(manifest, optimize);
+    });
+    std::cout << "[streaming] loading " << cellName(cell) << " cell" << std::endl;
+}
+
+// Uploads the cell's next mesh; returns false once this frame's bytes are spent,
+// but the first mesh of a frame always goes so large meshes still get through
+bool CellStreamer::uploadNext(MeshRegistry& registry, CellId cell, size_t& bytesLeft)
+{
+    Cell& target = cells[cell];
+    const PreparedMesh& mesh = target.prepared[target.handles.size()];
+    size_t size = mesh.byteSize();
+    if (size > bytesLeft && bytesLeft < uploadBytesPerFrame)
+    {
+        return false;
+    }
+
+    target.handles.push_back(registry.add(mesh));
+    target.bytes += size;
+    bytesLeft -= std::min(size, bytesLeft);
+    if (target.handles.size() == target.prepared.size())
+    {
+        finish(registry, cell);
+    }
+    return true;
+}
+
+// Submeshes last, they only slice meshes that are already uploaded
+void CellStreamer::finish(MeshRegistry& registry, CellId cell)
+{
+    Cell& target = cells[cell];
+    for (const CellSubmesh& submesh : target.manifest.submeshes)
+    {
+        target.handles.push_back(registry.addSubmesh(target.handles[submesh.parent], submesh.firstIndex, submesh.indexCount));
+    }
+    target.prepared.clear();
+    target.state = CELL_RESIDENT;
+    std::cout << "[streaming] " << cellName(cell) << " cell resident, " << target.manifest.meshes.size() << " meshes, "
+              << target.bytes << " bytes, " << target.loadTimer.elapsedMs() << " ms after the request, "
+              << registry.residentBytes() << " bytes resident" << std::endl;
+}
+
+// Also drops a partial upload; submeshes come after their parents, so they go first
+void CellStreamer::evict(MeshRegistry& registry, CellId cell)
+{
+    Cell& target = cells[cell];
+    if (target.state == CELL_UNLOADED)
+    {
+        return;
+    }
+
+    for (size_t i = target.handles.size(); i-- > 0;)
+    {
+        registry.remove(target.handles[i]);
+    }
+    bool wasResident = target.state == CELL_RESIDENT;
+    size_t bytes = target.bytes;
+    target.handles.clear();
+    target.prepared.clear();
+    target.load = std::future<std::vector<PreparedMesh>>();
+    target.bytes = 0;
+    target.state = CELL_UNLOADED;
+    if (wasResident)
+    {
+        std::cout << "[streaming] evicted " << cellName(cell) << " cell, " << bytes << " bytes, "
+                  << registry.residentBytes() << " bytes resident" << std::endl;
+    }
+}
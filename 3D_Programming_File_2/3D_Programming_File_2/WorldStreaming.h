@@ -0,0 +1,129 @@
+#pragma once
+
+#include <glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <vector>
+#include "Benchmark.h"
+#include "MeshRegistry.h"
+#include "World.h"
+
+// World Cells
+// Parts of the world that are loaded and evicted as a whole
+enum CellId : uint32_t
+{
+    CELL_EXTERIOR,
+    CELL_HOUSE,
+    CELL_COUNT
+};
+
+const char* cellName(CellId cell);
+
+// Cell Mesh Source
+// A mesh a cell owns. build runs on a loader thread, so it must not touch GL or
+// anything the main thread writes. slot is MESH_COUNT for meshes that are only
+// drawn through submeshes.
+struct CellMeshSource
+{
+    MeshId slot = MESH_COUNT;
+    MeshData (*build)() = nullptr;
+    VertexFormat format = VERTEX_FLOAT3;
+    std::vector<size_t> sectionEnds;
+};
+
+// A slice of one of the cell's meshes, parent indexes CellManifest::meshes
+struct CellSubmesh
+{
+    MeshId slot = MESH_COUNT;
+    size_t parent = 0;
+    size_t firstIndex = 0;
+    size_t indexCount = 0;
+};
+
+// Cell Manifest, everything a cell needs resident before it is drawn
+struct CellManifest
+{
+    std::vector<CellMeshSource> meshes;
+    std::vector<CellSubmesh> submeshes;
+};
+
+// Cell Portal
+// A door from one cell into another. While the player is in the from cell and
+// within prefetchRadius of the portal, the cell behind it is loaded too.
+struct CellPortal
+{
+    CellId from = CELL_EXTERIOR;
+    CellId to = CELL_EXTERIOR;
+    glm::vec3 position = glm::vec3(0.0f);
+    float prefetchRadius = 1.0f;
+};
+
+// Cell Streamer
+// Keeps the meshes of the cells in use in a MeshRegistry. A cell is prepared on a
+// std::async thread (built, optimized and quantized), then uploaded on the GL
+// thread a few meshes per frame, so neither step stalls a frame. Cells that are
+// neither wanted nor behind a nearby portal are evicted least recently used
+// first while the registry holds more than budgetBytes; freed arena ranges are
+// reused by later uploads.
+class CellStreamer
+{
+public:
+    // Waits for loads in flight; call unloadAll first to free the meshes
+    ~CellStreamer();
+
+    void setManifest(CellId cell, const CellManifest& manifest);
+    size_t addPortal(const CellPortal& portal);
+    void setPortalPosition(size_t portal, const glm::vec3& position) { portals[portal].position = position; }
+
+    // Registry bytes above which unused cells are evicted
+    size_t budgetBytes = 64 * 1024 * 1024;
+
+    // Upload limit per frame, at least one mesh is uploaded every frame
+    size_t uploadBytesPerFrame = 256 * 1024;
+
+    // Loads and uploads a cell on the calling thread, e.g. the one the game starts in
+    void loadNow(MeshRegistry& registry, CellId cell);
+
+    // Once per frame on the GL thread: requests the wanted cell and the cells behind
+    // nearby portals, uploads finished loads and evicts over the budget. displayed
+    // is kept resident until the caller switches to wanted.
+    void update(MeshRegistry& registry, CellId displayed, CellId wanted, const glm::vec3& player);
+
+    bool isResident(CellId cell) const { return cells[cell].state == CELL_RESIDENT; }
+
+    // Writes the handles of the slots a resident cell owns, other slots are left alone
+    void resolve(CellId cell, MeshHandle meshes[MESH_COUNT]) const;
+
+    void unloadAll(MeshRegistry& registry);
+
+private:
+    enum CellState
+    {
+        CELL_UNLOADED,
+        CELL_LOADING,
+        CELL_UPLOADING,
+        CELL_RESIDENT
+    };
+
+    struct Cell
+    {
+        CellManifest manifest;
+        CellState state = CELL_UNLOADED;
+        std::future<std::vector<PreparedMesh>> load;
+        std::vector<PreparedMesh> prepared;
+        std::vector<MeshHandle> handles; // Per manifest mesh, then per submesh
+        size_t bytes = 0;
+        uint64_t lastUsed = 0;
+        BenchmarkTimer loadTimer;
+    };
+
+    Cell cells[CELL_COUNT];
+    std::vector<CellPortal> portals;
+    uint64_t frame = 0;
+
+    void request(CellId cell, bool optimize);
+    bool uploadNext(MeshRegistry& registry, CellId cell, size_t& bytesLeft);
+    void finish(MeshRegistry& registry, CellId cell);
+    void evict(MeshRegistry& registry, CellId cell);
+};
@@ -0,0 +1,330 @@
+// Headless Simulation Runner
+// Runs the game simulation without a window or GL context, so it builds and
+// runs on machines with no display:
+//
+//   headless [--replay <file>] [--ticks <n>] [--tick-rate <hz>] [--scene <file>] [--pickups <count>] [--hashes <file>]
+//            [--workers <n>] [--spline <file>]
+//   headless --bench <name>
+//   headless --compile-scene <text file> <scene file>
+//   headless --check-curves <point file>
+//
+// The recorded input (see --record in the game) is looped if --ticks is longer
+// than the recording. --hashes writes "<tick> <hash>" for every tick so two
+// builds can be diffed for determinism. --workers runs the per-entity updates on
+// a job system with n workers (0 for one per hardware thread, minus the calling
+// thread, which joins in); the hashes must match a run without it. --spline adds
+// the game's spline NPC, which the game loads from ../interpolated_points.txt
+// unless told otherwise.
+// --check-curves fits a point file with the curve fitting engine and checks
+// that every fit prints the file back exactly (see checkCurves).
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <gtx/spline.hpp>
+#include "World.h"
+#include "JobSystem.h"
+#include "InputRecording.h"
+#include "Benchmark.h"
+#include "SceneFile.h"
+#include "PointTable.h"
+#include "CurveFit.h"
+#include "CommandLine.h"
+
+static std::string formatFixed(float value, int decimals)
+{
+    char text[64];
+    std::snprintf(text, sizeof(text), "%.*f", decimals, value);
+    return text;
+}
+
+// Rows of a fit that print as the file does, with the same decimals per value
+static size_t matchingRows(const std::vector<std::string>& rows, const std::vector<int>& decimalsX,
+    const std::vector<int>& decimalsY, const float* x, const std::vector<float>& y, float& maxError, const float* expected)
+{
+    size_t matches = 0;
+    maxError = 0.0f;
+    for (size_t i = 0; i < rows.size(); ++i)
+    {
+        matches += formatFixed(x[i], decimalsX[i]) + " " + formatFixed(y[i], decimalsY[i]) == rows[i] ? 1 : 0;
+        maxError = std::max(maxError, std::fabs(y[i] - expected[i]));
+    }
+    return matches;
+}
+
+// Curve Check
+// Fits the "x y" samples of a point file three ways: a least squares cubic
+// over every sample, a not-a-knot cubic spline through every fifth sample and
+// the last, and Hermite segments through the same knots with the spline's
+// slopes. Each fit is evaluated in batch at every sample and printed with the
+// file's decimals; samples of a cubic, like interpolated_points.txt, come
+// back exactly. Catmull-Rom Hermite segments are also compared with
+// glm::catmullRom wherever four knots are evenly spaced.
+static bool checkCurves(const std::string& path)
+{
+    PointTable table;
+    if (!readPointFile(path, table))
+    {
+        return false;
+    }
+    if (table.columnCount != 2)
+    {
+        std::cerr << path << ": expected \"x y\" rows" << std::endl;
+        return false;
+    }
+
+    // The text of each row, and how many decimals each value was written with
+    std::ifstream file(path);
+    std::vector<std::string> rows;
+    std::vector<int> decimalsX;
+    std::vector<int> decimalsY;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        std::istringstream stream(line);
+        std::string x;
+        std::string y;
+        if (!(stream >> x >> y))
+        {
+            continue;
+        }
+        rows.push_back(x + " " + y);
+        size_t dotX = x.find('.');
+        size_t dotY = y.find('.');
+        decimalsX.push_back(dotX == std::string::npos ? 0 : static_cast<int>(x.size() - dotX - 1));
+        decimalsY.push_back(dotY == std::string::npos ? 0 : static_cast<int>(y.size() - dotY - 1));
+    }
+
+    size_t count = table.rowCount;
+    const float* x = table.column(0);
+    const float* y = table.column(1);
+    std::vector<float> knotX;
+    std::vector<float> knotY;
+    for (size_t i = 0; i < count; i += 5)
+    {
+        knotX.push_back(x[i]);
+        knotY.push_back(y[i]);
+    }
+    if (knotX.back() != x[count - 1])
+    {
+        knotX.push_back(x[count - 1]);
+        knotY.push_back(y[count - 1]);
+    }
+
+    Polynomial polynomial;
+    CubicCurve spline;
+    CubicCurve hermite;
+    if (!fitPolynomial(x, y, count, 3, polynomial) || !fitCubicSpline(knotX.data(), knotY.data(), knotX.size(), spline))
+    {
+        std::cerr << path << ": too few samples or x not increasing" << std::endl;
+        return false;
+    }
+    std::vector<float> slopes(knotX.size());
+    for (size_t i = 0; i < knotX.size(); ++i)
+    {
+        slopes[i] = spline.slope(knotX[i]);
+    }
+    fitHermite(knotX.data(), knotY.data(), slopes.data(), knotX.size(), hermite);
+
+    std::vector<float> fitted(count);
+    float maxError;
+    bool exact = true;
+    auto report = [&](const char* name)
+    {
+        size_t matches = matchingRows(rows, decimalsX, decimalsY, x, fitted, maxError, y);
+        exact = exact && matches == rows.size();
+        std::cout << std::setw(14) << std::left << name << std::right << matches << "/" << rows.size()
+                  << " rows match, max error " << std::scientific << std::setprecision(2) << maxError << std::endl;
+    };
+    polynomial.evaluate(x, fitted.data(), count);
+    report("polynomial");
+    spline.evaluate(x, fitted.data(), count);
+    report("cubic spline");
+    hermite.evaluate(x, fitted.data(), count);
+    report("hermite");
+
+    // Catmull-Rom through the knots against glm's
+    CubicCurve catmullRom;
+    fitHermite(knotX.data(), knotY.data(), nullptr, knotX.size(), catmullRom);
+    float glmError = 0.0f;
+    for (size_t i = 1; i + 2 < knotX.size(); ++i)
+    {
+        float h = knotX[i + 1] - knotX[i];
+        if (std::fabs(knotX[i] - knotX[i - 1] - h) > 1e-5f || std::fabs(knotX[i + 2] - knotX[i + 1] - h) > 1e-5f)
+        {
+            continue;
+        }
+        for (int step = 0; step <= 8; ++step)
+        {
+            float s = step / 8.0f;
+            glm::vec2 point = glm::catmullRom(glm::vec2(knotX[i - 1], knotY[i - 1]), glm::vec2(knotX[i], knotY[i]),
+                glm::vec2(knotX[i + 1], knotY[i + 1]), glm::vec2(knotX[i + 2], knotY[i + 2]), s);
+            glmError = std::max(glmError, std::fabs(catmullRom.evaluate(knotX[i] + s * h) - point.y));
+        }
+    }
+    bool matchesGlm = glmError < 1e-4f;
+    std::cout << "catmull-rom   " << (matchesGlm ? "matches" : "differs from") << " glm::catmullRom, max error " << glmError << std::endl;
+    return exact && matchesGlm;
+}
+
+int main(int argc, char* argv[])
+{
+    std::string replayPath;
+    std::string hashPath;
+    std::string splinePath;
+    std::string scenePath;
+    size_t tickCount = 0;
+    size_t pickupCount = 0;
+    double tickRate = 0.0;
+    size_t workerCount = 0;
+    bool useJobs = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if (argument == "--bench" && i + 1 < argc)
+        {
+            return runBenchmark(argv[++i]) ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+        else if (argument == "--compile-scene" && i + 2 < argc)
+        {
+            return compileSceneText(argv[i + 1], argv[i + 2]) ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+        else if (argument == "--check-curves" && i + 1 < argc)
+        {
+            return checkCurves(argv[i + 1]) ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+        else if (argument == "--scene" && i + 1 < argc)
+        {
+            scenePath = argv[++i];
+        }
+        else if (argument == "--replay" && i + 1 < argc)
+        {
+            replayPath = argv[++i];
+        }
+        else if (argument == "--ticks" && i + 1 < argc)
+        {
+            if (!parseCountArgument("--ticks", argv[++i], tickCount))
+            {
+                return EXIT_FAILURE;
+            }
+        }
+        else if (argument == "--tick-rate" && i + 1 < argc)
+        {
+            if (!parsePositiveArgument("--tick-rate", argv[++i], tickRate))
+            {
+                return EXIT_FAILURE;
+            }
+        }
+        else if (argument == "--pickups" && i + 1 < argc)
+        {
+            if (!parseCountArgument("--pickups", argv[++i], pickupCount))
+            {
+                return EXIT_FAILURE;
+            }
+        }
+        else if (argument == "--hashes" && i + 1 < argc)
+        {
+            hashPath = argv[++i];
+        }
+        else if (argument == "--spline" && i + 1 < argc)
+        {
+            splinePath = argv[++i];
+        }
+        else if (argument == "--workers" && i + 1 < argc)
+        {
+            if (!parseCountArgument("--workers", argv[++i], workerCount))
+            {
+                return EXIT_FAILURE;
+            }
+            useJobs = true;
+        }
+        else
+        {
+            std::cerr << "Unknown argument: " << argument << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Input
+    InputRecording recording;
+    if (!replayPath.empty() && !recording.load(replayPath))
+    {
+        return EXIT_FAILURE;
+    }
+    if (recording.ticks.empty())
+    {
+        recording.ticks.push_back(InputState());
+    }
+    if (tickRate <= 0.0)
+    {
+        tickRate = recording.tickRate;
+    }
+    if (tickCount == 0)
+    {
+        tickCount = replayPath.empty() ? 100000 : recording.ticks.size();
+    }
+
+    // World, set up the same way as the game
+    World world;
+    initWorld(world);
+    SceneFile scene;
+    if (!scenePath.empty())
+    {
+        if (!scene.open(scenePath))
+        {
+            return EXIT_FAILURE;
+        }
+        loadSceneEntities(world, scene);
+    }
+    std::vector<glm::vec3> splinePoints;
+    if (!splinePath.empty() && (!loadSplinePoints(splinePath, splinePoints) || !addSplineNpc(world, splinePoints)))
+    {
+        return EXIT_FAILURE;
+    }
+    scatterPickups(world.pickups, world.pickupIndex, pickupCount, glm::vec3(-2.0f, -0.4f, -2.0f), glm::vec3(2.0f, -0.4f, 3.0f), 42);
+
+    std::unique_ptr<JobSystem> jobs;
+    if (useJobs)
+    {
+        jobs.reset(new JobSystem(workerCount));
+        jobs->registerThread();
+        world.jobs = jobs.get();
+    }
+
+    std::ofstream hashFile;
+    if (!hashPath.empty())
+    {
+        hashFile.open(hashPath);
+        if (!hashFile)
+        {
+            std::cerr << "Failed to write hashes: " << hashPath << std::endl;
+            return EXIT_FAILURE;
+        }
+        hashFile << std::hex << std::setfill('0');
+    }
+
+    // Simulation
+    float deltaTime = static_cast<float>(1.0 / tickRate);
+    BenchmarkTimer timer;
+    for (size_t tick = 0; tick < tickCount; ++tick)
+    {
+        tickWorld(world, recording.ticks[tick % recording.ticks.size()], deltaTime);
+        if (hashFile.is_open())
+        {
+            hashFile << std::dec << tick << ' ' << std::hex << std::setw(16) << hashWorld(world) << '\n';
+        }
+    }
+    double elapsedMs = timer.elapsedMs();
+
+    std::cout << tickCount << " ticks in " << elapsedMs << " ms, "
+              << std::fixed << std::setprecision(0) << tickCount / (elapsedMs / 1000.0) << " ticks/sec" << std::endl;
+    std::cout << "final hash " << std::hex << std::setw(16) << std::setfill('0') << hashWorld(world) << std::endl;
+    return EXIT_SUCCESS;
+}